@@ -46,6 +46,24 @@ public sealed class FrameProtocol : IFrameProtocol, IAsyncDisposable
     // ReSharper disable once InconsistentNaming
     private static readonly byte[] Magic = [0x19, 0x16];
 
+    // Answer to the panel's hello, laid out as hello_t in the panel's framer.hpp. The bridge sends one frame at a
+    // time in the magic framing and takes any frame whole, so the panel neither asks it for a window nor sends it
+    // fragments.
+    private static readonly byte[] HelloReply =
+    [
+        1,              // version
+        0x01,           // reply
+        0xFF, 0xFF,     // largest frame sent
+        0xFF, 0xFF,     // largest frame taken whole
+        0x00, 0x00,     // receive buffer, not bounded
+        1,              // window
+        0x00, 0x00,     // no fragmented messages
+        0x01,           // framings: magic
+        0x00,           // compressions: none
+        0x03,           // pixel formats: rgb565a8 icons, a8 title sprites
+        0x00, 0x10      // features: ping
+    ];
+
     private readonly IFrameTransport _transport;
     private readonly ILogger<FrameProtocol> _logger;
     private readonly Framer _framer;
@@ -163,6 +181,14 @@ public sealed class FrameProtocol : IFrameProtocol, IAsyncDisposable
                 case FrameType.Data:
                     await ProcessDataFrameAsync(frame, cancellationToken);
                     break;
+                case FrameType.Ping:
+                    // keepalive from the panel, it counts the link as down when these go unanswered
+                    await SendFrameAsync(new Frame(frame.Sequence, FrameType.Pong, frame.Data), cancellationToken);
+                    break;
+                case FrameType.Hello:
+                    if (frame.Data.Length > 1 && (frame.Data[1] & 0x01) == 0)
+                        await SendFrameAsync(new Frame(0, FrameType.Hello, HelloReply), cancellationToken);
+                    break;
                 default:
                     _logger.LogError("Unknown frame type {FrameType}", frame.Type);
                     break;
@@ -8,7 +8,10 @@ public enum FrameType : byte
 {
     Undefined = 0xFF,
     Data = 0,
-    ACK = 1
+    ACK = 1,
+    Ping = 2,
+    Pong = 3,
+    Hello = 11
 }
 
 public class Frame(ushort sequence = 0, FrameType type = FrameType.Undefined, byte[]? data = null)
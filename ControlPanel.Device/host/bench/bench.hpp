@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bench
+{
+    template<typename T>
+    inline void do_not_optimize(T&& value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    inline void clobber_memory()
+    {
+        asm volatile("" : : : "memory");
+    }
+
+    struct result_t
+    {
+        std::string name;
+        double ns_per_op;
+        uint64_t iterations;
+        double bytes_per_op;
+        double items_per_op;
+    };
+
+    struct options_t
+    {
+        std::chrono::milliseconds min_time{200};
+        int samples = 5;
+        std::string_view filter{};
+    };
+
+    inline options_t& options()
+    {
+        static options_t instance;
+        return instance;
+    }
+
+    inline void print_header()
+    {
+        std::printf("%-48s %14s %12s %12s %14s\n", "benchmark", "ns/op", "iterations", "MB/s", "items/s");
+    }
+
+    inline void print(const result_t& r)
+    {
+        auto mb_s = r.bytes_per_op > 0 ? r.bytes_per_op / r.ns_per_op * 1e9 / (1024.0 * 1024.0) : 0.0;
+        auto items_s = r.items_per_op > 0 ? r.items_per_op / r.ns_per_op * 1e9 : 0.0;
+
+        std::printf("%-48s %14.1f %12llu", r.name.c_str(), r.ns_per_op, static_cast<unsigned long long>(r.iterations));
+
+        if (mb_s > 0) std::printf(" %12.2f", mb_s);
+        else std::printf(" %12s", "-");
+
+        if (items_s > 0) std::printf(" %14.0f\n", items_s);
+        else std::printf(" %14s\n", "-");
+    }
+
+    // Runs fn until a single sample takes at least options().min_time and reports the median sample.
+    // bytes_per_op/items_per_op describe the work of one fn() call and are only used for the throughput columns.
+    template<typename F>
+    inline void run(const std::string& name, F&& fn, double bytes_per_op = 0, double items_per_op = 0)
+    {
+        if (!options().filter.empty() && name.find(options().filter) == std::string::npos)
+            return;
+
+        using clock = std::chrono::steady_clock;
+
+        auto measure = [&](uint64_t iterations)
+        {
+            auto start = clock::now();
+            for (uint64_t i = 0; i < iterations; i++)
+            {
+                fn();
+                clobber_memory();
+            }
+            return std::chrono::duration<double, std::nano>(clock::now() - start).count();
+        };
+
+        const double min_ns = std::chrono::duration<double, std::nano>(options().min_time).count();
+
+        uint64_t iterations = 1;
+        auto elapsed = measure(iterations);
+        while (elapsed < min_ns && iterations < (1ull << 40))
+        {
+            auto scale = elapsed > 0 ? std::clamp(min_ns / elapsed * 1.2, 2.0, 100.0) : 100.0;
+            iterations = static_cast<uint64_t>(iterations * scale);
+            elapsed = measure(iterations);
+        }
+
+        std::vector<double> samples{elapsed / iterations};
+        for (int i = 1; i < options().samples; i++)
+            samples.emplace_back(measure(iterations) / iterations);
+
+        std::ranges::sort(samples);
+
+        print(result_t{
+            .name = name,
+            .ns_per_op = samples[samples.size() / 2],
+            .iterations = iterations,
+            .bytes_per_op = bytes_per_op,
+            .items_per_op = items_per_op
+        });
+    }
+
+    inline void parse_args(int argc, char** argv)
+    {
+        for (auto i = 1; i < argc; i++)
+        {
+            std::string_view arg = argv[i];
+
+            if (arg == "--filter" && i + 1 < argc)
+                options().filter = argv[++i];
+            else if (arg == "--min-time-ms" && i + 1 < argc)
+                options().min_time = std::chrono::milliseconds(std::stoi(argv[++i]));
+            else if (arg == "--samples" && i + 1 < argc)
+                options().samples = std::max(1, std::stoi(argv[++i]));
+            else
+                std::fprintf(stderr, "usage: %s [--filter substring] [--min-time-ms ms] [--samples n]\n", argv[0]);
+        }
+    }
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "protocol/protocol.hpp"
+
+// Bridge messages shaped like the ones the C# bridge sends: GUID-sized ids, A8 title sprites
+// rendered at the panel title height and 32x32 RGB565A8 icons.
+namespace bench::payloads
+{
+    inline constexpr int TITLE_WIDTH = 220;
+    inline constexpr int TITLE_HEIGHT = 18;
+    inline constexpr int ICON_SIZE = 32;
+
+    inline std::vector<uint8_t> random_bytes(std::size_t size, uint32_t seed = 1)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<int> byte(0, 255);
+
+        std::vector<uint8_t> ret(size);
+        for (auto& b: ret)
+            b = static_cast<uint8_t>(byte(rng));
+
+        return ret;
+    }
+
+    inline std::string stream_id(std::size_t index)
+    {
+        char buf[40];
+        std::snprintf(buf, sizeof(buf), "%08zx-0000-4000-8000-%012zx", index, index * 7919);
+        return buf;
+    }
+
+    inline std::string agent_id(std::size_t index = 0)
+    {
+        char buf[40];
+        std::snprintf(buf, sizeof(buf), "a9e0%04zx-5b1c-4f2e-9d61-0c7f3b2e8a41", index);
+        return buf;
+    }
+
+    inline std::vector<uint8_t> to_msgpack(const JsonDocument& doc)
+    {
+        std::string out;
+        serializeMsgPack(doc, out);
+        return {out.begin(), out.end()};
+    }
+
+    inline std::vector<uint8_t> streams_message(std::size_t updated, std::size_t deleted = 0, std::size_t first_index = 0,
+        int title_width = TITLE_WIDTH, int title_height = TITLE_HEIGHT)
+    {
+        JsonDocument doc;
+        doc["type"] = bridge_message_type_t::streams;
+
+        auto updated_array = doc["updated"].to<JsonArray>();
+        for (auto i = first_index; i < first_index + updated; i++)
+        {
+            auto sprite = random_bytes(title_width * title_height, static_cast<uint32_t>(i));
+
+            auto stream = updated_array.add<JsonObject>();
+            stream["id"]["id"] = stream_id(i);
+            stream["id"]["agent_id"] = agent_id();
+            stream["source"] = "/usr/lib/application-" + std::to_string(i) + "/bin/application";
+
+            auto name = stream["name"].to<JsonObject>();
+            name["name"] = "Application " + std::to_string(i);
+            name["sprite"] = MsgPackBinary(sprite.data(), sprite.size());
+            name["width"] = title_width;
+            name["height"] = title_height;
+
+            stream["mute"] = false;
+            stream["volume"] = 0.5f;
+        }
+
+        auto deleted_array = doc["deleted"].to<JsonArray>();
+        for (auto i = first_index + updated; i < first_index + updated + deleted; i++)
+        {
+            auto id = deleted_array.add<JsonObject>();
+            id["id"] = stream_id(i);
+            id["agent_id"] = agent_id();
+        }
+
+        return to_msgpack(doc);
+    }
+
+    inline std::vector<uint8_t> volume_update_message(std::size_t stream_index, float volume)
+    {
+        JsonDocument doc;
+        doc["type"] = bridge_message_type_t::streams;
+
+        auto stream = doc["updated"].to<JsonArray>().add<JsonObject>();
+        stream["id"]["id"] = stream_id(stream_index);
+        stream["id"]["agent_id"] = agent_id();
+        stream["source"] = "/usr/lib/application-" + std::to_string(stream_index) + "/bin/application";
+        stream["volume"] = volume;
+
+        doc["deleted"].to<JsonArray>();
+
+        return to_msgpack(doc);
+    }
+
+    inline std::vector<uint8_t> icon_message(std::size_t stream_index, int size = ICON_SIZE)
+    {
+        auto icon = random_bytes(size * size * 3, static_cast<uint32_t>(stream_index + 0x1C0));
+
+        JsonDocument doc;
+        doc["type"] = bridge_message_type_t::icon;
+        doc["source"] = "/usr/lib/application-" + std::to_string(stream_index) + "/bin/application";
+        doc["agent_id"] = agent_id();
+        doc["size"] = size;
+        doc["icon"] = MsgPackBinary(icon.data(), icon.size());
+
+        return to_msgpack(doc);
+    }
+}
@@ -0,0 +1,296 @@
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "esp_log.h"
+
+#include "protocol/crc16.hpp"
+#include "protocol/framer.hpp"
+#include "protocol/reed_solomon.hpp"
+#include "protocol/protocol.hpp"
+
+#include "bench.hpp"
+#include "payloads.hpp"
+
+namespace
+{
+    constexpr std::array<uint8_t, 2> MAGIC{0x19, 0x16};
+    constexpr std::size_t BUFFER_SIZE = 16 * 1024;
+    constexpr std::size_t STREAM_SIZE = 256 * 1024;
+
+    using framer_type = transport::framer_t<MAGIC, BUFFER_SIZE>;
+
+    struct frame_stream_t
+    {
+        std::vector<uint8_t> bytes;
+        std::size_t frames = 0;
+    };
+
+    frame_stream_t build_frame_stream(std::span<const std::size_t> payload_sizes)
+    {
+        auto framer = std::make_unique<framer_type>();
+        std::vector<uint8_t> frame_buffer(BUFFER_SIZE + 64);
+
+        frame_stream_t stream;
+        uint16_t seq = 0;
+
+        while (stream.bytes.size() < STREAM_SIZE)
+        {
+            for (auto size: payload_sizes)
+            {
+                auto payload = bench::payloads::random_bytes(size, seq);
+                transport::frame_t frame{++seq, transport::frame_type_t::data, payload};
+
+                auto n = framer->to_bytes(frame_buffer, frame);
+                stream.bytes.insert(stream.bytes.end(), frame_buffer.begin(), frame_buffer.begin() + n);
+                stream.frames++;
+            }
+        }
+
+        return stream;
+    }
+
+    std::size_t feed_stream(framer_type& framer, const frame_stream_t& stream, std::size_t chunk)
+    {
+        std::size_t delivered = 0;
+        std::span<const uint8_t> bytes{stream.bytes};
+
+        for (std::size_t offset = 0; offset < bytes.size(); offset += chunk)
+        {
+            framer.feed(bytes.subspan(offset, std::min(chunk, bytes.size() - offset)), [&](const transport::frame_t&)
+            {
+                delivered++;
+            });
+        }
+
+        return delivered;
+    }
+
+    void bench_framer_feed()
+    {
+        struct profile_t
+        {
+            const char* name;
+            std::vector<std::size_t> payload_sizes;
+        };
+
+        const profile_t profiles[] = {
+            { "ack", { 0 } },
+            { "control", { 48 } },
+            { "icon", { 3100 } },
+            { "streams", { 12000 } },
+            { "mixed", { 0, 48, 3100, 0, 48, 12000 } },
+        };
+
+        const std::size_t chunks[] = { 1, 16, 64, 256, 1024, 4096 };
+
+        for (const auto& profile: profiles)
+        {
+            auto stream = build_frame_stream(profile.payload_sizes);
+
+            for (auto chunk: chunks)
+            {
+                auto framer = std::make_unique<framer_type>();
+
+                if (auto delivered = feed_stream(*framer, stream, chunk); delivered != stream.frames)
+                    std::fprintf(stderr, "warning: %s/%zu delivered %zu of %zu frames\n", profile.name, chunk, delivered, stream.frames);
+
+                auto name = std::string("framer_feed/") + profile.name + "/chunk:" + std::to_string(chunk);
+                bench::run(name, [&]
+                {
+                    bench::do_not_optimize(feed_stream(*framer, stream, chunk));
+                }, static_cast<double>(stream.bytes.size()), static_cast<double>(stream.frames));
+            }
+        }
+    }
+
+    void bench_framer_to_bytes()
+    {
+        auto framer = std::make_unique<framer_type>();
+        std::vector<uint8_t> frame_buffer(BUFFER_SIZE + 64);
+
+        for (std::size_t size: { 0, 48, 247, 3100, 12000 })
+        {
+            auto payload = bench::payloads::random_bytes(size);
+            transport::frame_t frame{1, transport::frame_type_t::data, payload};
+
+            bench::run("framer_to_bytes/payload:" + std::to_string(size), [&]
+            {
+                bench::do_not_optimize(framer->to_bytes(frame_buffer, frame));
+            }, static_cast<double>(size), 1);
+
+            // the payload already sits in the tx slot, only the header and crc are written
+            std::ranges::copy(payload, frame_buffer.begin() + framer_type::DATA_OFFSET);
+            bench::run("framer_to_bytes_in_place/payload:" + std::to_string(size), [&]
+            {
+                bench::do_not_optimize(framer->to_bytes_in_place(frame_buffer, size, 1, transport::frame_type_t::data, {}).size());
+            }, static_cast<double>(size), 1);
+        }
+    }
+
+    void bench_find_sequence()
+    {
+        constexpr std::size_t SIZE = 4096;
+
+        auto no_first_byte = bench::payloads::random_bytes(SIZE);
+        for (auto& b: no_first_byte)
+            if (b == MAGIC[0]) b = 0;
+
+        std::vector<uint8_t> first_byte_hits(SIZE);
+        for (std::size_t i = 0; i < SIZE; i++)
+            first_byte_hits[i] = i % 2 ? 0x00 : MAGIC[0];
+
+        auto random_tail_match = bench::payloads::random_bytes(SIZE);
+        for (std::size_t i = 0; i + 1 < SIZE; i++)
+            if (random_tail_match[i] == MAGIC[0] && random_tail_match[i + 1] == MAGIC[1]) random_tail_match[i + 1] = 0;
+        random_tail_match[SIZE - 2] = MAGIC[0];
+        random_tail_match[SIZE - 1] = MAGIC[1];
+
+        const std::pair<const char*, const std::vector<uint8_t>*> inputs[] = {
+            { "no_match", &no_first_byte },
+            { "first_byte_every_2nd", &first_byte_hits },
+            { "random_match_at_end", &random_tail_match },
+        };
+
+        for (auto [name, input]: inputs)
+        {
+            std::span<const uint8_t> span{*input};
+            bench::run(std::string("find_sequence/") + name + "/4096", [&]
+            {
+                bench::do_not_optimize(transport::find_sequence(span, MAGIC));
+            }, SIZE, 0);
+
+            bench::run(std::string("find_magic/") + name + "/4096", [&]
+            {
+                bench::do_not_optimize(transport::find_magic<MAGIC>(span));
+            }, SIZE, 0);
+        }
+    }
+
+    template<transport::crc16_backend_t Backend>
+    void bench_crc16(const char* name)
+    {
+        for (std::size_t size: { 16, 256, 4096, 12000 })
+        {
+            auto data = bench::payloads::random_bytes(size);
+            bench::run(std::string("crc16/") + name + "/" + std::to_string(size), [&]
+            {
+                bench::do_not_optimize(transport::crc16_ccitt_t<Backend>::compute(data));
+            }, static_cast<double>(size), 0);
+        }
+    }
+
+    // One RS(136, 128) block of the fec framing: encode, decode of a clean block and of one with 4 repairs.
+    void bench_fec()
+    {
+        using fec_t = transport::reed_solomon_t<8>;
+        constexpr std::size_t SIZE = 128;
+
+        auto data = bench::payloads::random_bytes(SIZE);
+        std::vector<uint8_t> block(SIZE + fec_t::PARITY);
+        std::copy(data.begin(), data.end(), block.begin());
+        fec_t::encode(data, std::span(block).subspan(SIZE).first<fec_t::PARITY>());
+
+        bench::run("fec/encode/128", [&]
+        {
+            fec_t::encode(data, std::span(block).subspan(SIZE).first<fec_t::PARITY>());
+            bench::do_not_optimize(block[SIZE]);
+        }, static_cast<double>(SIZE), 0);
+
+        bench::run("fec/decode_clean/128", [&]
+        {
+            bench::do_not_optimize(fec_t::decode(block));
+        }, static_cast<double>(SIZE), 0);
+
+        auto corrupted = block;
+        bench::run("fec/decode_4_errors/128", [&]
+        {
+            corrupted = block;
+            for (std::size_t i: { 3, 40, 77, 130 })
+                corrupted[i] ^= 0x5a;
+            bench::do_not_optimize(fec_t::decode(corrupted));
+        }, static_cast<double>(SIZE), 0);
+    }
+
+    void bench_parse()
+    {
+        const std::pair<std::string, std::vector<uint8_t>> messages[] = {
+            { "streams:1", bench::payloads::streams_message(1) },
+            { "streams:10", bench::payloads::streams_message(10) },
+            { "streams:30", bench::payloads::streams_message(30) },
+            { "volume_update", bench::payloads::volume_update_message(0, 0.25f) },
+            { "icon:32", bench::payloads::icon_message(0) },
+        };
+
+        for (const auto& [name, message]: messages)
+        {
+            bench::run("parse_bridge_message/" + name + "/" + std::to_string(message.size()) + "B", [&]
+            {
+                auto parsed = parse_bridge_message(message);
+                bench::do_not_optimize(parsed.index());
+            }, static_cast<double>(message.size()), 1);
+        }
+    }
+
+    void bench_serialize()
+    {
+        const bridge_audio_stream_id_t id{ bench::payloads::stream_id(0), bench::payloads::agent_id() };
+
+        bench::run("serialize_bridge_message/set_volume", [&]
+        {
+            bench::do_not_optimize(serialize_bridge_message(set_volume_message_t{ .id = id, .volume = 0.42f }).size());
+        }, 0, 1);
+
+        std::array<uint8_t, 247> slot;
+        bench::run("serialize_bridge_message/set_volume:into_slot", [&]
+        {
+            bench::do_not_optimize(serialize_bridge_message(set_volume_message_t{ .id = id, .volume = 0.42f }, slot));
+        }, 0, 1);
+
+        bench::run("serialize_bridge_message/set_mute", [&]
+        {
+            bench::do_not_optimize(serialize_bridge_message(set_mute_message_t{ .id = id, .mute = true }).size());
+        }, 0, 1);
+
+        bench::run("serialize_bridge_message/get_icon", [&]
+        {
+            bench::do_not_optimize(serialize_bridge_message(get_icon_message_t{ .source = "/usr/lib/application-0/bin/application", .agent_id = id.agent_id }).size());
+        }, 0, 1);
+
+        bench::run("serialize_bridge_message/request_refresh", [&]
+        {
+            bench::do_not_optimize(serialize_bridge_message(request_refresh_message_t{}).size());
+        }, 0, 1);
+
+        log_message_t log{};
+        log.line = std::string(120, 'x');
+        bench::run("serialize_bridge_message/log_line:120", [&]
+        {
+            bench::do_not_optimize(serialize_bridge_message(log).size());
+        }, 0, 1);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bench::parse_args(argc, argv);
+
+    // framer logs every frame at INFO, keep the logging cost out of the numbers
+    esp_log_level_set("*", ESP_LOG_NONE);
+
+    bench::print_header();
+
+    bench_find_sequence();
+    bench_crc16<transport::crc16_backend_t::etl>("etl");
+    bench_crc16<transport::crc16_backend_t::table>("table");
+    bench_crc16<transport::crc16_backend_t::slicing_by_4>("slicing_by_4");
+    bench_fec();
+    bench_framer_to_bytes();
+    bench_framer_feed();
+    bench_parse();
+    bench_serialize();
+
+    return 0;
+}
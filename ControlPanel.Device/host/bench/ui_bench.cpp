@@ -0,0 +1,196 @@
+// volume_display_t on a headless 320x240 RGB565 display. LVGL runs on the virtual clock and every
+// frame is forced by advancing it one refresh period before lv_timer_handler.
+
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "esp_log.h"
+#include "host_clock.hpp"
+
+#include "volume_display.hpp"
+
+#include "lvgl/headless_display.hpp"
+
+#include "bench.hpp"
+#include "payloads.hpp"
+
+namespace
+{
+    const std::size_t STREAM_COUNTS[] = { 1, 10, 50, 100 };
+
+    // bridge_audio_stream_t only references the title sprite, the vectors here own them
+    struct streams_t
+    {
+        std::vector<std::vector<uint8_t>> sprites;
+        std::vector<bridge_audio_stream_t> added;
+        std::vector<bridge_audio_stream_id_t> ids;
+        std::array<std::vector<bridge_audio_stream_t>, 2> volumes;
+    };
+
+    streams_t make_streams(std::size_t count)
+    {
+        streams_t s;
+        s.sprites.reserve(count);
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            bridge_audio_stream_id_t id{ bench::payloads::stream_id(i), bench::payloads::agent_id() };
+            auto source = "/usr/lib/application-" + std::to_string(i) + "/bin/application";
+            auto& sprite = s.sprites.emplace_back(bench::payloads::random_bytes(bench::payloads::TITLE_WIDTH * bench::payloads::TITLE_HEIGHT, static_cast<uint32_t>(i)));
+
+            s.added.emplace_back(bridge_audio_stream_t{
+                .id = id,
+                .source = source,
+                .name = name_sprite_t{ "Application " + std::to_string(i), sprite, bench::payloads::TITLE_WIDTH, bench::payloads::TITLE_HEIGHT },
+                .mute = false,
+                .volume = 0.5f
+            });
+            s.volumes[0].emplace_back(bridge_audio_stream_t{ .id = id, .source = source, .volume = 0.25f });
+            s.volumes[1].emplace_back(bridge_audio_stream_t{ .id = id, .source = source, .volume = 0.75f });
+            s.ids.emplace_back(id);
+        }
+
+        return s;
+    }
+
+    void next_frame()
+    {
+        host::clock_advance_to(host::clock_now_us() + LV_DEF_REFR_PERIOD * 1000);
+        lv_timer_handler();
+    }
+
+    // settle layout, animations and the first full frame outside of the measurement
+    void settle()
+    {
+        for (auto i = 0; i < 10; i++)
+            next_frame();
+    }
+
+    lv_obj_t* list_of(lv_obj_t* screen)
+    {
+        // screen -> volume_display_t content -> flex_list_t
+        return lv_obj_get_child(lv_obj_get_child(screen, -1), 0);
+    }
+
+    void bench_refresh()
+    {
+        const std::vector<bridge_audio_stream_t> no_streams;
+        const std::vector<bridge_audio_stream_id_t> no_ids;
+
+        for (auto count: STREAM_COUNTS)
+        {
+            auto streams = make_streams(count);
+            auto display = std::make_unique<volume_display_t>(0, 0, LV_PCT(100), LV_PCT(100));
+
+            bench::run("refresh/add_delete:" + std::to_string(count), [&]
+            {
+                display->refresh(streams.added, no_ids);
+                display->refresh(no_streams, streams.ids);
+            }, 0, static_cast<double>(count));
+
+            display->refresh(streams.added, no_ids);
+
+            lv_mem_monitor_t mem;
+            lv_mem_monitor(&mem);
+
+            auto flip = 0;
+            bench::run("refresh/volume:" + std::to_string(count), [&]
+            {
+                display->refresh(streams.volumes[flip ^= 1], no_ids);
+            }, 0, static_cast<double>(count));
+
+            std::printf("%-48s %zu streams use %zu B of the LVGL heap (%s the device's 48 KB)\n", "  memory",
+                count, mem.total_size - mem.free_size, mem.total_size - mem.free_size <= 48 * 1024 ? "fits" : "exceeds");
+        }
+    }
+
+    void bench_frames(host_lvgl::headless_display_t& headless)
+    {
+        for (auto count: STREAM_COUNTS)
+        {
+            auto streams = make_streams(count);
+            auto display = std::make_unique<volume_display_t>(0, 0, LV_PCT(100), LV_PCT(100));
+            display->refresh(streams.added, std::vector<bridge_audio_stream_id_t>{});
+            settle();
+
+            auto suffix = ":" + std::to_string(count);
+
+            bench::run("frame/idle" + suffix, [&]
+            {
+                next_frame();
+            }, 0, 1);
+
+            auto flip = 0;
+            std::array<std::vector<bridge_audio_stream_t>, 2> one_volume{
+                std::vector{ streams.volumes[0].front() }, std::vector{ streams.volumes[1].front() } };
+            bench::run("frame/volume_change" + suffix, [&]
+            {
+                display->refresh(one_volume[flip ^= 1], std::vector<bridge_audio_stream_id_t>{});
+                next_frame();
+            }, 0, 1);
+
+            auto flushed = headless.flushed_pixels();
+            auto frames = 0ull;
+            bench::run("frame/full" + suffix, [&]
+            {
+                lv_obj_invalidate(lv_screen_active());
+                next_frame();
+                frames++;
+            }, 0, 1);
+
+            std::printf("%-48s %.0f pixels flushed per frame\n", "  frame/full", frames ? static_cast<double>(headless.flushed_pixels() - flushed) / frames : 0.0);
+        }
+    }
+
+    void bench_scroll()
+    {
+        constexpr int32_t STEP = 8;
+
+        for (auto count: STREAM_COUNTS)
+        {
+            if (count == 1)
+                continue;
+
+            auto streams = make_streams(count);
+            auto display = std::make_unique<volume_display_t>(0, 0, LV_PCT(100), LV_PCT(100));
+            display->refresh(streams.added, std::vector<bridge_audio_stream_id_t>{});
+            settle();
+
+            auto list = list_of(lv_screen_active());
+            auto direction = 1;
+
+            // one iteration is one rendered frame, so items/s is the scroll frame rate
+            bench::run("scroll/step:" + std::to_string(STEP) + "px/streams:" + std::to_string(count), [&]
+            {
+                if (direction > 0 && lv_obj_get_scroll_bottom(list) <= 0) direction = -1;
+                else if (direction < 0 && lv_obj_get_scroll_top(list) <= 0) direction = 1;
+
+                lv_obj_scroll_by_bounded(list, 0, -direction * STEP, LV_ANIM_OFF);
+                next_frame();
+            }, 0, 1);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bench::parse_args(argc, argv);
+
+    esp_log_level_set("*", ESP_LOG_NONE);
+
+    host::clock_set_virtual(true);
+    host_lvgl::init();
+    host_lvgl::headless_display_t headless;
+    app_style::init(headless.display());
+
+    bench::print_header();
+
+    bench_refresh();
+    bench_frames(headless);
+    bench_scroll();
+
+    return 0;
+}
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <termios.h>
+#include <unistd.h>
+
+// frame_transport_t over a file descriptor, so host tools can talk to the panel (or to a host build of it)
+// through a serial port, a pty or a Unix socket.
+//
+//   pty                  create a pty and print the path of its slave side
+//   unix:PATH            connect to a listening Unix socket
+//   unix-listen:PATH     listen on PATH and accept one connection
+//   PATH[@BAUD]          serial port, 921600 baud by default (UART_BAUDRATE in main.cpp)
+namespace host_io
+{
+    class fd_transport_t
+    {
+    public:
+        explicit fd_transport_t(int fd)
+            : _fd(fd)
+        {
+        }
+
+        fd_transport_t(const fd_transport_t&) = delete;
+        fd_transport_t& operator=(const fd_transport_t&) = delete;
+
+        ~fd_transport_t()
+        {
+            stop();
+            ::close(_fd);
+        }
+
+        // Joins the reader thread, call it before whatever on_receive points at goes away.
+        void stop()
+        {
+            _stop = true;
+            if (_reader.joinable())
+                _reader.join();
+        }
+
+        void write(std::span<uint8_t> data)
+        {
+            std::scoped_lock lock{_write_sync};
+
+            while (!data.empty())
+            {
+                auto n = ::write(_fd, data.data(), data.size());
+                if (n < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    if (errno == EAGAIN)
+                    {
+                        pollfd p{ _fd, POLLOUT, 0 };
+                        ::poll(&p, 1, 100);
+                        continue;
+                    }
+                    return;
+                }
+
+                data = data.subspan(static_cast<std::size_t>(n));
+            }
+        }
+
+        // Registers the receive callback and starts the reader thread.
+        void on_receive(std::function<void(std::span<uint8_t>)> cb)
+        {
+            _on_receive = std::move(cb);
+            if (!_reader.joinable())
+                _reader = std::thread([this] { read_loop(); });
+        }
+
+        bool closed() const
+        {
+            return _closed;
+        }
+
+    private:
+        void read_loop()
+        {
+            uint8_t buffer[4096];
+
+            while (!_stop)
+            {
+                pollfd p{ _fd, POLLIN, 0 };
+                if (::poll(&p, 1, 100) <= 0)
+                    continue;
+
+                auto n = ::read(_fd, buffer, sizeof(buffer));
+                if (n > 0)
+                {
+                    if (_on_receive) _on_receive(std::span(buffer, static_cast<std::size_t>(n)));
+                    continue;
+                }
+
+                if (n < 0 && (errno == EINTR || errno == EAGAIN))
+                    continue;
+
+                // pty master without an open slave reports EIO until the other side opens it
+                if (n < 0 && errno == EIO)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                    continue;
+                }
+
+                _closed = true;
+                return;
+            }
+        }
+
+    private:
+        int _fd;
+        std::function<void(std::span<uint8_t>)> _on_receive;
+        std::thread _reader;
+        std::mutex _write_sync;
+        std::atomic<bool> _stop = false;
+        std::atomic<bool> _closed = false;
+    };
+
+    inline speed_t baud_to_speed(int baud)
+    {
+        switch (baud)
+        {
+            case 9600: return B9600;
+            case 19200: return B19200;
+            case 38400: return B38400;
+            case 57600: return B57600;
+            case 115200: return B115200;
+            case 230400: return B230400;
+            case 460800: return B460800;
+            case 921600: return B921600;
+            case 1000000: return B1000000;
+            case 2000000: return B2000000;
+            default: throw std::invalid_argument("unsupported baud rate " + std::to_string(baud));
+        }
+    }
+
+    inline void make_raw(int fd, int baud = 0)
+    {
+        termios tio{};
+        if (::tcgetattr(fd, &tio) != 0)
+            return;
+
+        ::cfmakeraw(&tio);
+        tio.c_cflag |= CLOCAL | CREAD;
+        tio.c_cc[VMIN] = 1;
+        tio.c_cc[VTIME] = 0;
+
+        if (baud)
+        {
+            ::cfsetispeed(&tio, baud_to_speed(baud));
+            ::cfsetospeed(&tio, baud_to_speed(baud));
+        }
+
+        ::tcsetattr(fd, TCSANOW, &tio);
+    }
+
+    inline int open_serial(const std::string& path, int baud)
+    {
+        auto fd = ::open(path.c_str(), O_RDWR | O_NOCTTY);
+        if (fd < 0)
+            throw std::runtime_error("cannot open " + path + ": " + std::strerror(errno));
+
+        make_raw(fd, baud);
+        return fd;
+    }
+
+    inline int open_pty(std::string& slave_path)
+    {
+        auto fd = ::posix_openpt(O_RDWR | O_NOCTTY);
+        if (fd < 0 || ::grantpt(fd) != 0 || ::unlockpt(fd) != 0)
+            throw std::runtime_error(std::string("cannot create pty: ") + std::strerror(errno));
+
+        slave_path = ::ptsname(fd);
+        make_raw(fd);
+        return fd;
+    }
+
+    inline sockaddr_un unix_address(const std::string& path)
+    {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addr.sun_path))
+            throw std::invalid_argument("socket path too long: " + path);
+        std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+        return addr;
+    }
+
+    inline int connect_unix(const std::string& path)
+    {
+        auto addr = unix_address(path);
+        auto fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+            throw std::runtime_error("cannot connect to " + path + ": " + std::strerror(errno));
+        return fd;
+    }
+
+    inline int listen_unix(const std::string& path)
+    {
+        auto addr = unix_address(path);
+        ::unlink(path.c_str());
+
+        auto server = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (server < 0 || ::bind(server, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(server, 1) != 0)
+            throw std::runtime_error("cannot listen on " + path + ": " + std::strerror(errno));
+
+        auto fd = ::accept(server, nullptr, nullptr);
+        ::close(server);
+        if (fd < 0)
+            throw std::runtime_error("accept on " + path + " failed: " + std::strerror(errno));
+        return fd;
+    }
+
+    // Opens an endpoint described as in the header comment. on_listening is called with a
+    // human readable description before blocking on a peer (pty path, socket path).
+    inline int open_endpoint(std::string_view spec, const std::function<void(const std::string&)>& on_listening = {})
+    {
+        if (spec == "pty")
+        {
+            std::string slave;
+            auto fd = open_pty(slave);
+            if (on_listening) on_listening("pty " + slave);
+            return fd;
+        }
+
+        if (spec.starts_with("unix-listen:"))
+        {
+            std::string path{spec.substr(12)};
+            if (on_listening) on_listening("unix socket " + path);
+            return listen_unix(path);
+        }
+
+        if (spec.starts_with("unix:"))
+            return connect_unix(std::string{spec.substr(5)});
+
+        auto at = spec.rfind('@');
+        auto path = std::string{spec.substr(0, at)};
+        auto baud = at == std::string_view::npos ? 921600 : std::stoi(std::string{spec.substr(at + 1)});
+        return open_serial(path, baud);
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+#include "lvgl.h"
+
+#include "host_clock.hpp"
+
+// LVGL without a panel: a display of the same size and buffer layout as st7789_create_lvgl_display()
+// whose flush callback copies into a framebuffer in memory. The tick comes from the host clock,
+// so LVGL timers and animations follow the virtual clock when it is enabled.
+namespace host_lvgl
+{
+    inline constexpr int32_t LCD_WIDTH = 320;
+    inline constexpr int32_t LCD_HEIGHT = 240;
+
+    inline void init()
+    {
+        lv_init();
+        lv_tick_set_cb(+[]() { return static_cast<uint32_t>(host::clock_now_us() / 1000); });
+    }
+
+    class headless_display_t
+    {
+    public:
+        headless_display_t(int32_t width = LCD_WIDTH, int32_t height = LCD_HEIGHT)
+            : _width(width)
+            , _height(height)
+            , _framebuffer(static_cast<std::size_t>(width) * height)
+            , _draw_buffer(static_cast<std::size_t>(width) * height / 5 * LV_COLOR_FORMAT_GET_SIZE(LV_COLOR_FORMAT_RGB565))
+        {
+            _display = lv_display_create(width, height);
+            lv_display_set_color_format(_display, LV_COLOR_FORMAT_RGB565);
+            lv_display_set_user_data(_display, this);
+            lv_display_set_flush_cb(_display, flush);
+            lv_display_set_buffers(_display, _draw_buffer.data(), nullptr, _draw_buffer.size(), LV_DISPLAY_RENDER_MODE_PARTIAL);
+        }
+
+        headless_display_t(const headless_display_t&) = delete;
+        headless_display_t& operator=(const headless_display_t&) = delete;
+
+        ~headless_display_t()
+        {
+            lv_display_delete(_display);
+        }
+
+        lv_display_t* display() const
+        {
+            return _display;
+        }
+
+        // byte swapped RGB565, as the panel receives it
+        std::span<const uint16_t> framebuffer() const
+        {
+            return _framebuffer;
+        }
+
+        uint64_t flushes() const
+        {
+            return _flushes;
+        }
+
+        uint64_t flushed_pixels() const
+        {
+            return _flushed_pixels;
+        }
+
+    private:
+        static void flush(lv_display_t* display, const lv_area_t* area, uint8_t* px_map)
+        {
+            auto self = static_cast<headless_display_t*>(lv_display_get_user_data(display));
+            auto w = lv_area_get_width(area);
+            auto size = lv_area_get_size(area);
+
+            lv_draw_sw_rgb565_swap(px_map, size);
+
+            auto src = reinterpret_cast<const uint16_t*>(px_map);
+            for (auto y = area->y1; y <= area->y2; y++, src += w)
+                std::memcpy(&self->_framebuffer[static_cast<std::size_t>(y) * self->_width + area->x1], src, w * sizeof(uint16_t));
+
+            self->_flushes++;
+            self->_flushed_pixels += size;
+
+            lv_display_flush_ready(display);
+        }
+
+    private:
+        int32_t _width;
+        int32_t _height;
+        std::vector<uint16_t> _framebuffer;
+        std::vector<uint8_t> _draw_buffer;
+        lv_display_t* _display = nullptr;
+        uint64_t _flushes = 0;
+        uint64_t _flushed_pixels = 0;
+    };
+}
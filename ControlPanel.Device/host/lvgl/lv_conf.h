@@ -0,0 +1,92 @@
+/* LVGL configuration of the host build. Mirrors the CONFIG_LV_* values in ../../sdkconfig so that
+ * layout, styles and the software renderer behave like on the device. Options not listed here use
+ * the LVGL defaults, same as on the device. */
+
+#ifndef LV_CONF_H
+#define LV_CONF_H
+
+#define LV_COLOR_DEPTH 16
+
+#define LV_USE_STDLIB_MALLOC LV_STDLIB_BUILTIN
+#define LV_USE_STDLIB_STRING LV_STDLIB_BUILTIN
+#define LV_USE_STDLIB_SPRINTF LV_STDLIB_BUILTIN
+/* 48 KB on the device, the host default is larger so the UI benchmarks can go past what fits there */
+#ifndef HOST_LV_MEM_SIZE_KB
+#define HOST_LV_MEM_SIZE_KB 48
+#endif
+#define LV_MEM_SIZE (HOST_LV_MEM_SIZE_KB * 1024U)
+
+#define LV_DEF_REFR_PERIOD 16
+#define LV_DPI_DEF 142
+
+/* the device runs LV_OS_FREERTOS, the host tools drive lv_timer_handler from a single thread */
+#define LV_USE_OS LV_OS_NONE
+
+#define LV_DRAW_BUF_STRIDE_ALIGN 1
+#define LV_DRAW_BUF_ALIGN 4
+#define LV_DRAW_LAYER_SIMPLE_BUF_SIZE (24 * 1024)
+#define LV_DRAW_LAYER_MAX_MEMORY 0
+
+#define LV_USE_DRAW_SW 1
+#define LV_DRAW_SW_SUPPORT_RGB565 1
+#define LV_DRAW_SW_SUPPORT_RGB565_SWAPPED 0
+#define LV_DRAW_SW_SUPPORT_RGB565A8 1
+#define LV_DRAW_SW_SUPPORT_RGB888 0
+#define LV_DRAW_SW_SUPPORT_XRGB8888 0
+#define LV_DRAW_SW_SUPPORT_ARGB8888 0
+#define LV_DRAW_SW_SUPPORT_ARGB8888_PREMULTIPLIED 0
+#define LV_DRAW_SW_SUPPORT_L8 0
+#define LV_DRAW_SW_SUPPORT_AL88 0
+#define LV_DRAW_SW_SUPPORT_A8 1
+#define LV_DRAW_SW_SUPPORT_I1 0
+#define LV_DRAW_SW_DRAW_UNIT_CNT 1
+#define LV_DRAW_SW_COMPLEX 1
+#define LV_DRAW_SW_SHADOW_CACHE_SIZE 0
+#define LV_DRAW_SW_CIRCLE_CACHE_SIZE 4
+#define LV_USE_DRAW_SW_ASM LV_DRAW_SW_ASM_NONE
+
+#define LV_USE_LOG 1
+#define LV_LOG_LEVEL LV_LOG_LEVEL_ERROR
+#define LV_LOG_PRINTF 1
+
+#define LV_USE_ASSERT_NULL 1
+#define LV_USE_ASSERT_MALLOC 1
+#define LV_USE_ASSERT_STYLE 1
+#define LV_ASSERT_HANDLER_INCLUDE <stdlib.h>
+#define LV_ASSERT_HANDLER abort();
+
+#define LV_CACHE_DEF_SIZE 0
+#define LV_IMAGE_HEADER_CACHE_DEF_CNT 0
+#define LV_GRADIENT_MAX_STOPS 2
+#define LV_COLOR_MIX_ROUND_OFS 128
+
+#define LV_FONT_MONTSERRAT_14 1
+#define LV_FONT_DEFAULT &lv_font_montserrat_14
+#define LV_USE_FONT_COMPRESSED 1
+#define LV_USE_FONT_PLACEHOLDER 1
+#define LV_TXT_ENC LV_TXT_ENC_UTF8
+
+#define LV_WIDGETS_HAS_DEFAULT_VALUE 1
+#define LV_USE_BAR 1
+#define LV_USE_IMAGE 1
+#define LV_USE_LABEL 1
+#define LV_LABEL_TEXT_SELECTION 1
+#define LV_LABEL_LONG_TXT_HINT 1
+#define LV_USE_MSGBOX 1
+#define LV_USE_SLIDER 1
+
+#define LV_USE_THEME_DEFAULT 1
+#define LV_THEME_DEFAULT_DARK 0
+#define LV_THEME_DEFAULT_GROW 1
+#define LV_THEME_DEFAULT_TRANSITION_TIME 40
+#define LV_USE_THEME_SIMPLE 0
+
+#define LV_USE_FLEX 1
+#define LV_USE_GRID 1
+
+#define LV_USE_OBSERVER 1
+
+#define LV_BUILD_EXAMPLES 0
+#define LV_BUILD_DEMOS 0
+
+#endif /* LV_CONF_H */
@@ -0,0 +1,233 @@
+// SPI master, I2C master and GPIO subset for the host build. Nothing reaches hardware, transactions
+// only feed the counters in host_bus.hpp and I2C traffic is routed to targets attached by the caller.
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "driver/gpio.h"
+#include "driver/i2c_master.h"
+#include "driver/spi_master.h"
+#include "host_bus.hpp"
+
+struct host_spi_device
+{
+    int clock_speed_hz;
+};
+
+struct host_i2c_bus
+{
+    i2c_port_t port;
+};
+
+struct host_i2c_device
+{
+    uint16_t address;
+    uint32_t scl_speed_hz;
+};
+
+namespace
+{
+    std::mutex sync;
+    host::bus_stats_t stats;
+    host::bus_model_t model;
+    std::map<uint16_t, host::i2c_target_t> i2c_targets;
+    std::map<int, std::pair<gpio_isr_t, void*>> isr_handlers;
+    std::map<int, uint32_t> levels;
+
+    void add(host::bus_counters_t& counters, uint64_t bytes, uint64_t bus_ns, uint32_t transaction_ns)
+    {
+        counters.transactions++;
+        counters.bytes += bytes;
+        counters.time_ns += bus_ns + transaction_ns;
+    }
+
+    uint64_t cycles_ns(uint64_t cycles, uint32_t hz)
+    {
+        return hz ? cycles * 1'000'000'000ull / hz : 0;
+    }
+
+    // START, address + R/W, 9 clocks per byte, STOP; a read after a write adds a repeated START and address
+    uint64_t i2c_cycles(std::size_t write_size, std::size_t read_size)
+    {
+        uint64_t cycles = 1 + 9 + 9 * write_size + 1;
+        if (read_size)
+            cycles += (write_size ? 1 + 9 : 0) + 9 * read_size;
+        return cycles;
+    }
+
+    esp_err_t i2c_transfer(host_i2c_device* dev, std::span<const uint8_t> write, std::span<uint8_t> read)
+    {
+        host::i2c_target_t target;
+        {
+            std::scoped_lock lock{sync};
+            add(stats.i2c, write.size() + read.size(), cycles_ns(i2c_cycles(write.size(), read.size()), dev->scl_speed_hz), model.i2c_transaction_ns);
+
+            if (auto it = i2c_targets.find(dev->address); it != i2c_targets.end())
+                target = it->second;
+        }
+
+        return target ? target(write, read) : ESP_FAIL;
+    }
+}
+
+host::bus_stats_t host::bus_stats_t::operator-(const bus_stats_t& other) const
+{
+    auto sub = [](const bus_counters_t& a, const bus_counters_t& b)
+    {
+        return bus_counters_t{ a.transactions - b.transactions, a.bytes - b.bytes, a.time_ns - b.time_ns };
+    };
+
+    return { sub(spi, other.spi), sub(i2c, other.i2c), gpio_writes - other.gpio_writes, gpio_isrs - other.gpio_isrs };
+}
+
+host::bus_stats_t host::bus_stats()
+{
+    std::scoped_lock lock{sync};
+    return stats;
+}
+
+void host::bus_model_set(const bus_model_t& m)
+{
+    std::scoped_lock lock{sync};
+    model = m;
+}
+
+void host::i2c_attach(uint16_t address, i2c_target_t target)
+{
+    std::scoped_lock lock{sync};
+    i2c_targets[address] = std::move(target);
+}
+
+void host::gpio_raise_isr(gpio_num_t pin)
+{
+    std::pair<gpio_isr_t, void*> handler{};
+    {
+        std::scoped_lock lock{sync};
+        stats.gpio_isrs++;
+
+        if (auto it = isr_handlers.find(pin); it != isr_handlers.end())
+            handler = it->second;
+    }
+
+    if (handler.first)
+        handler.first(handler.second);
+}
+
+extern "C" esp_err_t gpio_config(const gpio_config_t* config)
+{
+    return config ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+extern "C" esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    std::scoped_lock lock{sync};
+    stats.gpio_writes++;
+    levels[gpio_num] = level;
+    return ESP_OK;
+}
+
+extern "C" int gpio_get_level(gpio_num_t gpio_num)
+{
+    std::scoped_lock lock{sync};
+    auto it = levels.find(gpio_num);
+    return it != levels.end() ? static_cast<int>(it->second) : 0;
+}
+
+extern "C" esp_err_t gpio_install_isr_service(int)
+{
+    return ESP_OK;
+}
+
+extern "C" esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void* args)
+{
+    std::scoped_lock lock{sync};
+    isr_handlers[gpio_num] = { isr_handler, args };
+    return ESP_OK;
+}
+
+extern "C" esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num)
+{
+    std::scoped_lock lock{sync};
+    isr_handlers.erase(gpio_num);
+    return ESP_OK;
+}
+
+extern "C" esp_err_t spi_bus_initialize(spi_host_device_t, const spi_bus_config_t* bus_config, spi_dma_chan_t)
+{
+    return bus_config ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+extern "C" esp_err_t spi_bus_add_device(spi_host_device_t, const spi_device_interface_config_t* dev_config, spi_device_handle_t* handle)
+{
+    if (!dev_config || !handle)
+        return ESP_ERR_INVALID_ARG;
+
+    *handle = new host_spi_device{ dev_config->clock_speed_hz };
+    return ESP_OK;
+}
+
+extern "C" esp_err_t spi_bus_remove_device(spi_device_handle_t handle)
+{
+    delete handle;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t* trans_desc)
+{
+    if (!handle || !trans_desc)
+        return ESP_ERR_INVALID_ARG;
+
+    std::scoped_lock lock{sync};
+    add(stats.spi, (trans_desc->length + 7) / 8, cycles_ns(trans_desc->length, static_cast<uint32_t>(handle->clock_speed_hz)), model.spi_transaction_ns);
+    return ESP_OK;
+}
+
+extern "C" esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t* trans_desc)
+{
+    return spi_device_transmit(handle, trans_desc);
+}
+
+extern "C" esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t* bus_config, i2c_master_bus_handle_t* ret_bus_handle)
+{
+    if (!bus_config || !ret_bus_handle)
+        return ESP_ERR_INVALID_ARG;
+
+    *ret_bus_handle = new host_i2c_bus{ bus_config->i2c_port };
+    return ESP_OK;
+}
+
+extern "C" esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus_handle, const i2c_device_config_t* dev_config, i2c_master_dev_handle_t* ret_handle)
+{
+    if (!bus_handle || !dev_config || !ret_handle)
+        return ESP_ERR_INVALID_ARG;
+
+    *ret_handle = new host_i2c_device{ dev_config->device_address, dev_config->scl_speed_hz };
+    return ESP_OK;
+}
+
+extern "C" esp_err_t i2c_master_transmit(i2c_master_dev_handle_t i2c_dev, const uint8_t* write_buffer, size_t write_size, int)
+{
+    return i2c_transfer(i2c_dev, { write_buffer, write_size }, {});
+}
+
+extern "C" esp_err_t i2c_master_receive(i2c_master_dev_handle_t i2c_dev, uint8_t* read_buffer, size_t read_size, int)
+{
+    return i2c_transfer(i2c_dev, {}, { read_buffer, read_size });
+}
+
+extern "C" esp_err_t i2c_master_transmit_receive(i2c_master_dev_handle_t i2c_dev, const uint8_t* write_buffer, size_t write_size,
+    uint8_t* read_buffer, size_t read_size, int)
+{
+    return i2c_transfer(i2c_dev, { write_buffer, write_size }, { read_buffer, read_size });
+}
+
+extern "C" esp_err_t i2c_master_multi_buffer_transmit(i2c_master_dev_handle_t i2c_dev, i2c_master_transmit_multi_buffer_info_t* buffer_info_array,
+    size_t array_size, int)
+{
+    std::vector<uint8_t> write;
+    for (std::size_t i = 0; i < array_size; i++)
+        write.insert(write.end(), buffer_info_array[i].write_buffer, buffer_info_array[i].write_buffer + buffer_info_array[i].buffer_size);
+
+    return i2c_transfer(i2c_dev, write, {});
+}
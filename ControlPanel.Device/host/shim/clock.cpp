@@ -0,0 +1,47 @@
+#include <atomic>
+#include <chrono>
+
+#include "host_clock.hpp"
+
+namespace
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    std::atomic<bool> is_virtual{false};
+    std::atomic<int64_t> virtual_now_us{0};
+
+    int64_t real_now_us()
+    {
+        auto elapsed = std::chrono::steady_clock::now() - start_time;
+        return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    }
+}
+
+namespace host
+{
+    void clock_set_virtual(bool enable)
+    {
+        if (enable && !is_virtual)
+            virtual_now_us = real_now_us();
+
+        is_virtual = enable;
+    }
+
+    bool clock_is_virtual()
+    {
+        return is_virtual;
+    }
+
+    int64_t clock_now_us()
+    {
+        return is_virtual ? virtual_now_us.load() : real_now_us();
+    }
+
+    void clock_advance_to(int64_t us)
+    {
+        auto now = virtual_now_us.load();
+        while (us > now && !virtual_now_us.compare_exchange_weak(now, us))
+        {
+        }
+    }
+}
@@ -0,0 +1,90 @@
+// esp_log subset for the host build: per-tag levels, vprintf redirection, timestamps.
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "esp_log.h"
+#include "esp_err.h"
+#include "host_clock.hpp"
+
+namespace
+{
+    std::atomic<esp_log_level_t> default_level{static_cast<esp_log_level_t>(CONFIG_LOG_DEFAULT_LEVEL)};
+    std::atomic<bool> has_tag_levels{false};
+    std::mutex tag_levels_sync;
+    std::map<std::string, esp_log_level_t, std::less<>> tag_levels;
+
+    std::atomic<vprintf_like_t> log_vprintf{&std::vprintf};
+}
+
+extern "C" void esp_log_level_set(const char* tag, esp_log_level_t level)
+{
+    if (std::strcmp(tag, "*") == 0)
+    {
+        std::scoped_lock lock{tag_levels_sync};
+        default_level = level;
+        tag_levels.clear();
+        has_tag_levels = false;
+        return;
+    }
+
+    std::scoped_lock lock{tag_levels_sync};
+    tag_levels[tag] = level;
+    has_tag_levels = true;
+}
+
+extern "C" esp_log_level_t esp_log_level_get(const char* tag)
+{
+    if (has_tag_levels)
+    {
+        std::scoped_lock lock{tag_levels_sync};
+        if (auto it = tag_levels.find(std::string_view{tag}); it != tag_levels.end())
+            return it->second;
+    }
+
+    return default_level;
+}
+
+extern "C" vprintf_like_t esp_log_set_vprintf(vprintf_like_t func)
+{
+    return log_vprintf.exchange(func);
+}
+
+extern "C" uint32_t esp_log_timestamp(void)
+{
+    return static_cast<uint32_t>(host::clock_now_us() / 1000);
+}
+
+extern "C" int esp_log_enabled(esp_log_level_t level, const char* tag)
+{
+    return level <= esp_log_level_get(tag);
+}
+
+extern "C" void esp_log_write(esp_log_level_t, const char*, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    log_vprintf.load()(format, args);
+    va_end(args);
+}
+
+extern "C" const char* esp_err_to_name(esp_err_t code)
+{
+    switch (code)
+    {
+        case ESP_OK: return "ESP_OK";
+        case ESP_FAIL: return "ESP_FAIL";
+        case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+        default: return "UNKNOWN ERROR";
+    }
+}
@@ -0,0 +1,15 @@
+// Bitwise stand-in for the ESP32 ROM crc16_be, so the rom backend of crc16.hpp can be checked on the host.
+
+#include "esp_rom_crc.h"
+
+extern "C" uint16_t esp_rom_crc16_be(uint16_t crc, uint8_t const* buf, uint32_t len)
+{
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; i++)
+    {
+        crc ^= static_cast<uint16_t>(buf[i] << 8);
+        for (auto bit = 0; bit < 8; bit++)
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return ~crc;
+}
@@ -0,0 +1,161 @@
+// esp_timer subset for the host build. All timers are dispatched from one service thread,
+// like the ESP_TIMER_TASK dispatch method on the device.
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "esp_timer.h"
+#include "host_clock.hpp"
+
+struct esp_timer
+{
+    esp_timer_cb_t callback;
+    void* arg;
+    uint64_t period_us = 0;
+    bool armed = false;
+    std::multimap<int64_t, esp_timer*>::iterator slot;
+};
+
+namespace
+{
+    struct timer_service_t
+    {
+        std::mutex sync;
+        std::condition_variable changed;
+        std::multimap<int64_t, esp_timer*> deadlines;
+
+        timer_service_t()
+        {
+            std::thread([this]{ run(); }).detach();
+        }
+
+        void arm(esp_timer* timer, int64_t deadline)
+        {
+            timer->slot = deadlines.emplace(deadline, timer);
+            timer->armed = true;
+            changed.notify_all();
+        }
+
+        void disarm(esp_timer* timer)
+        {
+            if (!timer->armed)
+                return;
+
+            deadlines.erase(timer->slot);
+            timer->armed = false;
+            changed.notify_all();
+        }
+
+        void run()
+        {
+            std::unique_lock lock{sync};
+
+            while (true)
+            {
+                if (deadlines.empty())
+                {
+                    changed.wait(lock);
+                    continue;
+                }
+
+                auto [deadline, timer] = *deadlines.begin();
+                auto now = esp_timer_get_time();
+                if (deadline > now)
+                {
+                    changed.wait_for(lock, std::chrono::microseconds(deadline - now));
+                    continue;
+                }
+
+                disarm(timer);
+                if (timer->period_us)
+                    arm(timer, deadline + static_cast<int64_t>(timer->period_us));
+
+                auto callback = timer->callback;
+                auto arg = timer->arg;
+
+                lock.unlock();
+                callback(arg);
+                lock.lock();
+            }
+        }
+    };
+
+    timer_service_t& service()
+    {
+        static timer_service_t instance;
+        return instance;
+    }
+}
+
+extern "C" esp_err_t esp_timer_init(void)
+{
+    service();
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_timer_create(const esp_timer_create_args_t* create_args, esp_timer_handle_t* out_handle)
+{
+    if (!create_args || !create_args->callback || !out_handle)
+        return ESP_ERR_INVALID_ARG;
+
+    *out_handle = new esp_timer{ .callback = create_args->callback, .arg = create_args->arg };
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    auto& s = service();
+    std::scoped_lock lock{s.sync};
+
+    if (timer->armed)
+        return ESP_ERR_INVALID_STATE;
+
+    timer->period_us = 0;
+    s.arm(timer, esp_timer_get_time() + static_cast<int64_t>(timeout_us));
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+{
+    auto& s = service();
+    std::scoped_lock lock{s.sync};
+
+    if (timer->armed)
+        return ESP_ERR_INVALID_STATE;
+
+    timer->period_us = period;
+    s.arm(timer, esp_timer_get_time() + static_cast<int64_t>(period));
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    auto& s = service();
+    std::scoped_lock lock{s.sync};
+
+    if (!timer->armed)
+        return ESP_ERR_INVALID_STATE;
+
+    s.disarm(timer);
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    auto& s = service();
+    std::scoped_lock lock{s.sync};
+
+    if (timer->armed)
+        return ESP_ERR_INVALID_STATE;
+
+    delete timer;
+    return ESP_OK;
+}
+
+extern "C" int64_t esp_timer_get_time(void)
+{
+    return host::clock_now_us();
+}
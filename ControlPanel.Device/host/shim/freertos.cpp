@@ -0,0 +1,254 @@
+// FreeRTOS task/queue/notification subset on top of std::thread, used by the host build.
+// Priorities, affinity and stack sizes are accepted and ignored.
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "host_clock.hpp"
+
+struct host_task
+{
+    std::string name;
+    std::mutex sync;
+    std::condition_variable notified;
+    uint32_t notify_count = 0;
+};
+
+struct host_queue
+{
+    std::size_t length;
+    std::size_t item_size;
+    std::deque<std::vector<uint8_t>> items;
+    std::mutex sync;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+};
+
+namespace
+{
+    thread_local host_task* current_task = nullptr;
+
+    template<typename TLock, typename TPred>
+    bool wait_ticks(std::condition_variable& cv, TLock& lock, TickType_t ticks, TPred&& pred)
+    {
+        if (ticks == 0 || (ticks != portMAX_DELAY && host::clock_is_virtual()))
+            return pred();
+
+        if (ticks == portMAX_DELAY)
+        {
+            cv.wait(lock, pred);
+            return true;
+        }
+
+        return cv.wait_for(lock, std::chrono::milliseconds(pdTICKS_TO_MS(ticks)), pred);
+    }
+}
+
+extern "C" void host_assert_failed(const char* expr, const char* file, int line)
+{
+    std::fprintf(stderr, "assert failed: %s (%s:%d)\n", expr, file, line);
+    std::abort();
+}
+
+extern "C" BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t, void* arg, UBaseType_t, TaskHandle_t* created_task)
+{
+    auto task = new host_task{};
+    task->name = name ? name : "";
+
+    if (created_task)
+        *created_task = task;
+
+    std::thread([fn, arg, task]
+    {
+        current_task = task;
+        fn(arg);
+    }).detach();
+
+    return pdPASS;
+}
+
+extern "C" BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack_depth, void* arg, UBaseType_t priority, TaskHandle_t* created_task, BaseType_t)
+{
+    return xTaskCreate(fn, name, stack_depth, arg, priority, created_task);
+}
+
+extern "C" TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    if (!current_task)
+        current_task = new host_task{ .name = "main" };
+
+    return current_task;
+}
+
+extern "C" void vTaskDelay(TickType_t ticks)
+{
+    if (host::clock_is_virtual())
+    {
+        host::clock_advance_to(host::clock_now_us() + static_cast<int64_t>(pdTICKS_TO_MS(ticks)) * 1000);
+        return;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(pdTICKS_TO_MS(ticks)));
+}
+
+extern "C" TickType_t xTaskGetTickCount(void)
+{
+    return pdMS_TO_TICKS(host::clock_now_us() / 1000);
+}
+
+extern "C" BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    configASSERT(task);
+
+    {
+        std::scoped_lock lock{task->sync};
+        task->notify_count++;
+    }
+    task->notified.notify_all();
+
+    return pdPASS;
+}
+
+extern "C" void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higher_priority_task_woken)
+{
+    xTaskNotifyGive(task);
+    if (higher_priority_task_woken)
+        *higher_priority_task_woken = pdFALSE;
+}
+
+extern "C" uint32_t ulTaskNotifyTake(BaseType_t clear_count_on_exit, TickType_t ticks_to_wait)
+{
+    auto task = xTaskGetCurrentTaskHandle();
+
+    std::unique_lock lock{task->sync};
+    wait_ticks(task->notified, lock, ticks_to_wait, [&]{ return task->notify_count > 0; });
+
+    auto count = task->notify_count;
+    if (count > 0)
+        task->notify_count = clear_count_on_exit ? 0 : count - 1;
+
+    return count;
+}
+
+extern "C" QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    auto queue = new host_queue{};
+    queue->length = length;
+    queue->item_size = item_size;
+    return queue;
+}
+
+extern "C" QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size, uint8_t*, StaticQueue_t* queue_buffer)
+{
+    auto queue = xQueueCreate(length, item_size);
+    if (queue_buffer)
+        queue_buffer->handle = queue;
+    return queue;
+}
+
+extern "C" void vQueueDelete(QueueHandle_t queue)
+{
+    delete queue;
+}
+
+extern "C" BaseType_t xQueueGenericSend(QueueHandle_t queue, const void* item, TickType_t ticks_to_wait, BaseType_t copy_position)
+{
+    configASSERT(queue);
+
+    std::unique_lock lock{queue->sync};
+
+    if (copy_position == queueOVERWRITE)
+        queue->items.clear();
+
+    if (!wait_ticks(queue->not_full, lock, ticks_to_wait, [&]{ return queue->items.size() < queue->length; }))
+        return pdFAIL;
+
+    auto bytes = static_cast<const uint8_t*>(item);
+    std::vector<uint8_t> copy(bytes, bytes + queue->item_size);
+
+    if (copy_position == queueSEND_TO_FRONT)
+        queue->items.emplace_front(std::move(copy));
+    else
+        queue->items.emplace_back(std::move(copy));
+
+    lock.unlock();
+    queue->not_empty.notify_one();
+
+    return pdPASS;
+}
+
+extern "C" BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* higher_priority_task_woken)
+{
+    if (higher_priority_task_woken)
+        *higher_priority_task_woken = pdFALSE;
+
+    return xQueueGenericSend(queue, item, 0, queueSEND_TO_BACK);
+}
+
+extern "C" BaseType_t xQueueReceive(QueueHandle_t queue, void* buffer, TickType_t ticks_to_wait)
+{
+    configASSERT(queue);
+
+    std::unique_lock lock{queue->sync};
+
+    if (!wait_ticks(queue->not_empty, lock, ticks_to_wait, [&]{ return !queue->items.empty(); }))
+        return pdFAIL;
+
+    std::memcpy(buffer, queue->items.front().data(), queue->item_size);
+    queue->items.pop_front();
+
+    lock.unlock();
+    queue->not_full.notify_one();
+
+    return pdPASS;
+}
+
+extern "C" BaseType_t xQueuePeek(QueueHandle_t queue, void* buffer, TickType_t ticks_to_wait)
+{
+    configASSERT(queue);
+
+    std::unique_lock lock{queue->sync};
+
+    if (!wait_ticks(queue->not_empty, lock, ticks_to_wait, [&]{ return !queue->items.empty(); }))
+        return pdFAIL;
+
+    std::memcpy(buffer, queue->items.front().data(), queue->item_size);
+
+    return pdPASS;
+}
+
+extern "C" BaseType_t xQueueReset(QueueHandle_t queue)
+{
+    configASSERT(queue);
+
+    {
+        std::scoped_lock lock{queue->sync};
+        queue->items.clear();
+    }
+    queue->not_full.notify_all();
+
+    return pdPASS;
+}
+
+extern "C" UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    std::scoped_lock lock{queue->sync};
+    return queue->items.size();
+}
+
+extern "C" UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue)
+{
+    std::scoped_lock lock{queue->sync};
+    return queue->length - queue->items.size();
+}
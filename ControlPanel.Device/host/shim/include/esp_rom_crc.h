@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Same contract as the ROM routine: MSB first, poly 0x1021, crc inverted on the way in and out.
+uint16_t esp_rom_crc16_be(uint16_t crc, uint8_t const* buf, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "sdkconfig.h"
+#include "esp_attr.h"
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE  ((BaseType_t)1)
+#define pdPASS  pdTRUE
+#define pdFAIL  pdFALSE
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+
+#define configTICK_RATE_HZ CONFIG_FREERTOS_HZ
+#define portTICK_PERIOD_MS ((TickType_t)1000 / configTICK_RATE_HZ)
+
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((uint64_t)(ms) * (uint64_t)configTICK_RATE_HZ) / (uint64_t)1000U))
+#define pdTICKS_TO_MS(ticks) ((TickType_t)(((uint64_t)(ticks) * (uint64_t)1000U) / (uint64_t)configTICK_RATE_HZ))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+__attribute__((noreturn)) void host_assert_failed(const char* expr, const char* file, int line);
+
+static inline BaseType_t xPortInIsrContext(void) { return pdFALSE; }
+
+#ifdef __cplusplus
+}
+#endif
+
+#define configASSERT(x) do { if (!(x)) host_assert_failed(#x, __FILE__, __LINE__); } while (0)
+
+#define portYIELD_FROM_ISR(...) do { } while (0)
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <span>
+
+#include "esp_err.h"
+#include "driver/gpio.h"
+
+// Accounting behind the SPI, I2C and GPIO mocks. Every transaction is counted and converted into an
+// estimated time on the wire: clock cycles at the configured bus speed plus a fixed per-transaction
+// driver cost, which bus_model_t lets callers tune to what they measured on the device.
+namespace host
+{
+    struct bus_counters_t
+    {
+        uint64_t transactions = 0;
+        uint64_t bytes = 0;
+        uint64_t time_ns = 0;
+    };
+
+    struct bus_stats_t
+    {
+        bus_counters_t spi;
+        bus_counters_t i2c;
+        uint64_t gpio_writes = 0;
+        uint64_t gpio_isrs = 0;
+
+        bus_stats_t operator-(const bus_stats_t& other) const;
+    };
+
+    struct bus_model_t
+    {
+        uint32_t spi_transaction_ns = 15000;  // queue, ISR and completion wake-up of spi_device_transmit
+        uint32_t i2c_transaction_ns = 30000;  // same for the i2c_master driver
+    };
+
+    bus_stats_t bus_stats();
+    void bus_model_set(const bus_model_t& model);
+
+    // An I2C target on the mock bus. write is what the master sent, read is to be filled for
+    // i2c_master_transmit_receive/i2c_master_receive. Devices without a target NACK with ESP_FAIL.
+    using i2c_target_t = std::function<esp_err_t(std::span<const uint8_t> write, std::span<uint8_t> read)>;
+    void i2c_attach(uint16_t address, i2c_target_t target);
+
+    // Runs the handler gpio_isr_handler_add installed for the pin, as if the pin saw its edge.
+    void gpio_raise_isr(gpio_num_t pin);
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+namespace host
+{
+    // Time source behind xTaskGetTickCount, esp_timer_get_time and log timestamps.
+    // In virtual mode time only moves through clock_advance_to/vTaskDelay, and timed FreeRTOS waits
+    // return immediately instead of blocking, so a single-threaded simulation is fully deterministic.
+    void clock_set_virtual(bool enable);
+    bool clock_is_virtual();
+    int64_t clock_now_us();
+    void clock_advance_to(int64_t us);
+}
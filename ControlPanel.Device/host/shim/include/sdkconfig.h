@@ -0,0 +1,15 @@
+#pragma once
+
+// Host build stand-in for the generated ESP-IDF sdkconfig.h.
+// Only the options the device sources actually look at are defined here.
+
+#define CONFIG_IDF_TARGET "linux"
+#define CONFIG_FREERTOS_HZ 1000
+#define CONFIG_LOG_DEFAULT_LEVEL 3
+#define CONFIG_LOG_MAXIMUM_LEVEL 5
+#define CONFIG_CP_RX_FRAME_BUFFER_SIZE 4096
+#define CONFIG_CP_SEND_WINDOW 8
+#define CONFIG_CP_ACK_DELAY_MS 5
+#define CONFIG_CP_KEEPALIVE_INTERVAL_MS 250
+#define CONFIG_CP_KEEPALIVE_MISSES 3
+#define CONFIG_CP_MAX_MESSAGE_SIZE 2048
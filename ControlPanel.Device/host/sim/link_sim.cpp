@@ -0,0 +1,482 @@
+// Deterministic simulation of two frame_host_connection_t endpoints over a lossy serial link.
+// Everything runs on one thread against the virtual clock, so a given set of options and seed
+// always produces the same numbers.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "esp_log.h"
+#include "host_clock.hpp"
+
+#include "protocol/frame_host_connection.hpp"
+
+#include "sim_link.hpp"
+
+namespace
+{
+    constexpr std::array<uint8_t, 2> MAGIC{0x19, 0x16};
+    constexpr int64_t NEVER = std::numeric_limits<int64_t>::max();
+    constexpr uint32_t MAX_WINDOW = 16;
+    constexpr uint32_t MAX_MESSAGE = 8192;
+
+    constexpr std::array<const char*, 3> FRAMING_NAMES{ "magic", "cobs", "fec" };
+    constexpr std::array<const char*, transport::CHANNEL_COUNT> CHANNEL_NAMES{ "control", "assets", "diagnostics" };
+
+    // set in the index of background messages
+    constexpr uint32_t BACKGROUND = 0x80000000u;
+
+    transport::framing_t parse_framing(const std::string& name)
+    {
+        auto it = std::ranges::find(FRAMING_NAMES, name);
+        return it == FRAMING_NAMES.end() ? transport::framing_t::magic : static_cast<transport::framing_t>(it - FRAMING_NAMES.begin());
+    }
+
+    transport::channel_t parse_channel(const std::string& name)
+    {
+        auto it = std::ranges::find(CHANNEL_NAMES, name);
+        return it == CHANNEL_NAMES.end() ? transport::channel_t::diagnostics : static_cast<transport::channel_t>(it - CHANNEL_NAMES.begin());
+    }
+
+    struct options_t
+    {
+        sim::link_config_t link = sim::link_config_t::uart();
+        uint32_t messages = 2000;
+        uint32_t payload = 64;
+        uint32_t rate = 0;              // messages/s offered per direction, 0 keeps the send queue full
+        uint32_t retry_ms = 1000;
+        uint32_t retries = 3;
+        uint32_t queue = 8;
+        uint32_t window = 8;
+        uint32_t ack_delay_ms = 5;
+        transport::framing_t framing = transport::framing_t::magic;
+        uint32_t background = 0;        // payload of the messages A keeps queued on background_channel, 0 for none
+        transport::channel_t background_channel = transport::channel_t::diagnostics;
+        bool bidirectional = false;
+        uint32_t keepalive_ms = 0;      // keepalive interval of both ends, 0 for none
+        uint32_t keepalive_misses = 3;
+        uint32_t cut_at_ms = 0;         // the link is cut for cut_ms from then on, 0 for never
+        uint32_t cut_ms = 0;
+        double max_seconds = 24 * 3600;
+    };
+
+    struct message_header_t
+    {
+        int64_t sent_us;
+        uint32_t index;
+    };
+
+    template<typename TConnection>
+    struct flow_t
+    {
+        const char* name;
+        TConnection& sender;
+        uint32_t offered = 0;
+        int64_t next_offer_us = 0;
+        std::array<uint32_t, 3> results{};  // by transport::send_result_t, as the sender saw them
+
+        uint32_t delivered = 0;
+        uint32_t duplicates = 0;
+        uint32_t background_offered = 0;
+        uint32_t background_delivered = 0;
+        uint64_t delivered_bytes = 0;
+        int64_t last_delivery_us = 0;
+        std::unordered_set<uint32_t> seen;
+        std::vector<int64_t> latencies_us;
+
+        void on_receive(std::span<const uint8_t> data)
+        {
+            message_header_t header;
+            if (data.size() < sizeof(header))
+                return;
+
+            std::memcpy(&header, data.data(), sizeof(header));
+
+            if (header.index & BACKGROUND)
+            {
+                background_delivered++;
+                return;
+            }
+
+            if (!seen.insert(header.index).second)
+            {
+                duplicates++;
+                return;
+            }
+
+            auto now = host::clock_now_us();
+            delivered++;
+            delivered_bytes += data.size();
+            last_delivery_us = now;
+            latencies_us.emplace_back(now - header.sent_us);
+        }
+    };
+
+    int64_t percentile(const std::vector<int64_t>& sorted, double p)
+    {
+        if (sorted.empty())
+            return 0;
+
+        auto index = static_cast<std::size_t>(p * (sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+
+    void print_link(const options_t& o)
+    {
+        std::printf("link: %u bit/s (%u bits/byte), latency %.2f ms +- %.2f ms, byte loss %.4f%%, bit flips %.4f%%, chunks %zu..%zu, seed %u\n",
+            o.link.bits_per_second, o.link.bits_per_byte, o.link.latency_us / 1000.0, o.link.jitter_us / 1000.0,
+            o.link.byte_loss * 100, o.link.bit_flip * 100, o.link.min_chunk, o.link.max_chunk, o.link.seed);
+        if (o.link.rx_buffer)
+            std::printf("receiver: %zu B buffer read at %s\n", o.link.rx_buffer,
+                o.link.rx_bytes_per_second ? (std::to_string(o.link.rx_bytes_per_second) + " B/s").c_str() : "once it arrives");
+        std::printf("sender: payload %u B, %u messages, %s, retry %u ms x %u, queue %u, window %u, ack delay %u ms, %s framing\n",
+            o.payload, o.messages, o.rate ? (std::to_string(o.rate) + " msg/s").c_str() : "saturating",
+            o.retry_ms, o.retries, o.queue, o.window, o.ack_delay_ms, FRAMING_NAMES[static_cast<std::size_t>(o.framing)]);
+        if (o.background)
+            std::printf("background: %u B messages from A on the %s channel\n", o.background, CHANNEL_NAMES[static_cast<std::size_t>(o.background_channel)]);
+        if (o.keepalive_ms)
+            std::printf("keepalive: every %u ms, link down after %u misses\n", o.keepalive_ms, o.keepalive_misses);
+        if (o.cut_ms)
+            std::printf("cut: from %u ms to %u ms\n", o.cut_at_ms, o.cut_at_ms + o.cut_ms);
+    }
+
+    // What an end agreed on with its peer through the hello exchange.
+    template<typename TConnection>
+    void print_settings(const char* name, const TConnection& connection)
+    {
+        auto s = connection.settings();
+        if (!s)
+        {
+            std::printf("  %s          no hello from the peer\n", name);
+            return;
+        }
+
+        std::printf("  %s          version %u, window %zu, message %zu B, features %04x\n",
+            name, s->version, s->window, s->max_message, s->features);
+    }
+
+    // Link state changes one end saw, in ms since the start.
+    struct link_events_t
+    {
+        const char* name;
+        std::vector<std::pair<int64_t, bool>> changes;
+
+        void print() const
+        {
+            std::printf("  %s link  ", name);
+            if (changes.empty())
+                std::printf(" never came up");
+            for (const auto& [at_us, up]: changes)
+                std::printf(" %s at %.1f ms", up ? "up" : "down", at_us / 1000.0);
+            std::printf("\n");
+        }
+    };
+
+    template<typename TFlow, typename TConnection>
+    void print_flow(TFlow& flow, const TConnection& receiver, const sim::direction_stats_t& wire, const sim::link_config_t& link, int64_t start_us)
+    {
+        auto stats = flow.sender.stats();
+        auto rx = receiver.stats();
+        auto seconds = std::max<int64_t>(flow.last_delivery_us - start_us, 1) / 1e6;
+
+        std::ranges::sort(flow.latencies_us);
+        const auto& l = flow.latencies_us;
+
+        std::printf("\n%s\n", flow.name);
+        std::printf("  messages   offered %u, delivered %u, duplicates %u, lost %u\n",
+            flow.offered, flow.delivered, flow.duplicates, flow.offered - flow.delivered);
+        std::printf("  results    acked %u, timed out %u, dropped %u\n", flow.results[0], flow.results[1], flow.results[2]);
+        if (flow.background_offered)
+            std::printf("  background offered %u, delivered %u\n", flow.background_offered, flow.background_delivered);
+        std::printf("  goodput    %.2f KiB/s, %.1f msg/s over %.3f s\n",
+            flow.delivered_bytes / 1024.0 / seconds, flow.delivered / seconds, seconds);
+        std::printf("  sender     frames %u, retransmissions %u, acked %u, timed out %u, queue full %u, window %u, fragmented %u\n",
+            stats.tx_frames, stats.retransmissions, stats.acked, stats.timed_out, stats.queue_full, stats.tx_window, stats.tx_fragmented);
+        std::printf("  rtt        srtt %.2f ms, rttvar %.2f ms, rto %.2f ms, %u samples\n",
+            stats.srtt_us / 1000.0, stats.rttvar_us / 1000.0, stats.rto_us / 1000.0, stats.rtt_samples);
+        std::printf("  receiver   out of order %u, duplicates %u, acks %u, piggybacked acks %u\n",
+            rx.rx_out_of_order, rx.rx_duplicates, rx.tx_acks, rx.tx_piggybacked_acks);
+        if (stats.tx_fragmented)
+            std::printf("  fragments  reassembled %u, dropped %u, timed out %u\n",
+                rx.rx_reassembled, rx.rx_fragments_dropped, rx.rx_reassembly_timeouts);
+        std::printf("  latency    p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+            percentile(l, 0.5) / 1000.0, percentile(l, 0.9) / 1000.0, percentile(l, 0.99) / 1000.0,
+            (l.empty() ? 0 : l.back()) / 1000.0);
+        std::printf("  wire       written %llu B, delivered %llu B, lost %llu B, bits flipped %llu, chunks %llu\n",
+            static_cast<unsigned long long>(wire.bytes_written), static_cast<unsigned long long>(wire.bytes_delivered),
+            static_cast<unsigned long long>(wire.bytes_lost), static_cast<unsigned long long>(wire.bits_flipped),
+            static_cast<unsigned long long>(wire.chunks));
+        std::printf("  efficiency %.1f%% of the bytes written were delivered payload\n",
+            wire.bytes_written ? 100.0 * flow.delivered_bytes / wire.bytes_written : 0.0);
+        // bytes the receiver had to throw away while resyncing, and how long that much traffic takes on the link
+        std::printf("  resync     crc errors %u, dropped %u B (%.2f ms of link time, %.1f B per error)\n",
+            rx.rx_crc_errors, rx.rx_dropped_bytes, rx.rx_dropped_bytes * link.bits_per_byte * 1000.0 / link.bits_per_second,
+            rx.rx_crc_errors ? static_cast<double>(rx.rx_dropped_bytes) / rx.rx_crc_errors : 0.0);
+        std::printf("  fec        repaired %u frames, %u beyond repair\n", rx.rx_fec_corrected, rx.rx_fec_uncorrectable);
+        if (link.rx_buffer)
+            std::printf("  flow       receiver overflows %u (%llu B lost), credit %u B, sender waited for credit %u times\n",
+                rx.rx_overflows, static_cast<unsigned long long>(wire.bytes_overflowed), stats.tx_credit, stats.tx_credit_stalls);
+    }
+
+    template<std::size_t QueueSize>
+    int run(const options_t& o)
+    {
+        using connection_t = transport::frame_host_connection_t<sim::endpoint_t, MAGIC, 16 * 1024, 256, QueueSize, MAX_WINDOW, MAX_MESSAGE>;
+
+        host::clock_set_virtual(true);
+        const auto start_us = host::clock_now_us();
+        const auto max_us = start_us + static_cast<int64_t>(o.max_seconds * 1e6);
+        const auto offer_interval_us = o.rate ? 1'000'000 / static_cast<int64_t>(o.rate) : 0;
+
+        auto reverse = o.link;
+        reverse.seed = o.link.seed ^ 0x9e3779b9u;
+
+        sim::link_t link(o.link, reverse);
+        auto a = std::make_unique<connection_t>(link.a());
+        auto b = std::make_unique<connection_t>(link.b());
+        a->init(false);
+        b->init(false);
+        a->set_framing(o.framing);
+        b->set_framing(o.framing);
+        a->set_max_window(o.window);
+        b->set_max_window(o.window);
+        a->set_ack_delay(o.ack_delay_ms);
+        b->set_ack_delay(o.ack_delay_ms);
+        a->set_keepalive(o.keepalive_ms, o.keepalive_misses);
+        b->set_keepalive(o.keepalive_ms, o.keepalive_misses);
+
+        link_events_t a_link{ "A" };
+        link_events_t b_link{ "B" };
+        a->register_link_handler([&](bool up) { a_link.changes.emplace_back(host::clock_now_us() - start_us, up); });
+        b->register_link_handler([&](bool up) { b_link.changes.emplace_back(host::clock_now_us() - start_us, up); });
+
+        const auto cut_at_us = start_us + static_cast<int64_t>(o.cut_at_ms) * 1000;
+        const auto cut_end_us = cut_at_us + static_cast<int64_t>(o.cut_ms) * 1000;
+
+        flow_t<connection_t> a_to_b{ .name = "A -> B", .sender = *a, .next_offer_us = start_us };
+        flow_t<connection_t> b_to_a{ .name = "B -> A", .sender = *b, .next_offer_us = start_us };
+
+        b->register_data_handler([&](std::span<const uint8_t> d){ a_to_b.on_receive(d); });
+        a->register_data_handler([&](std::span<const uint8_t> d){ b_to_a.on_receive(d); });
+
+        std::vector<flow_t<connection_t>*> flows{ &a_to_b };
+        if (o.bidirectional)
+            flows.emplace_back(&b_to_a);
+
+        std::vector<uint8_t> payload(std::max<std::size_t>(o.payload, sizeof(message_header_t)));
+
+        std::vector<uint8_t> background(std::max<std::size_t>(o.background, sizeof(message_header_t)));
+
+        // without a rate the queue is kept full, a message is offered once all of its fragments fit
+        const auto frames = connection_t::frame_count(payload.size());
+        const auto background_frames = connection_t::frame_count(background.size());
+        if (std::max(frames, background_frames) > QueueSize)
+        {
+            std::fprintf(stderr, "a %zu B message takes %zu frames, more than --queue %zu\n", std::max(payload.size(), background.size()), std::max(frames, background_frames), QueueSize);
+            return 1;
+        }
+
+        auto wall_start = std::chrono::steady_clock::now();
+
+        while (true)
+        {
+            auto now = host::clock_now_us();
+
+            link.deliver_due();
+
+            auto next = NEVER;
+
+            if (o.cut_ms)
+            {
+                link.set_cut(now >= cut_at_us && now < cut_end_us);
+                if (now < cut_end_us)
+                    next = now < cut_at_us ? cut_at_us : cut_end_us;
+            }
+
+            for (auto flow: flows)
+            {
+                while (flow->offered < o.messages)
+                {
+                    if (o.rate ? now < flow->next_offer_us : flow->sender.pending(transport::channel_t::control) + frames > QueueSize || flow->sender.free_slots(transport::channel_t::control) < frames)
+                        break;
+
+                    message_header_t header{ now, flow->offered++ };
+                    std::memcpy(payload.data(), &header, sizeof(header));
+                    // with a rate the queue can be full, the message is dropped rather than stalling the simulation
+                    flow->sender.send(payload, o.retry_ms, o.retries, transport::channel_t::control, transport::full_policy_t::drop,
+                        [flow](transport::send_result_t result) { flow->results[static_cast<std::size_t>(result)]++; });
+                    flow->next_offer_us += offer_interval_us;
+                }
+
+                // kept queued while the measured messages are offered, ahead of them when it is the control channel
+                while (o.background && flow == &a_to_b && flow->offered < o.messages
+                    && flow->sender.pending(o.background_channel) + background_frames <= QueueSize && flow->sender.free_slots(o.background_channel) >= background_frames)
+                {
+                    message_header_t header{ now, BACKGROUND | flow->background_offered++ };
+                    std::memcpy(background.data(), &header, sizeof(header));
+                    flow->sender.send(background, o.retry_ms, o.retries, o.background_channel);
+                }
+
+                if (o.rate && flow->offered < o.messages)
+                    next = std::min(next, flow->next_offer_us);
+            }
+
+            for (auto connection: { a.get(), b.get() })
+            {
+                if (auto wait = connection->poll(); wait != portMAX_DELAY)
+                    next = std::min(next, now + static_cast<int64_t>(pdTICKS_TO_MS(wait)) * 1000);
+            }
+
+            next = std::min(next, link.next_event_us());
+
+            // keepalives never let the link go idle, the run ends once every message has a result and the cut is over
+            auto finished = std::ranges::all_of(flows, [&](auto flow) { return flow->results[0] + flow->results[1] + flow->results[2] == o.messages; });
+            if (o.keepalive_ms && finished && now >= cut_end_us)
+                break;
+
+            if (next == NEVER || next > max_us)
+                break;
+
+            host::clock_advance_to(next);
+        }
+
+        auto wall = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wall_start).count();
+
+        print_link(o);
+        print_flow(a_to_b, *b, link.a_to_b(), o.link, start_us);
+        if (o.bidirectional)
+            print_flow(b_to_a, *a, link.b_to_a(), reverse, start_us);
+
+        std::printf("\nsettings\n");
+        print_settings("A", *a);
+        print_settings("B", *b);
+
+        if (o.keepalive_ms)
+        {
+            auto stats_a = a->stats();
+            auto stats_b = b->stats();
+            std::printf("\nkeepalive\n");
+            std::printf("  pings      A %u, B %u, link downs A %u, B %u\n", stats_a.tx_keepalives, stats_b.tx_keepalives, stats_a.link_downs, stats_b.link_downs);
+            a_link.print();
+            b_link.print();
+        }
+
+        std::printf("\nsimulated %.3f s in %.1f ms wall time\n", (host::clock_now_us() - start_us) / 1e6, wall);
+
+        return 0;
+    }
+
+    void usage(const char* name)
+    {
+        std::fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --preset uart|spp     link defaults (uart)\n"
+            "  --baud N              link bits per second\n"
+            "  --latency-ms N        one way latency\n"
+            "  --jitter-ms N         extra random latency, 0..N\n"
+            "  --loss P              byte loss probability\n"
+            "  --flip P              probability of a bit flip per byte\n"
+            "  --chunk-min N         smallest on_receive chunk\n"
+            "  --chunk-max N         largest on_receive chunk\n"
+            "  --seed N              random seed\n"
+            "  --rx-buffer N         receive buffer of each end, flushed when it overflows, 0 for none (0)\n"
+            "  --rx-rate N           bytes/s each end reads from that buffer, 0 reads at once (0)\n"
+            "  --messages N          messages per direction (2000)\n"
+            "  --payload N           payload bytes per message, 12..8192, above 247 sent in fragments (64)\n"
+            "  --rate N              offered messages/s, 0 keeps the queue full (0)\n"
+            "  --retry-ms N          retry_interval_ms passed to send (1000)\n"
+            "  --retries N           retry_count passed to send (3)\n"
+            "  --queue 1|2|4|8|16|32 SEND_QUEUE_SIZE (8)\n"
+            "  --window N            frames in flight, 1..16, 1 is stop-and-wait (8)\n"
+            "  --ack-delay-ms N      longest an in-order frame waits for its ack, 0 acks each one (5)\n"
+            "  --bidirectional       run the same flow from B to A at the same time\n"
+            "  --framing NAME        frame format on the link, magic, cobs or fec (magic)\n"
+            "  --background N        A also keeps N-byte messages queued while it sends the measured ones\n"
+            "  --background-channel NAME  channel of those messages, control, assets or diagnostics (diagnostics)\n"
+            "  --keepalive-ms N      ping after N ms without a frame from the peer, 0 for none (0)\n"
+            "  --keepalive-misses N  unanswered pings before the link counts as down (3)\n"
+            "  --cut-at-ms N         cut the link in both directions N ms into the run\n"
+            "  --cut-ms N            for N ms\n"
+            "  --max-seconds N       stop after N virtual seconds\n"
+            "  --verbose             enable device logging\n", name);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    options_t o;
+    esp_log_level_set("*", ESP_LOG_NONE);
+
+    for (auto i = 1; i < argc; i++)
+    {
+        std::string_view arg = argv[i];
+        auto value = [&]{ return i + 1 < argc ? std::string(argv[++i]) : std::string("0"); };
+
+        if (arg == "--preset")
+        {
+            auto seed = o.link.seed;
+            auto preset = value();
+            o.link = preset == "spp" ? sim::link_config_t::spp() : sim::link_config_t::uart();
+            o.link.seed = seed;
+        }
+        else if (arg == "--baud") o.link.bits_per_second = std::stoul(value());
+        else if (arg == "--latency-ms") o.link.latency_us = static_cast<uint32_t>(std::stod(value()) * 1000);
+        else if (arg == "--jitter-ms") o.link.jitter_us = static_cast<uint32_t>(std::stod(value()) * 1000);
+        else if (arg == "--loss") o.link.byte_loss = std::stod(value());
+        else if (arg == "--flip") o.link.bit_flip = std::stod(value());
+        else if (arg == "--chunk-min") o.link.min_chunk = std::max<std::size_t>(1, std::stoul(value()));
+        else if (arg == "--chunk-max") o.link.max_chunk = std::max<std::size_t>(1, std::stoul(value()));
+        else if (arg == "--seed") o.link.seed = std::stoul(value());
+        else if (arg == "--rx-buffer") o.link.rx_buffer = std::stoul(value());
+        else if (arg == "--rx-rate") o.link.rx_bytes_per_second = std::stoul(value());
+        else if (arg == "--messages") o.messages = std::stoul(value());
+        else if (arg == "--payload") o.payload = std::stoul(value());
+        else if (arg == "--rate") o.rate = std::stoul(value());
+        else if (arg == "--retry-ms") o.retry_ms = std::stoul(value());
+        else if (arg == "--retries") o.retries = std::max<uint32_t>(1, std::stoul(value()));
+        else if (arg == "--queue") o.queue = std::stoul(value());
+        else if (arg == "--window") o.window = std::stoul(value());
+        else if (arg == "--ack-delay-ms") o.ack_delay_ms = std::stoul(value());
+        else if (arg == "--bidirectional") o.bidirectional = true;
+        else if (arg == "--framing") o.framing = parse_framing(value());
+        else if (arg == "--background") o.background = std::stoul(value());
+        else if (arg == "--background-channel") o.background_channel = parse_channel(value());
+        else if (arg == "--keepalive-ms") o.keepalive_ms = std::stoul(value());
+        else if (arg == "--keepalive-misses") o.keepalive_misses = std::max<uint32_t>(1, std::stoul(value()));
+        else if (arg == "--cut-at-ms") o.cut_at_ms = std::stoul(value());
+        else if (arg == "--cut-ms") o.cut_ms = std::stoul(value());
+        else if (arg == "--max-seconds") o.max_seconds = std::stod(value());
+        else if (arg == "--verbose") esp_log_level_set("*", ESP_LOG_INFO);
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (o.payload < sizeof(message_header_t) || o.payload > MAX_MESSAGE || o.background > MAX_MESSAGE || o.window < 1 || o.window > MAX_WINDOW)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    switch (o.queue)
+    {
+        case 1: return run<1>(o);
+        case 2: return run<2>(o);
+        case 4: return run<4>(o);
+        case 8: return run<8>(o);
+        case 16: return run<16>(o);
+        case 32: return run<32>(o);
+        default:
+            usage(argv[0]);
+            return 1;
+    }
+}
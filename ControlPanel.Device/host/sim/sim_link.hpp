@@ -0,0 +1,300 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "host_clock.hpp"
+
+namespace sim
+{
+    // One direction of a simulated serial link. Times are in virtual microseconds (host::clock_now_us).
+    struct link_config_t
+    {
+        uint32_t bits_per_second = 921600;
+        uint32_t bits_per_byte = 10;    // 8N1 framing on UART
+        uint32_t latency_us = 0;
+        uint32_t jitter_us = 0;
+        double byte_loss = 0;           // probability that a byte never arrives
+        double bit_flip = 0;            // probability that a byte arrives with one bit flipped
+        std::size_t min_chunk = 1;      // bytes handed to on_receive per callback
+        std::size_t max_chunk = 120;
+        uint32_t seed = 1;
+        // receive buffer of the far end, flushed whole when a chunk does not fit like the UART driver's ring
+        // buffer; 0 hands chunks over as they arrive
+        std::size_t rx_buffer = 0;
+        uint32_t rx_bytes_per_second = 0;   // how fast the far end reads its buffer, 0 reads it right away
+
+        static link_config_t uart(uint32_t baud = 921600)
+        {
+            return link_config_t{ .bits_per_second = baud, .bits_per_byte = 10, .latency_us = 100, .min_chunk = 1, .max_chunk = 120 };
+        }
+
+        // Classic BT SPP as seen from the ESP32: ~180 KiB/s goodput, tens of ms of scheduling latency, L2CAP-sized reads.
+        static link_config_t spp()
+        {
+            return link_config_t{ .bits_per_second = 1'500'000, .bits_per_byte = 8, .latency_us = 15'000, .jitter_us = 10'000, .min_chunk = 1, .max_chunk = 990 };
+        }
+    };
+
+    struct direction_stats_t
+    {
+        uint64_t bytes_written = 0;
+        uint64_t bytes_delivered = 0;
+        uint64_t bytes_lost = 0;
+        uint64_t bits_flipped = 0;
+        uint64_t chunks = 0;
+        uint64_t overflows = 0;
+        uint64_t bytes_overflowed = 0;      // buffered or arriving when the receive buffer overflowed
+    };
+
+    class link_t;
+
+    // frame_transport_t implementation for one end of a link_t.
+    class endpoint_t
+    {
+    public:
+        endpoint_t(link_t& link, std::size_t side) : _link(link), _side(side) {}
+
+        void write(std::span<uint8_t> data);
+
+        void on_receive(std::function<void(std::span<uint8_t>)> f)
+        {
+            _on_receive = std::move(f);
+        }
+
+        // rx_buffered_transport_t
+        std::size_t rx_buffer_size() const;
+        uint32_t rx_overflows() const;
+
+    private:
+        friend class link_t;
+
+        link_t& _link;
+        std::size_t _side;
+        std::function<void(std::span<uint8_t>)> _on_receive;
+    };
+
+    // Two endpoints connected by a pair of independent lossy directions. Nothing happens on its own:
+    // the owner advances the virtual clock to next_event_us() and calls deliver_due().
+    class link_t
+    {
+    public:
+        link_t(const link_config_t& a_to_b, const link_config_t& b_to_a)
+            : _endpoints{ endpoint_t{*this, 0}, endpoint_t{*this, 1} }
+            , _directions{ direction_t{a_to_b}, direction_t{b_to_a} }
+        {
+        }
+
+        endpoint_t& a() { return _endpoints[0]; }
+        endpoint_t& b() { return _endpoints[1]; }
+
+        const direction_stats_t& a_to_b() const { return _directions[0].stats; }
+        const direction_stats_t& b_to_a() const { return _directions[1].stats; }
+
+        // While cut, whatever either end writes is lost, like a dropped Bluetooth connection. Bytes already
+        // on the wire still arrive.
+        void set_cut(bool cut) { _cut = cut; }
+
+        int64_t next_event_us() const
+        {
+            auto ret = _events.empty() ? std::numeric_limits<int64_t>::max() : _events.top().at;
+            for (const auto& d: _directions)
+            {
+                if (!d.rx_queue.empty())
+                    ret = std::min(ret, d.rx_read_at);
+            }
+            return ret;
+        }
+
+        void deliver_due()
+        {
+            auto now = host::clock_now_us();
+
+            while (true)
+            {
+                if (!_events.empty() && _events.top().at <= now)
+                {
+                    auto event = _events.top();
+                    _events.pop();
+                    arrive(event.from, std::move(event.bytes));
+                    continue;
+                }
+
+                if (!read_due(0, now) && !read_due(1, now))
+                    break;
+            }
+        }
+
+    private:
+        friend class endpoint_t;
+
+        struct direction_t
+        {
+            explicit direction_t(const link_config_t& c) : cfg(c), rng(c.seed) {}
+
+            link_config_t cfg;
+            std::mt19937 rng;
+            double wire_free_at = 0;
+            int64_t last_delivery = 0;
+            direction_stats_t stats;
+
+            std::deque<std::vector<uint8_t>> rx_queue;
+            std::size_t rx_buffered = 0;
+            int64_t rx_read_at = 0;     // the far end is done reading the previous chunk
+        };
+
+        struct event_t
+        {
+            int64_t at;
+            uint64_t order;
+            std::size_t from;
+            std::vector<uint8_t> bytes;
+
+            bool operator>(const event_t& other) const
+            {
+                return at != other.at ? at > other.at : order > other.order;
+            }
+        };
+
+        void deliver(std::size_t from, std::span<uint8_t> bytes)
+        {
+            auto& to = _endpoints[1 - from];
+            _directions[from].stats.bytes_delivered += bytes.size();
+
+            if (to._on_receive) to._on_receive(bytes);
+        }
+
+        void arrive(std::size_t from, std::vector<uint8_t> bytes)
+        {
+            auto& d = _directions[from];
+            if (d.cfg.rx_buffer == 0)
+            {
+                deliver(from, bytes);
+                return;
+            }
+
+            if (d.rx_buffered + bytes.size() > d.cfg.rx_buffer)
+            {
+                d.stats.overflows++;
+                d.stats.bytes_overflowed += d.rx_buffered + bytes.size();
+                d.rx_queue.clear();
+                d.rx_buffered = 0;
+                return;
+            }
+
+            d.rx_buffered += bytes.size();
+            d.rx_queue.emplace_back(std::move(bytes));
+        }
+
+        // Hands the oldest buffered chunk to the far end once it is done with the one before.
+        bool read_due(std::size_t from, int64_t now)
+        {
+            auto& d = _directions[from];
+            if (d.rx_queue.empty() || d.rx_read_at > now)
+                return false;
+
+            auto bytes = std::move(d.rx_queue.front());
+            d.rx_queue.pop_front();
+            d.rx_buffered -= bytes.size();
+
+            if (d.cfg.rx_bytes_per_second)
+                d.rx_read_at = now + static_cast<int64_t>(std::ceil(bytes.size() * 1e6 / d.cfg.rx_bytes_per_second));
+
+            deliver(from, bytes);
+            return true;
+        }
+
+        void transmit(std::size_t from, std::span<const uint8_t> data)
+        {
+            auto& d = _directions[from];
+            auto& cfg = d.cfg;
+
+            const auto now = static_cast<double>(host::clock_now_us());
+            const auto byte_us = static_cast<double>(cfg.bits_per_byte) * 1e6 / cfg.bits_per_second;
+            const auto start = std::max(now, d.wire_free_at);
+
+            std::uniform_int_distribution<std::size_t> chunk_size(cfg.min_chunk, std::max(cfg.min_chunk, cfg.max_chunk));
+            std::uniform_int_distribution<uint32_t> jitter(0, cfg.jitter_us);
+            std::uniform_int_distribution<int> bit(0, 7);
+            std::bernoulli_distribution lose(cfg.byte_loss);
+            std::bernoulli_distribution flip(cfg.bit_flip);
+
+            d.stats.bytes_written += data.size();
+            if (_cut)
+            {
+                d.stats.bytes_lost += data.size();
+                return;
+            }
+
+            for (std::size_t offset = 0; offset < data.size();)
+            {
+                auto n = std::min(chunk_size(d.rng), data.size() - offset);
+
+                std::vector<uint8_t> chunk;
+                chunk.reserve(n);
+
+                for (auto b: data.subspan(offset, n))
+                {
+                    if (cfg.byte_loss > 0 && lose(d.rng))
+                    {
+                        d.stats.bytes_lost++;
+                        continue;
+                    }
+
+                    if (cfg.bit_flip > 0 && flip(d.rng))
+                    {
+                        b ^= static_cast<uint8_t>(1u << bit(d.rng));
+                        d.stats.bits_flipped++;
+                    }
+
+                    chunk.emplace_back(b);
+                }
+
+                offset += n;
+
+                // a chunk is readable once its last byte is off the wire; jitter never reorders bytes
+                auto on_wire = static_cast<int64_t>(std::ceil(start + offset * byte_us));
+                auto at = std::max(on_wire + cfg.latency_us + (cfg.jitter_us ? jitter(d.rng) : 0), d.last_delivery);
+                d.last_delivery = at;
+
+                if (chunk.empty())
+                    continue;
+
+                d.stats.chunks++;
+                _events.push(event_t{ at, _order++, from, std::move(chunk) });
+            }
+
+            d.wire_free_at = start + data.size() * byte_us;
+        }
+
+        std::array<endpoint_t, 2> _endpoints;
+        std::array<direction_t, 2> _directions;
+        std::priority_queue<event_t, std::vector<event_t>, std::greater<>> _events;
+        uint64_t _order = 0;
+        bool _cut = false;
+    };
+
+    inline void endpoint_t::write(std::span<uint8_t> data)
+    {
+        _link.transmit(_side, data);
+    }
+
+    inline std::size_t endpoint_t::rx_buffer_size() const
+    {
+        return _link._directions[1 - _side].cfg.rx_buffer;
+    }
+
+    inline uint32_t endpoint_t::rx_overflows() const
+    {
+        return static_cast<uint32_t>(_link._directions[1 - _side].stats.overflows);
+    }
+}
@@ -0,0 +1,622 @@
+#include <array>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "esp_log.h"
+#include "host_clock.hpp"
+
+#include "protocol/frame_host_connection.hpp"
+
+#include "test.hpp"
+
+namespace
+{
+    constexpr std::array<uint8_t, 2> MAGIC{0x19, 0x16};
+
+    using bytes_t = std::vector<uint8_t>;
+    using transport::frame_type_t;
+    using transport::send_result_t;
+
+    // Collects what the connection writes, the test hands frames to its receive callback.
+    struct loopback_transport_t
+    {
+        void write(std::span<uint8_t> data)
+        {
+            written.insert(written.end(), data.begin(), data.end());
+        }
+
+        void on_receive(std::function<void(std::span<uint8_t>)> f)
+        {
+            receive = std::move(f);
+        }
+
+        std::size_t rx_buffer_size() const
+        {
+            return rx_buffer;
+        }
+
+        uint32_t rx_overflows() const
+        {
+            return 0;
+        }
+
+        bytes_t written;
+        std::function<void(std::span<uint8_t>)> receive;
+        std::size_t rx_buffer = 0;
+    };
+
+    // A window of 16 makes a delayed ack cover 4 frames, frames of 64 bytes make messages of a few hundred fragmented.
+    using connection_type = transport::frame_host_connection_t<loopback_transport_t, MAGIC, 4096, 64, 8, 16, 512>;
+    using framer_type = transport::framer_t<MAGIC, 1024>;
+
+    struct wire_frame_t
+    {
+        uint16_t seq;
+        frame_type_t type;
+        bytes_t data;
+    };
+
+    constexpr uint16_t feature_bits(std::initializer_list<transport::link_feature_t> features)
+    {
+        uint16_t ret = 0;
+        for (auto feature: features)
+            ret |= static_cast<uint16_t>(feature);
+        return ret;
+    }
+
+    constexpr uint16_t BRIDGE_FEATURES = feature_bits({ transport::link_feature_t::chunked, transport::link_feature_t::window,
+        transport::link_feature_t::fragments, transport::link_feature_t::credit, transport::link_feature_t::ping });
+
+    // What a current bridge answers with.
+    transport::hello_t bridge_hello()
+    {
+        return transport::hello_t{
+            .version = transport::hello_t::VERSION,
+            .flags = transport::hello_t::REPLY,
+            .max_frame = 64,
+            .rx_frame_buffer = 1024,
+            .rx_buffer = 0,
+            .window = 16,
+            .max_message = 512,
+            .framings = transport::framing_mask(transport::framing_t::magic),
+            .compressions = 0,
+            .pixel_formats = 0,
+            .features = BRIDGE_FEATURES
+        };
+    }
+
+    std::vector<wire_frame_t> of_type(const std::vector<wire_frame_t>& frames, frame_type_t type)
+    {
+        std::vector<wire_frame_t> ret;
+        for (const auto& frame: frames)
+        {
+            if (frame.type == type)
+                ret.push_back(frame);
+        }
+        return ret;
+    }
+
+    std::vector<uint16_t> seqs(const std::vector<wire_frame_t>& frames)
+    {
+        std::vector<uint16_t> ret;
+        for (const auto& frame: frames)
+            ret.push_back(frame.seq);
+        return ret;
+    }
+
+    bytes_t message(uint8_t id, std::size_t size = 10)
+    {
+        return bytes_t(size, id);
+    }
+
+    // The other end of the link, played by the test: it sees every frame the connection writes and sends it frames
+    // of its own. Nothing runs unless the test polls, on the virtual clock nothing times out unless it advances.
+    struct peer_t
+    {
+        loopback_transport_t transport;
+        std::unique_ptr<connection_type> connection = std::make_unique<connection_type>(transport);
+        std::unique_ptr<framer_type> rx = std::make_unique<framer_type>();
+        std::unique_ptr<framer_type> tx = std::make_unique<framer_type>();
+        std::vector<bytes_t> delivered;
+
+        peer_t()
+        {
+            connection->register_data_handler([this](std::span<const uint8_t> data) { delivered.emplace_back(data.begin(), data.end()); });
+            connection->init(false);
+        }
+
+        // Frames the connection wrote since the last call.
+        std::vector<wire_frame_t> take()
+        {
+            std::vector<wire_frame_t> ret;
+            rx->feed(std::span<const uint8_t>(transport.written), [&](const transport::frame_t& frame)
+            {
+                ret.push_back(wire_frame_t{ frame.seq, frame.type, bytes_t(frame.data.begin(), frame.data.end()) });
+            });
+            transport.written.clear();
+            return ret;
+        }
+
+        std::vector<wire_frame_t> poll()
+        {
+            connection->poll();
+            return take();
+        }
+
+        void send(uint16_t seq, frame_type_t type, std::span<const uint8_t> data = {})
+        {
+            bytes_t buffer(framer_type::calc_max_frame_size(data.size()));
+            auto size = tx->to_bytes(buffer, transport::frame_t{ seq, type, data });
+            transport.receive(std::span(buffer).first(size));
+        }
+
+        void ack(uint16_t seq, std::optional<transport::credit_t> credit = {})
+        {
+            std::array<uint8_t, transport::credit_t::SIZE> payload;
+            if (credit)
+                credit->to_bytes(payload);
+            send(seq, frame_type_t::ack, std::span(payload).first(credit ? payload.size() : 0));
+        }
+
+        void hello(const transport::hello_t& hello)
+        {
+            std::array<uint8_t, transport::hello_t::SIZE> payload;
+            hello.to_bytes(payload);
+            send(0, frame_type_t::hello, payload);
+        }
+
+        // Asks the connection for a window as a sender does, from then on it acks cumulatively.
+        void request_window(uint8_t size, uint16_t next_seq = 1)
+        {
+            std::array<uint8_t, transport::window_request_t::SIZE> payload;
+            transport::window_request_t{ size, next_seq }.to_bytes(payload);
+            send(next_seq, frame_type_t::window, payload);
+            CHECK(of_type(take(), frame_type_t::window_ack).size() == 1);
+        }
+
+        void advance_us(int64_t us)
+        {
+            host::clock_advance_to(host::clock_now_us() + us);
+        }
+
+        void advance_ms(int64_t ms)
+        {
+            advance_us(ms * 1000);
+        }
+
+        // Answers the connection's hello with this one and its window request with window, as a bridge does.
+        void connect(const transport::hello_t& answer = bridge_hello(), uint8_t window = 4, std::optional<transport::credit_t> credit = {})
+        {
+            CHECK(of_type(poll(), frame_type_t::hello).size() == 1);
+            hello(answer);
+
+            auto requests = of_type(poll(), frame_type_t::window);
+            CHECK(requests.size() == 1);
+            if (requests.empty())
+                return;
+
+            std::array<uint8_t, 1 + transport::credit_t::SIZE> accepted{ window };
+            if (credit)
+                credit->to_bytes(std::span(accepted).subspan<1>());
+            send(requests[0].seq, frame_type_t::window_ack, std::span(accepted).first(credit ? accepted.size() : 1));
+            CHECK(connection->stats().tx_window == window);
+        }
+    };
+
+    // Up to the window of frames go out ahead of their acks, an ack covers every frame up to its seq and makes room
+    // for that many of the queued ones.
+    void test_window()
+    {
+        peer_t peer;
+        peer.connect();
+
+        std::vector<send_result_t> results;
+        for (uint8_t i = 0; i < 6; i++)
+            peer.connection->send(message(i), 1000, 3, transport::channel_t::control, transport::full_policy_t::wait,
+                [&](send_result_t result) { results.push_back(result); });
+
+        auto frames = of_type(peer.poll(), frame_type_t::data);
+        CHECK((seqs(frames) == std::vector<uint16_t>{ 1, 2, 3, 4 }));
+        CHECK(frames.size() == 4 && frames[3].data == message(3));
+        CHECK(peer.connection->pending() == 2);
+        CHECK(peer.poll().empty());
+
+        peer.ack(3);
+        frames = of_type(peer.poll(), frame_type_t::data);
+        CHECK((seqs(frames) == std::vector<uint16_t>{ 5, 6 }));
+        CHECK(peer.connection->pending() == 0);
+        CHECK(results == std::vector<send_result_t>(3, send_result_t::acked));
+        CHECK(peer.connection->stats().acked == 3);
+
+        peer.ack(6);
+        CHECK(peer.poll().empty());
+        CHECK(results == std::vector<send_result_t>(6, send_result_t::acked));
+        CHECK(peer.connection->stats().retransmissions == 0);
+    }
+
+    // The receiver drops everything behind a lost frame and repeats its last ack for each of those frames, the
+    // sender goes back to the lost one. The last frame of a burst has no frames behind it, its timer resends it.
+    void test_go_back_n()
+    {
+        peer_t peer;
+        peer.connect();
+
+        for (uint8_t i = 0; i < 4; i++)
+            peer.connection->send(message(i));
+        CHECK((seqs(of_type(peer.poll(), frame_type_t::data)) == std::vector<uint16_t>{ 1, 2, 3, 4 }));
+
+        // 2 is lost, 3 and 4 arrive behind the gap
+        peer.ack(1);
+        CHECK(peer.poll().empty());
+        peer.ack(1);
+        peer.ack(1);
+        auto frames = of_type(peer.poll(), frame_type_t::data);
+        CHECK((seqs(frames) == std::vector<uint16_t>{ 2, 3, 4 }));
+        CHECK(frames.size() == 3 && frames[0].data == message(1));
+        CHECK(peer.connection->stats().retransmissions == 3);
+
+        peer.ack(4);
+        CHECK(peer.poll().empty());
+        CHECK(peer.connection->stats().acked == 4);
+
+        // 6 is lost and nothing comes after it
+        peer.connection->send(message(4));
+        peer.connection->send(message(5));
+        CHECK((seqs(of_type(peer.poll(), frame_type_t::data)) == std::vector<uint16_t>{ 5, 6 }));
+        peer.ack(5);
+        CHECK(peer.poll().empty());
+
+        peer.advance_us(peer.connection->stats().rto_us);
+        CHECK((seqs(of_type(peer.poll(), frame_type_t::data)) == std::vector<uint16_t>{ 6 }));
+        CHECK(peer.connection->stats().retransmissions == 4);
+
+        peer.ack(6);
+        peer.poll();
+        CHECK(peer.connection->stats().acked == 6);
+        CHECK(peer.connection->stats().timed_out == 0);
+    }
+
+    // Once the peer asked for a window, frames taken in order are acked together: when the ack delay runs out, after
+    // a quarter of the window, or on the next data frame going the other way.
+    void test_delayed_acks()
+    {
+        peer_t peer;
+        peer.connection->set_ack_delay(20);
+        peer.request_window(16);
+
+        for (uint8_t seq = 1; seq <= 3; seq++)
+            peer.send(seq, frame_type_t::data, message(seq));
+        CHECK(of_type(peer.take(), frame_type_t::ack).empty());
+        CHECK(of_type(peer.poll(), frame_type_t::ack).empty());
+
+        peer.advance_ms(20);
+        CHECK((seqs(of_type(peer.poll(), frame_type_t::ack)) == std::vector<uint16_t>{ 3 }));
+        CHECK(peer.delivered.size() == 3);
+
+        for (uint8_t seq = 4; seq <= 7; seq++)
+            peer.send(seq, frame_type_t::data, message(seq));
+        CHECK((seqs(of_type(peer.take(), frame_type_t::ack)) == std::vector<uint16_t>{ 7 }));
+
+        peer.send(8, frame_type_t::data, message(8));
+        peer.send(9, frame_type_t::data, message(9));
+        peer.connection->send(message(0x42));
+        auto frames = peer.poll();
+        CHECK(of_type(frames, frame_type_t::ack).empty());
+        CHECK(of_type(frames, frame_type_t::data).empty());
+
+        auto carried = of_type(frames, frame_type_t::data_ack);
+        CHECK(carried.size() == 1);
+        if (!carried.empty())
+        {
+            auto& data = carried[0].data;
+            CHECK(data.size() == 2 + message(0x42).size());
+            CHECK(data[0] == 0 && data[1] == 9);
+            CHECK(bytes_t(data.begin() + 2, data.end()) == message(0x42));
+        }
+
+        peer.advance_ms(20);
+        CHECK(of_type(peer.poll(), frame_type_t::ack).empty());
+        CHECK(peer.delivered.size() == 9);
+        CHECK(peer.connection->stats().tx_acks == 2);
+        CHECK(peer.connection->stats().tx_piggybacked_acks == 1);
+    }
+
+    // A frame whose ack was lost comes again. It is acked again, or the sender keeps resending it, but not delivered
+    // twice: with frame by frame acks and with cumulative ones.
+    void test_duplicates()
+    {
+        peer_t peer;
+        peer.connection->set_ack_delay(0);
+
+        peer.send(1, frame_type_t::data, message(1));
+        peer.send(1, frame_type_t::data, message(1));
+        CHECK((seqs(of_type(peer.take(), frame_type_t::ack)) == std::vector<uint16_t>{ 1, 1 }));
+        CHECK(peer.delivered.size() == 1);
+
+        peer.request_window(16, 2);
+        peer.send(2, frame_type_t::data, message(2));
+        peer.send(3, frame_type_t::data, message(3));
+        peer.send(2, frame_type_t::data, message(2));
+        peer.send(4, frame_type_t::data, message(4));
+        CHECK((seqs(of_type(peer.take(), frame_type_t::ack)) == std::vector<uint16_t>{ 2, 3, 3, 4 }));
+        CHECK((peer.delivered == std::vector<bytes_t>{ message(1), message(2), message(3), message(4) }));
+
+        auto stats = peer.connection->stats();
+        CHECK(stats.rx_duplicates == 2);
+        CHECK(stats.rx_frames == 4);
+        CHECK(stats.rx_out_of_order == 0);
+    }
+
+    // The peer's credit bounds the bytes written after the last frame it read. Frames wait once the next one could
+    // overrun it and go out as acks tell that the peer read more, or hand out more credit.
+    void test_credit()
+    {
+        const auto wire = framer_type::calc_frame_size(message(0).size());
+        const auto largest = framer_type::calc_max_frame_size(message(0).size() + 2);
+        const auto credit = static_cast<uint16_t>(wire + largest);
+
+        peer_t peer;
+        peer.connect(bridge_hello(), 8, transport::credit_t{ credit, 0 });
+
+        for (uint8_t i = 0; i < 5; i++)
+            peer.connection->send(message(i));
+
+        CHECK((seqs(of_type(peer.poll(), frame_type_t::data)) == std::vector<uint16_t>{ 1, 2 }));
+        CHECK(peer.connection->pending() == 3);
+        CHECK(peer.connection->stats().tx_credit == credit);
+        CHECK(peer.connection->stats().tx_credit_stalls == 1);
+
+        peer.ack(1, transport::credit_t{ credit, 1 });
+        CHECK((seqs(of_type(peer.poll(), frame_type_t::data)) == std::vector<uint16_t>{ 3 }));
+        CHECK(peer.connection->pending() == 2);
+
+        peer.ack(2, transport::credit_t{ static_cast<uint16_t>(4 * largest), 2 });
+        CHECK((seqs(of_type(peer.poll(), frame_type_t::data)) == std::vector<uint16_t>{ 4, 5 }));
+        CHECK(peer.connection->pending() == 0);
+        CHECK(peer.connection->stats().tx_credit_stalls == 2);
+        CHECK(peer.connection->stats().retransmissions == 0);
+    }
+
+    // Each message reports once: acked when the peer acks it, timed out when it runs out of attempts, dropped right
+    // away when it finds no free slot and must not wait for one.
+    void test_send_results()
+    {
+        peer_t peer;
+        peer.connect();
+
+        std::vector<send_result_t> results;
+        auto record = [&](send_result_t result) { results.push_back(result); };
+
+        peer.connection->send(message(1), 100, 2, transport::channel_t::control, transport::full_policy_t::drop, record);
+        CHECK((seqs(of_type(peer.poll(), frame_type_t::data)) == std::vector<uint16_t>{ 1 }));
+        CHECK(results.empty());
+        peer.ack(1);
+        peer.poll();
+        CHECK((results == std::vector<send_result_t>{ send_result_t::acked }));
+
+        peer.connection->send(message(2), 100, 2, transport::channel_t::control, transport::full_policy_t::drop, record);
+        CHECK((seqs(of_type(peer.poll(), frame_type_t::data)) == std::vector<uint16_t>{ 2 }));
+        for (int i = 0; i < 10 && results.size() < 2; i++)
+        {
+            peer.advance_us(peer.connection->stats().rto_us);
+            peer.poll();
+        }
+        CHECK((results == std::vector<send_result_t>{ send_result_t::acked, send_result_t::timed_out }));
+        CHECK(peer.connection->stats().timed_out == 1);
+
+        auto free = peer.connection->free_slots(transport::channel_t::diagnostics);
+        for (std::size_t i = 0; i < free; i++)
+            peer.connection->send(message(3), 100, 2, transport::channel_t::diagnostics, transport::full_policy_t::drop, record);
+        CHECK(results.size() == 2);
+        CHECK(peer.connection->free_slots(transport::channel_t::diagnostics) == 0);
+
+        peer.connection->send(message(4), 100, 2, transport::channel_t::diagnostics, transport::full_policy_t::drop, record);
+        CHECK((results == std::vector<send_result_t>{ send_result_t::acked, send_result_t::timed_out, send_result_t::dropped }));
+        CHECK(peer.connection->stats().queue_full == 1);
+        CHECK(peer.connection->pending(transport::channel_t::diagnostics) == free);
+    }
+
+    // Pings go out after an interval without a frame from the peer, the link goes down after the set number of them
+    // went unanswered and comes up with whatever frame the peer sends next.
+    void test_keepalive()
+    {
+        peer_t peer;
+        peer.connect();
+
+        std::vector<bool> changes;
+        peer.connection->register_link_handler([&](bool up) { changes.push_back(up); });
+        peer.connection->set_keepalive(100, 2);
+
+        CHECK(of_type(peer.poll(), frame_type_t::ping).empty());
+        CHECK(peer.connection->link_up());
+
+        for (int i = 0; i < 3; i++)
+        {
+            peer.advance_ms(100);
+            CHECK(of_type(peer.poll(), frame_type_t::ping).size() == 1);
+        }
+        CHECK(!peer.connection->link_up());
+        CHECK((changes == std::vector<bool>{ true, false }));
+        CHECK(peer.connection->stats().link_downs == 1);
+
+        // pings keep going out while it is down
+        peer.advance_ms(100);
+        auto pings = of_type(peer.poll(), frame_type_t::ping);
+        CHECK(pings.size() == 1);
+
+        peer.advance_ms(1);
+        peer.send(pings.empty() ? 0 : pings[0].seq, frame_type_t::pong);
+        // the peer may have been replaced while it was gone, it is asked again what it supports
+        CHECK(of_type(peer.poll(), frame_type_t::hello).size() == 1);
+        CHECK(peer.connection->link_up());
+        CHECK((changes == std::vector<bool>{ true, false, true }));
+        CHECK(peer.connection->stats().tx_keepalives == 4);
+
+        // a frame within the interval holds the next ping back
+        peer.advance_ms(50);
+        peer.ack(0);
+        peer.advance_ms(50);
+        CHECK(of_type(peer.poll(), frame_type_t::ping).empty());
+        CHECK(peer.connection->link_up());
+    }
+
+    // A peer that never answers the hellos is as old as the current bridge. Its window request waits until the
+    // hellos are given up, it may still know windows.
+    void test_hello_unanswered()
+    {
+        peer_t peer;
+        for (int i = 0; i < 3; i++)
+        {
+            auto frames = peer.poll();
+            CHECK(of_type(frames, frame_type_t::hello).size() == 1);
+            CHECK(of_type(frames, frame_type_t::window).empty());
+            peer.advance_ms(999);
+            CHECK(peer.poll().empty());
+            peer.advance_ms(1);
+        }
+
+        auto frames = peer.poll();
+        CHECK(of_type(frames, frame_type_t::hello).empty());
+        auto requests = of_type(frames, frame_type_t::window);
+        CHECK(requests.size() == 1);
+
+        std::array<uint8_t, 1> accepted{ 4 };
+        peer.send(requests.empty() ? 1 : requests[0].seq, frame_type_t::window_ack, accepted);
+        CHECK(peer.connection->stats().tx_window == 4);
+        CHECK(!peer.connection->settings());
+        CHECK(peer.connection->stats().peer_version == 0);
+    }
+
+    // A hello that is not an answer gets the connection's own, and both ends settle on what both of them support.
+    void test_hello_answer()
+    {
+        peer_t peer;
+        auto hello = bridge_hello();
+        hello.flags = 0;
+        hello.version = 3;
+        hello.features = feature_bits({ transport::link_feature_t::window, transport::link_feature_t::fragments }) | 0x100;
+        hello.compressions = 0x03;
+        peer.hello(hello);
+
+        auto answers = of_type(peer.take(), frame_type_t::hello);
+        CHECK(answers.size() == 1);
+        if (!answers.empty())
+        {
+            auto answer = transport::hello_t::from_bytes(answers[0].data);
+            CHECK(answer && answer->flags == transport::hello_t::REPLY);
+            CHECK(answer && answer->version == transport::hello_t::VERSION && answer->window == 16 && answer->max_message == 512);
+            CHECK(answer && answer->features == BRIDGE_FEATURES);
+        }
+
+        auto settings = peer.connection->settings();
+        CHECK(settings && settings->version == transport::hello_t::VERSION);
+        CHECK(settings && settings->features == feature_bits({ transport::link_feature_t::window, transport::link_feature_t::fragments }));
+        CHECK(settings && settings->compressions == 0);
+        CHECK(peer.connection->stats().peer_version == 3);
+
+        // the answer ends the exchange, the window request goes out right away
+        auto frames = peer.poll();
+        CHECK(of_type(frames, frame_type_t::hello).empty());
+        CHECK(of_type(frames, frame_type_t::window).size() == 1);
+    }
+
+    // A peer that gives a window of 1 is not asked for one and gets frames one at a time.
+    void test_hello_window_1()
+    {
+        peer_t peer;
+        CHECK(of_type(peer.poll(), frame_type_t::hello).size() == 1);
+        auto hello = bridge_hello();
+        hello.window = 1;
+        peer.hello(hello);
+
+        peer.connection->send(message(1));
+        peer.connection->send(message(2));
+        auto frames = peer.poll();
+        CHECK(of_type(frames, frame_type_t::window).empty());
+        CHECK((seqs(of_type(frames, frame_type_t::data)) == std::vector<uint16_t>{ 1 }));
+
+        peer.ack(1);
+        CHECK((seqs(of_type(peer.poll(), frame_type_t::data)) == std::vector<uint16_t>{ 2 }));
+        peer.ack(2);
+
+        for (int i = 0; i < 5; i++)
+        {
+            peer.advance_ms(1000);
+            CHECK(of_type(peer.poll(), frame_type_t::window).empty());
+        }
+        CHECK(peer.connection->settings() && peer.connection->settings()->window == 1);
+        CHECK(peer.connection->stats().tx_window == 1);
+        CHECK(peer.connection->stats().acked == 2);
+    }
+
+    // Messages the peer could not put back together are dropped before their fragments go out.
+    void test_hello_max_message()
+    {
+        peer_t peer;
+        auto hello = bridge_hello();
+        hello.max_message = 200;
+        peer.connect(hello);
+        CHECK(peer.connection->settings() && peer.connection->settings()->max_message == 200);
+
+        std::vector<send_result_t> results;
+        auto record = [&](send_result_t result) { results.push_back(result); };
+        peer.connection->send(message(1, 201), 1000, 3, transport::channel_t::control, transport::full_policy_t::wait, record);
+        CHECK((results == std::vector<send_result_t>{ send_result_t::dropped }));
+        CHECK(peer.connection->pending() == 0);
+
+        peer.connection->send(message(2, 200), 1000, 3, transport::channel_t::control, transport::full_policy_t::wait, record);
+        auto fragments = of_type(peer.poll(), frame_type_t::fragment);
+        CHECK(fragments.size() == connection_type::frame_count(200));
+        CHECK(fragments.size() > 1);
+        peer.ack(fragments.empty() ? 0 : fragments.back().seq);
+        peer.poll();
+        CHECK((results == std::vector<send_result_t>{ send_result_t::dropped, send_result_t::acked }));
+    }
+
+    // A bridge whose hello does not list ping frames would log every keepalive as unknown and never answer it.
+    void test_hello_no_ping()
+    {
+        peer_t peer;
+        auto hello = bridge_hello();
+        hello.features &= ~static_cast<uint16_t>(transport::link_feature_t::ping);
+        peer.connect(hello);
+        peer.connection->set_keepalive(100, 2);
+
+        for (int i = 0; i < 5; i++)
+        {
+            peer.advance_ms(100);
+            CHECK(of_type(peer.poll(), frame_type_t::ping).empty());
+        }
+        CHECK(peer.connection->link_up());
+        CHECK(peer.connection->stats().tx_keepalives == 0);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    test::parse_args(argc, argv);
+
+    // the connection logs windows, hellos and retransmissions, which these tests cause on purpose
+    esp_log_level_set("*", ESP_LOG_NONE);
+
+    // timed waits return right away and time only moves when a test advances it
+    host::clock_set_virtual(true);
+
+    test::run("connection/window", test_window);
+    test::run("connection/go_back_n", test_go_back_n);
+    test::run("connection/delayed_acks", test_delayed_acks);
+    test::run("connection/duplicates", test_duplicates);
+    test::run("connection/credit", test_credit);
+    test::run("connection/send_results", test_send_results);
+    test::run("connection/keepalive", test_keepalive);
+    test::run("connection/hello/unanswered", test_hello_unanswered);
+    test::run("connection/hello/answer", test_hello_answer);
+    test::run("connection/hello/window_1", test_hello_window_1);
+    test::run("connection/hello/max_message", test_hello_max_message);
+    test::run("connection/hello/no_ping", test_hello_no_ping);
+
+    return test::summary();
+}
@@ -0,0 +1,716 @@
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <etl/crc16_ccitt.h>
+
+#include "esp_log.h"
+
+#include "protocol/chunk_assembler.hpp"
+#include "protocol/coalescing_outbox.hpp"
+#include "protocol/crc16.hpp"
+#include "protocol/fragment_assembler.hpp"
+#include "protocol/framer.hpp"
+#include "protocol/rtt_estimator.hpp"
+#include "protocol/seq_window.hpp"
+#include "protocol/utils.hpp"
+
+#include "test.hpp"
+
+namespace
+{
+    constexpr std::array<uint8_t, 2> MAGIC{0x19, 0x16};
+    constexpr std::size_t BUFFER_SIZE = 1024;
+
+    using framer_type = transport::framer_t<MAGIC, BUFFER_SIZE>;
+    using bytes_t = std::vector<uint8_t>;
+
+    // Rich in magic bytes and zeros, the bytes the framings have to tell apart from their own.
+    bytes_t payload(std::mt19937& rng, std::size_t size)
+    {
+        bytes_t ret(size);
+        for (auto& b: ret)
+        {
+            auto r = rng() % 8;
+            b = r == 0 ? MAGIC[0] : r == 1 ? MAGIC[1] : r == 2 ? 0 : static_cast<uint8_t>(rng());
+        }
+        return ret;
+    }
+
+    struct received_t
+    {
+        std::vector<bytes_t> frames;
+        std::vector<uint16_t> seqs;
+    };
+
+    bytes_t encode(framer_type& framer, const std::vector<bytes_t>& payloads)
+    {
+        bytes_t stream;
+        bytes_t buffer;
+        for (std::size_t i = 0; i < payloads.size(); i++)
+        {
+            buffer.resize(framer_type::calc_max_frame_size(payloads[i].size()));
+            auto n = framer.to_bytes(buffer, transport::frame_t{static_cast<uint16_t>(i), transport::frame_type_t::data, payloads[i]});
+            stream.insert(stream.end(), buffer.begin(), buffer.begin() + n);
+        }
+        return stream;
+    }
+
+    // Feeds stream in pieces of chunk bytes, 0 picks random sizes.
+    received_t decode(framer_type& framer, std::span<const uint8_t> stream, std::size_t chunk, std::mt19937& rng)
+    {
+        received_t ret;
+        for (std::size_t at = 0; at < stream.size();)
+        {
+            auto size = std::min(chunk ? chunk : 1 + rng() % 300, stream.size() - at);
+            framer.feed(stream.subspan(at, size), [&](const transport::frame_t& frame)
+            {
+                ret.frames.emplace_back(frame.data.begin(), frame.data.end());
+                ret.seqs.push_back(frame.seq);
+            });
+            at += size;
+        }
+        return ret;
+    }
+
+    void check_round_trip(transport::framing_t framing)
+    {
+        std::mt19937 rng(static_cast<uint32_t>(framing) + 1);
+
+        std::vector<bytes_t> payloads;
+        for (auto size: { 0, 1, 2, 5, 127, 128, 253, 254, 255, 300, 600 })
+            payloads.push_back(payload(rng, size));
+
+        for (std::size_t chunk: { 1, 2, 7, 64, 4096, 0 })
+        {
+            auto tx = std::make_unique<framer_type>();
+            auto rx = std::make_unique<framer_type>();
+            tx->set_framing(framing);
+            rx->set_framing(framing);
+
+            auto stream = encode(*tx, payloads);
+            auto received = decode(*rx, stream, chunk, rng);
+
+            CHECK(received.frames == payloads);
+            for (std::size_t i = 0; i < received.seqs.size(); i++)
+                CHECK(received.seqs[i] == static_cast<uint16_t>(i));
+            CHECK(rx->stats().crc_errors == 0);
+            CHECK(rx->stats().dropped_bytes == 0);
+        }
+    }
+
+    // find_magic has to agree with the plain scan wherever the magic sits relative to the words it loads.
+    template<std::array Magic>
+    void check_find_magic(std::mt19937& rng)
+    {
+        auto find = [](const bytes_t& data)
+        {
+            return transport::find_magic<Magic>(data);
+        };
+
+        constexpr std::size_t W = sizeof(std::size_t);
+        const bytes_t magic(Magic.begin(), Magic.end());
+
+        for (std::size_t size = 0; size <= 3 * W; size++)
+        {
+            for (std::size_t at = 0; at < size; at++)
+            {
+                // the magic at every offset, whole or cut off by the end of the buffer
+                bytes_t data(size, 0x55);
+                for (std::size_t k = 0; k < magic.size() && at + k < size; k++)
+                    data[at + k] = magic[k];
+                CHECK(find(data) == transport::find_sequence(data, magic));
+
+                // a run of first bytes ending in the rest of the magic
+                std::fill(data.begin(), data.begin() + at, Magic[0]);
+                CHECK(find(data) == transport::find_sequence(data, magic));
+            }
+        }
+
+        // random bytes mostly drawn from the magic, full of partial matches
+        for (int round = 0; round < 20000; round++)
+        {
+            bytes_t data(rng() % 70);
+            for (auto& b: data)
+                b = rng() % 4 ? Magic[rng() % Magic.size()] : static_cast<uint8_t>(rng());
+            CHECK(find(data) == transport::find_sequence(data, magic));
+        }
+    }
+
+    void test_find_magic()
+    {
+        std::mt19937 rng(8);
+        check_find_magic<MAGIC>(rng);
+        check_find_magic<std::array<uint8_t, 3>{ 0xAA, 0xAA, 0xAB }>(rng);
+        check_find_magic<std::array<uint8_t, 1>{ 0x7E }>(rng);
+    }
+
+    void test_magic_round_trip()
+    {
+        check_round_trip(transport::framing_t::magic);
+    }
+
+    // Bytes between frames and a frame with a broken crc cost that frame only, the scan finds the next magic.
+    void test_magic_resync()
+    {
+        std::mt19937 rng(7);
+        auto tx = std::make_unique<framer_type>();
+
+        std::vector<bytes_t> payloads{ payload(rng, 40), payload(rng, 200), payload(rng, 3) };
+        auto first = encode(*tx, { payloads[0] });
+        auto second = encode(*tx, { payloads[1] });
+        auto third = encode(*tx, { payloads[2] });
+        second[second.size() / 2] ^= 0x10;
+
+        bytes_t stream{ 0x00, MAGIC[0], 0x42, MAGIC[0] };
+        stream.insert(stream.end(), first.begin(), first.end());
+        stream.insert(stream.end(), { MAGIC[1], MAGIC[0] });
+        stream.insert(stream.end(), second.begin(), second.end());
+        stream.insert(stream.end(), third.begin(), third.end());
+
+        for (std::size_t chunk: { 1, 5, 4096 })
+        {
+            auto framer = std::make_unique<framer_type>();
+            auto received = decode(*framer, stream, chunk, rng);
+
+            CHECK((received.frames == std::vector<bytes_t>{ payloads[0], payloads[2] }));
+            CHECK(framer->stats().crc_errors == 1);
+        }
+    }
+
+    // A bit flip that makes a len longer costs that frame only. The frames it ran into are found again in its
+    // bytes, and with the peer's max_len known a len beyond it is not waited for at all.
+    void test_magic_damaged_len()
+    {
+        std::mt19937 rng(17);
+        auto tx = std::make_unique<framer_type>();
+
+        std::vector<bytes_t> payloads{ payload(rng, 40), payload(rng, 30), payload(rng, 30), payload(rng, 60) };
+        auto stream = encode(*tx, payloads);
+        const std::vector<bytes_t> behind(payloads.begin() + 1, payloads.end());
+
+        // len 40 becomes 104, the frame takes in the second one and the start of the third
+        auto longer = stream;
+        longer[3] ^= 0x40;
+        for (std::size_t chunk: { 1, 5, 4096, 0 })
+        {
+            auto rx = std::make_unique<framer_type>();
+            auto received = decode(*rx, longer, chunk, rng);
+
+            CHECK(received.frames == behind);
+            CHECK(rx->stats().crc_errors == 1);
+        }
+
+        // len 552 reaches past the end of the stream: waited for, unless beyond what the peer sends
+        auto beyond = stream;
+        beyond[2] ^= 0x02;
+        for (std::size_t chunk: { 1, 4096 })
+        {
+            auto rx = std::make_unique<framer_type>();
+            CHECK(decode(*rx, beyond, chunk, rng).frames.empty());
+
+            rx = std::make_unique<framer_type>();
+            rx->set_max_len(64);
+            CHECK(decode(*rx, beyond, chunk, rng).frames == behind);
+        }
+    }
+
+    // Adds data in pieces of random size, down to single bytes and empty ones.
+    template<transport::crc16_backend_t Backend>
+    uint16_t crc16_in_pieces(const bytes_t& data, std::mt19937& rng)
+    {
+        transport::crc16_ccitt_t<Backend> crc;
+        for (std::size_t at = 0; at < data.size();)
+        {
+            auto size = std::min<std::size_t>(rng() % 9, data.size() - at);
+            crc.add(std::span(data).subspan(at, size));
+            at += size;
+        }
+        return crc.value();
+    }
+
+    template<transport::crc16_backend_t Backend>
+    void check_crc16_backend(std::mt19937& rng)
+    {
+        using crc_type = transport::crc16_ccitt_t<Backend>;
+
+        const bytes_t check{ '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+        CHECK(crc_type::compute(check) == 0x29B1);
+
+        for (std::size_t size: { 0, 1, 2, 3, 4, 5, 7, 8, 9, 63, 64, 65, 255, 1000 })
+        {
+            auto data = payload(rng, size);
+            auto expected = etl::crc16_ccitt_t<256>(data.begin(), data.end()).value();
+
+            CHECK(crc_type::compute(data) == expected);
+            CHECK(crc16_in_pieces<Backend>(data, rng) == expected);
+
+            crc_type crc;
+            crc.add(data);
+            crc.reset();
+            crc.add(data);
+            CHECK(crc.value() == expected);
+        }
+    }
+
+    // Every backend gives the checksum of ETL's, however the bytes are split across add() calls. The rom one runs
+    // against the host's stand-in of the ROM routine, which checks the inversion around it.
+    void test_crc16_backends()
+    {
+        std::mt19937 rng(10);
+        check_crc16_backend<transport::crc16_backend_t::etl>(rng);
+        check_crc16_backend<transport::crc16_backend_t::table>(rng);
+        check_crc16_backend<transport::crc16_backend_t::slicing_by_4>(rng);
+        check_crc16_backend<transport::crc16_backend_t::rom>(rng);
+    }
+
+    void test_cobs_round_trip()
+    {
+        check_round_trip(transport::framing_t::cobs);
+    }
+
+    // A broken frame ends at its delimiter, the one behind it is decoded as if nothing happened.
+    void test_cobs_resync()
+    {
+        std::mt19937 rng(8);
+        auto tx = std::make_unique<framer_type>();
+        tx->set_framing(transport::framing_t::cobs);
+
+        std::vector<bytes_t> payloads{ payload(rng, 100), payload(rng, 100), payload(rng, 100) };
+        auto stream = encode(*tx, payloads);
+        stream[stream.size() / 2] ^= 0x01;
+
+        auto rx = std::make_unique<framer_type>();
+        rx->set_framing(transport::framing_t::cobs);
+        auto received = decode(*rx, stream, 3, rng);
+
+        CHECK(received.frames.size() == 2);
+        CHECK(received.frames.front() == payloads.front());
+        CHECK(received.frames.back() == payloads.back());
+    }
+
+    void test_fec_round_trip()
+    {
+        check_round_trip(transport::framing_t::magic_fec);
+    }
+
+    // A few bytes flipped in the header and in each block are repaired, the frame needs no retransmission.
+    void test_fec_repair()
+    {
+        std::mt19937 rng(9);
+        auto tx = std::make_unique<framer_type>();
+        tx->set_framing(transport::framing_t::magic_fec);
+
+        auto sent = payload(rng, 300);
+        auto stream = encode(*tx, { sent });
+        for (auto at: { 3, 20, 21, 150, 290 })
+            stream[at] ^= 0x5a;
+
+        auto rx = std::make_unique<framer_type>();
+        rx->set_framing(transport::framing_t::magic_fec);
+        auto received = decode(*rx, stream, 16, rng);
+
+        CHECK(received.frames == std::vector<bytes_t>{ sent });
+        CHECK(rx->stats().fec_corrected == 1);
+        CHECK(rx->stats().crc_errors == 0);
+    }
+
+    // Frames larger than the receive buffer arrive in chunks, put back together by a chunk_assembler_t like the
+    // panel does for large messages.
+    void check_chunked(transport::framing_t framing)
+    {
+        std::mt19937 rng(static_cast<uint32_t>(framing) + 10);
+        std::vector<bytes_t> payloads{ payload(rng, 3000), payload(rng, 40), payload(rng, BUFFER_SIZE), payload(rng, 5000) };
+
+        auto tx = std::make_unique<framer_type>();
+        tx->set_framing(framing);
+        auto stream = encode(*tx, payloads);
+
+        for (std::size_t chunk: { 1, 100, 4096, 0 })
+        {
+            auto rx = std::make_unique<framer_type>();
+            rx->set_framing(framing);
+            transport::chunk_assembler_t<8 * 1024> assembler;
+
+            std::vector<bytes_t> received;
+            std::size_t chunked = 0;
+            for (std::size_t at = 0; at < stream.size();)
+            {
+                auto size = std::min(chunk ? chunk : 1 + rng() % 300, stream.size() - at);
+                rx->feed(std::span<const uint8_t>(stream).subspan(at, size),
+                    [&](const transport::frame_t& frame) { received.emplace_back(frame.data.begin(), frame.data.end()); },
+                    [&](const transport::frame_chunk_t& part)
+                    {
+                        assembler.add(part, [&](std::span<const uint8_t> message)
+                        {
+                            received.emplace_back(message.begin(), message.end());
+                            chunked++;
+                        });
+                    });
+                at += size;
+            }
+
+            CHECK(received == payloads);
+            CHECK(chunked >= 2);
+        }
+    }
+
+    void test_chunked_magic()
+    {
+        check_chunked(transport::framing_t::magic);
+    }
+
+    void test_chunked_cobs()
+    {
+        check_chunked(transport::framing_t::cobs);
+    }
+
+    void test_chunked_fec()
+    {
+        check_chunked(transport::framing_t::magic_fec);
+    }
+
+    // A chunked frame that fails its crc is not completed, nor is one whose chunks do not follow each other.
+    void test_chunk_assembler()
+    {
+        using transport::chunk_status_t;
+        std::array<uint8_t, 4> data{ 1, 2, 3, 4 };
+        auto part = [&](uint16_t seq, std::size_t offset, std::span<const uint8_t> bytes, chunk_status_t status)
+        {
+            return transport::frame_chunk_t{ seq, transport::frame_type_t::data, offset, 8, bytes, status };
+        };
+
+        transport::chunk_assembler_t<64> assembler;
+        std::vector<bytes_t> completed;
+        auto on_complete = [&](std::span<const uint8_t> message) { completed.emplace_back(message.begin(), message.end()); };
+
+        assembler.add(part(1, 0, data, chunk_status_t::partial), on_complete);
+        assembler.add(part(1, 4, data, chunk_status_t::partial), on_complete);
+        assembler.add(part(1, 8, {}, chunk_status_t::failed), on_complete);
+        CHECK(completed.empty());
+
+        // skips offset 4
+        assembler.add(part(2, 0, data, chunk_status_t::partial), on_complete);
+        assembler.add(part(2, 8, data, chunk_status_t::partial), on_complete);
+        assembler.add(part(2, 12, {}, chunk_status_t::complete), on_complete);
+        CHECK(completed.empty());
+
+        // a chunk of another frame in between
+        assembler.add(part(3, 0, data, chunk_status_t::partial), on_complete);
+        assembler.add(part(4, 4, data, chunk_status_t::partial), on_complete);
+        assembler.add(part(3, 8, {}, chunk_status_t::complete), on_complete);
+        CHECK(completed.empty());
+
+        assembler.add(part(5, 0, data, chunk_status_t::partial), on_complete);
+        assembler.add(part(5, 4, data, chunk_status_t::partial), on_complete);
+        assembler.add(part(5, 8, {}, chunk_status_t::complete), on_complete);
+        CHECK((completed == std::vector<bytes_t>{ { 1, 2, 3, 4, 1, 2, 3, 4 } }));
+    }
+
+    // Seqs wrap at 65535, a frame seen within the last 64 is a duplicate, one further back a restarted peer.
+    void test_seq_window()
+    {
+        transport::seq_window_t window;
+
+        bool fresh = true;
+        for (uint32_t i = 65500; i < 65536 + 40; i++)
+            fresh = window.mark(static_cast<uint16_t>(i)) && fresh;
+        CHECK(fresh);
+
+        // newest is 39, 65535 and 0 are just behind it across the wrap
+        CHECK(!window.mark(39));
+        CHECK(!window.mark(0));
+        CHECK(!window.mark(65535));
+        CHECK(!window.mark(static_cast<uint16_t>(39 - transport::seq_window_t::SIZE + 1)));
+
+        // out of order: 42 skips 40 and 41, which are still new when they arrive late
+        CHECK(window.mark(42));
+        CHECK(window.mark(40));
+        CHECK(window.mark(41));
+        CHECK(!window.mark(40));
+
+        // too far back to tell, taken as a peer that started over
+        CHECK(window.mark(static_cast<uint16_t>(42 - transport::seq_window_t::SIZE)));
+        CHECK(!window.mark(static_cast<uint16_t>(42 - transport::seq_window_t::SIZE)));
+
+        // a jump ahead by more than the window forgets everything before it
+        CHECK(window.mark(1000));
+        CHECK(window.mark(999));
+
+        // seq 1 behind the newest one is a restart too
+        CHECK(window.mark(1));
+        CHECK(window.mark(2));
+        CHECK(window.mark(3));
+        CHECK(!window.mark(2));
+
+        window.reset();
+        CHECK(window.mark(2));
+    }
+
+    // Timeouts double the rto up to MAX_RTO_US, the next ack for a frame that was sent once brings it back to the
+    // round trips measured so far. An ack of a resent frame is no sample but ends the backoff as well.
+    void test_rtt_estimator()
+    {
+        using transport::rtt_estimator_t;
+        rtt_estimator_t rtt;
+        CHECK(rtt.rto_us() == rtt_estimator_t::INITIAL_RTO_US);
+
+        for (auto i = 0; i < 20; i++)
+            rtt.add_sample(40'000);
+        auto settled = rtt.rto_us();
+        CHECK(rtt.srtt_us() == 40'000);
+        CHECK(settled >= 40'000 + rtt_estimator_t::GRANULARITY_US);
+        CHECK(settled < 100'000);
+
+        for (auto i = 0; i < 20; i++)
+            rtt.back_off();
+        CHECK(rtt.rto_us() == rtt_estimator_t::MAX_RTO_US);
+
+        rtt.add_sample(40'000);
+        CHECK(rtt.rto_us() == settled);
+
+        rtt.back_off();
+        rtt.back_off();
+        CHECK(rtt.rto_us() == 4 * settled);
+        rtt.reset_backoff();
+        CHECK(rtt.rto_us() == settled);
+        CHECK(rtt.samples() == 21);
+    }
+
+    // A fragment payload as the sender builds it, header first.
+    bytes_t fragment(uint16_t message_id, uint8_t index, uint8_t count, const bytes_t& data)
+    {
+        bytes_t ret(transport::fragment_header_t::SIZE + data.size());
+        transport::fragment_header_t{ 0, message_id, index, count }.to_bytes(std::span(ret).first<transport::fragment_header_t::SIZE>());
+        std::ranges::copy(data, ret.begin() + transport::fragment_header_t::SIZE);
+        return ret;
+    }
+
+    // Fragments of a channel are taken in order only. A missing, repeated or foreign fragment drops the message,
+    // so does a next message starting or the next fragment not arriving within TIMEOUT_MS.
+    void test_fragment_assembler()
+    {
+        using assembler_t = transport::fragment_assembler_t<16>;
+        std::vector<bytes_t> completed;
+        auto on_complete = [&](std::span<const uint8_t> message) { completed.emplace_back(message.begin(), message.end()); };
+        auto add = [&](assembler_t& assembler, const bytes_t& payload, TickType_t now)
+        {
+            assembler.add(*transport::fragment_header_t::from_bytes(payload), payload, now, on_complete);
+        };
+
+        assembler_t assembler;
+        add(assembler, fragment(1, 0, 3, { 1, 2 }), 0);
+        add(assembler, fragment(1, 1, 3, { 3 }), 0);
+        add(assembler, fragment(1, 2, 3, { 4, 5 }), 0);
+        CHECK((completed == std::vector<bytes_t>{ { 1, 2, 3, 4, 5 } }));
+        completed.clear();
+
+        // out of order
+        add(assembler, fragment(2, 0, 3, { 1 }), 0);
+        add(assembler, fragment(2, 2, 3, { 3 }), 0);
+        add(assembler, fragment(2, 1, 3, { 2 }), 0);
+        CHECK(completed.empty());
+
+        // repeated, or of another message
+        add(assembler, fragment(3, 0, 2, { 1 }), 0);
+        add(assembler, fragment(3, 0, 2, { 1 }), 0);
+        add(assembler, fragment(4, 1, 2, { 2 }), 0);
+        add(assembler, fragment(3, 1, 2, { 2 }), 0);
+        CHECK((completed == std::vector<bytes_t>{ { 1, 2 } }));
+        completed.clear();
+
+        // the next message starts before the last one ended
+        add(assembler, fragment(5, 0, 2, { 1 }), 0);
+        add(assembler, fragment(6, 0, 2, { 7 }), 0);
+        add(assembler, fragment(5, 1, 2, { 2 }), 0);
+        add(assembler, fragment(6, 1, 2, { 8 }), 0);
+        CHECK((completed == std::vector<bytes_t>{ { 7, 8 } }));
+        completed.clear();
+
+        // larger than the buffer
+        add(assembler, fragment(7, 0, 2, bytes_t(10, 1)), 0);
+        add(assembler, fragment(7, 1, 2, bytes_t(10, 2)), 0);
+        CHECK(completed.empty());
+
+        auto timeout = pdMS_TO_TICKS(assembler_t::TIMEOUT_MS);
+        CHECK(assembler.expire(0) == portMAX_DELAY);
+
+        add(assembler, fragment(8, 0, 2, { 1 }), 100);
+        CHECK(assembler.expire(100 + timeout - 1) == 1);
+        CHECK(assembler.expire(100 + timeout) == portMAX_DELAY);
+        add(assembler, fragment(8, 1, 2, { 2 }), 100 + timeout);
+        CHECK(completed.empty());
+        CHECK(assembler.stats().timeouts == 1);
+
+        // a fragment just in time resets the timer for the next one
+        add(assembler, fragment(9, 0, 3, { 1 }), 0);
+        add(assembler, fragment(9, 1, 3, { 2 }), timeout - 1);
+        CHECK(assembler.expire(2 * timeout - 2) == 1);
+        add(assembler, fragment(9, 2, 3, { 3 }), 2 * timeout - 2);
+        CHECK((completed == std::vector<bytes_t>{ { 1, 2, 3 } }));
+        CHECK(assembler.stats().reassembled == 4);
+    }
+
+    // Stands in for frame_host_connection_t: keeps what was sent and its callback until the test completes it.
+    struct fake_connection_t
+    {
+        struct sent_t
+        {
+            bytes_t message;
+            transport::send_callback_t on_done;
+        };
+
+        void send(std::span<const uint8_t> data, uint32_t, uint32_t, transport::channel_t, transport::full_policy_t when_full, transport::send_callback_t on_done)
+        {
+            CHECK(when_full == transport::full_policy_t::drop);
+            if (full)
+                return on_done(transport::send_result_t::dropped);
+
+            in_flight.push_back({ bytes_t(data.begin(), data.end()), std::move(on_done) });
+        }
+
+        // Completes the oldest message and returns it.
+        bytes_t complete(transport::send_result_t result = transport::send_result_t::acked)
+        {
+            auto sent = std::move(in_flight.front());
+            in_flight.erase(in_flight.begin());
+            sent.on_done(result);
+            return sent.message;
+        }
+
+        std::vector<sent_t> in_flight;
+        bool full = false;
+    };
+
+    // One message per key on the link, what is posted meanwhile replaces the one waiting behind it.
+    // Each end computes the settings from the two hellos and has to arrive at the same ones, whichever is a.
+    void test_hello_negotiate()
+    {
+        transport::hello_t a{
+            .version = 2, .flags = 0, .max_frame = 256, .rx_frame_buffer = 4096, .rx_buffer = 0, .window = 8,
+            .max_message = 2048, .framings = 0x07, .compressions = 0x03, .pixel_formats = 0x05, .features = 0x1F
+        };
+        transport::hello_t b{
+            .version = 1, .flags = transport::hello_t::REPLY, .max_frame = 64, .rx_frame_buffer = 1024, .rx_buffer = 512, .window = 4,
+            .max_message = 300, .framings = 0x01, .compressions = 0x02, .pixel_formats = 0x0C, .features = 0x106
+        };
+
+        std::array<uint8_t, transport::hello_t::SIZE> bytes;
+        b.to_bytes(bytes);
+        auto read = transport::hello_t::from_bytes(bytes);
+        CHECK(read && read->max_message == 300 && read->rx_buffer == 512 && read->features == 0x106);
+        CHECK(!transport::hello_t::from_bytes(std::span(bytes).first(transport::hello_t::SIZE - 1)));
+
+        for (auto [x, y]: { std::pair{ a, b }, std::pair{ b, a } })
+        {
+            auto agreed = transport::link_settings_t::negotiate(x, y);
+            CHECK(agreed.version == 1);
+            CHECK(agreed.window == 4);
+            CHECK(agreed.max_message == 300);
+            CHECK(agreed.compressions == 0x02);
+            CHECK(agreed.pixel_formats == 0x04);
+            CHECK(agreed.features == 0x06);
+            CHECK(agreed.supports(transport::link_feature_t::window));
+            CHECK(!agreed.supports(transport::link_feature_t::ping));
+        }
+
+        // an end that gives a window of 0 gets stop-and-wait like one that gives 1
+        b.window = 0;
+        CHECK(transport::link_settings_t::negotiate(a, b).window == 1);
+    }
+
+    void test_coalescing_outbox()
+    {
+        fake_connection_t connection;
+        transport::coalescing_outbox_t<fake_connection_t, std::string, 8, 2> outbox(connection);
+        auto post = [&](const std::string& key, uint8_t value)
+        {
+            return outbox.post(key, [&](std::span<uint8_t> buffer)
+            {
+                buffer[0] = value;
+                return std::size_t{ 1 };
+            });
+        };
+
+        CHECK(post("a", 1));
+        CHECK(post("a", 2));
+        CHECK(post("a", 3));
+        CHECK(post("b", 10));
+        CHECK(connection.in_flight.size() == 2);
+
+        // the latest value of a follows its first one, b had nothing waiting
+        CHECK((connection.complete() == bytes_t{ 1 }));
+        CHECK((connection.complete() == bytes_t{ 10 }));
+        CHECK(connection.in_flight.size() == 1);
+        CHECK((connection.complete() == bytes_t{ 3 }));
+        CHECK(connection.in_flight.empty());
+
+        // a timed out message is done with, it is not sent again
+        CHECK(post("a", 4));
+        connection.complete(transport::send_result_t::timed_out);
+        CHECK(connection.in_flight.empty());
+
+        // no slot: kept for flush(), unless a newer value replaced it by then
+        connection.full = true;
+        CHECK(post("a", 5));
+        CHECK(post("a", 6));
+        CHECK(connection.in_flight.empty());
+        connection.full = false;
+        outbox.flush();
+        CHECK(connection.in_flight.size() == 1);
+        CHECK((connection.complete() == bytes_t{ 6 }));
+
+        // keys whose messages went out are forgotten, two at a time are all there is room for
+        CHECK(post("a", 7));
+        CHECK(post("b", 11));
+        CHECK(!post("c", 20));
+        connection.complete();
+        connection.complete();
+        CHECK(post("c", 21));
+        CHECK((connection.complete() == bytes_t{ 21 }));
+
+        // too large or empty
+        CHECK(!outbox.post("a", [](std::span<uint8_t> buffer) { return buffer.size() + 1; }));
+        CHECK(!outbox.post("a", [](std::span<uint8_t>) { return std::size_t{ 0 }; }));
+        CHECK(connection.in_flight.empty());
+
+        auto stats = outbox.stats();
+        CHECK(stats.posted == 13);
+        CHECK(stats.coalesced == 2);
+        CHECK(stats.sent == 8);
+        CHECK(stats.dropped == 3);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    test::parse_args(argc, argv);
+
+    // the framer logs dropped bytes and crc errors, which these tests cause on purpose
+    esp_log_level_set("*", ESP_LOG_NONE);
+
+    test::run("find_magic", test_find_magic);
+    test::run("framer/magic/round_trip", test_magic_round_trip);
+    test::run("framer/magic/resync", test_magic_resync);
+    test::run("framer/magic/damaged_len", test_magic_damaged_len);
+    test::run("crc16/backends", test_crc16_backends);
+    test::run("framer/cobs/round_trip", test_cobs_round_trip);
+    test::run("framer/cobs/resync", test_cobs_resync);
+    test::run("framer/fec/round_trip", test_fec_round_trip);
+    test::run("framer/fec/repair", test_fec_repair);
+    test::run("framer/magic/chunked", test_chunked_magic);
+    test::run("framer/cobs/chunked", test_chunked_cobs);
+    test::run("framer/fec/chunked", test_chunked_fec);
+    test::run("chunk_assembler", test_chunk_assembler);
+    test::run("seq_window", test_seq_window);
+    test::run("rtt_estimator", test_rtt_estimator);
+    test::run("fragment_assembler", test_fragment_assembler);
+    test::run("hello/negotiate", test_hello_negotiate);
+    test::run("coalescing_outbox", test_coalescing_outbox);
+
+    return test::summary();
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdio>
+#include <string_view>
+
+namespace test
+{
+    struct state_t
+    {
+        std::string_view filter{};
+        std::string_view current{};
+        int cases = 0;
+        int checks = 0;
+        int failures = 0;
+    };
+
+    inline state_t& state()
+    {
+        static state_t instance;
+        return instance;
+    }
+
+    inline bool check(bool ok, const char* expression, const char* file, int line)
+    {
+        state().checks++;
+        if (!ok)
+        {
+            state().failures++;
+            std::fprintf(stderr, "%s:%d: %.*s: check failed: %s\n", file, line,
+                static_cast<int>(state().current.size()), state().current.data(), expression);
+        }
+        return ok;
+    }
+
+    // Runs fn unless a --filter was given that name does not contain.
+    template<typename F>
+    inline void run(std::string_view name, F&& fn)
+    {
+        if (!state().filter.empty() && name.find(state().filter) == std::string_view::npos)
+            return;
+
+        auto failures = state().failures;
+        state().current = name;
+        state().cases++;
+        fn();
+        std::printf("%-56.*s %s\n", static_cast<int>(name.size()), name.data(), state().failures == failures ? "ok" : "FAILED");
+    }
+
+    inline void parse_args(int argc, char** argv)
+    {
+        for (auto i = 1; i < argc; i++)
+        {
+            std::string_view arg = argv[i];
+
+            if (arg == "--filter" && i + 1 < argc)
+                state().filter = argv[++i];
+            else
+                std::fprintf(stderr, "usage: %s [--filter substring]\n", argv[0]);
+        }
+    }
+
+    // Exit code of the test binary.
+    inline int summary()
+    {
+        std::printf("%d cases, %d checks, %d failed\n", state().cases, state().checks, state().failures);
+        return state().failures == 0 ? 0 : 1;
+    }
+}
+
+// Keeps going after a failed check, so one run reports every failure.
+#define CHECK(expression) ::test::check(static_cast<bool>(expression), #expression, __FILE__, __LINE__)
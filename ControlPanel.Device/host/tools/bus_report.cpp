@@ -0,0 +1,260 @@
+// Runs waveshare_st7789_t and cst328_driver_t against the mock SPI/I2C/GPIO layer of the host shim and
+// reports what the panel and touch controller cost on their buses: SPI transactions, bytes and estimated
+// wire time per rendered frame, and I2C traffic per touch event.
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <functional>
+#include <semaphore>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "esp_log.h"
+#include "host_bus.hpp"
+#include "host_clock.hpp"
+
+#include "waveshare_st7789.hpp"
+#include "waveshare_st7789_lvgl.hpp"
+#include "cst328_driver.hpp"
+#include "volume_display.hpp"
+
+#include "lvgl/headless_display.hpp"
+
+#include "bench/payloads.hpp"
+
+namespace
+{
+    // same wiring as main.cpp
+    constexpr int LCD_SPI_CLOCK = 60 * 1000000;
+    constexpr uint32_t I2C_TOUCH_FREQ_HZ = 400000;
+    constexpr uint16_t CST328_I2C_ADDR = 0x1A;
+
+    struct options_t
+    {
+        std::size_t streams = 10;
+        int frames = 100;
+        int touches = 100;
+        host::bus_model_t model{};
+    };
+
+    void print_bus_header()
+    {
+        std::printf("%-28s %8s %9s %10s %12s %12s %10s\n", "", "count", "flushes", "spi tx", "spi bytes", "spi est us", "gpio set");
+    }
+
+    void print_bus_row(const char* name, const host::bus_stats_t& s, double count, uint64_t flushes)
+    {
+        std::printf("%-28s %8.0f %9.2f %10.2f %12.0f %12.1f %10.2f\n", name, count, flushes / count,
+            s.spi.transactions / count, s.spi.bytes / count, s.spi.time_ns / count / 1000, s.gpio_writes / count);
+    }
+
+    // Mock CST328: answers the config, resolution and coordinate registers cst328_driver_t reads
+    struct cst328_target_t
+    {
+        uint16_t width = 240;
+        uint16_t height = 320;
+        uint16_t x = 0;
+        uint16_t y = 0;
+
+        esp_err_t operator()(std::span<const uint8_t> write, std::span<uint8_t> read)
+        {
+            if (write.size() < 2)
+                return ESP_FAIL;
+
+            auto reg = static_cast<uint16_t>(write[0] << 8 | write[1]);
+            std::ranges::fill(read, 0);
+
+            if (reg == 0xD1F8 && read.size() >= 4)
+            {
+                read[0] = width & 0xFF; read[1] = width >> 8;
+                read[2] = height & 0xFF; read[3] = height >> 8;
+            }
+            else if (reg == 0xD001 && read.size() >= 3)
+            {
+                read[0] = static_cast<uint8_t>(x >> 4);
+                read[1] = static_cast<uint8_t>(y >> 4);
+                read[2] = static_cast<uint8_t>((x & 0x0F) << 4 | (y & 0x0F));
+            }
+
+            return ESP_OK;
+        }
+    };
+
+    void report_display(const options_t& o)
+    {
+        waveshare_st7789_t st7789(SPI3_HOST, GPIO_NUM_5, GPIO_NUM_27, GPIO_NUM_26, GPIO_NUM_25,
+            host_lvgl::LCD_WIDTH, host_lvgl::LCD_HEIGHT, LCD_SPI_CLOCK, orientation_t::landscape);
+
+        auto before = host::bus_stats();
+        ESP_ERROR_CHECK(st7789.init());
+
+        std::printf("display: ST7789 %ux%u, SPI %d MHz, %zu streams\n\n", st7789.width(), st7789.height(), LCD_SPI_CLOCK / 1000000, o.streams);
+        print_bus_header();
+        print_bus_row("init sequence", host::bus_stats() - before, 1, 0);
+
+        // same display setup as st7789_create_lvgl_display()
+        auto disp = waveshare_st7789::lvgl_create_display(&st7789);
+        std::vector<uint8_t> buffer(st7789.width() * st7789.height() / 5 * LV_COLOR_FORMAT_GET_SIZE(LV_COLOR_FORMAT_RGB565));
+        lv_display_set_buffers(disp, buffer.data(), nullptr, buffer.size(), LV_DISPLAY_RENDER_MODE_PARTIAL);
+
+        uint64_t flushes = 0;
+        lv_display_add_event_cb(disp, +[](lv_event_t* e) { (*static_cast<uint64_t*>(lv_event_get_user_data(e)))++; }, LV_EVENT_FLUSH_START, &flushes);
+
+        app_style::init(disp);
+
+        volume_display_t volume_display(0, 0, LV_PCT(100), LV_PCT(100));
+        auto apply = [&](std::span<const uint8_t> message)
+        {
+            auto parsed = parse_bridge_message(message);
+            if (auto* msg = std::get_if<streams_message_t>(&parsed))
+                volume_display.refresh(msg->updated, msg->deleted);
+        };
+
+        apply(bench::payloads::streams_message(o.streams));
+
+        auto next_frame = []
+        {
+            host::clock_advance_to(host::clock_now_us() + LV_DEF_REFR_PERIOD * 1000);
+            lv_timer_handler();
+        };
+
+        for (auto i = 0; i < 10; i++)
+            next_frame();
+
+        auto measure = [&](const char* name, const std::function<void(int)>& frame)
+        {
+            auto stats = host::bus_stats();
+            auto flushes_before = flushes;
+
+            for (auto i = 0; i < o.frames; i++)
+            {
+                frame(i);
+                next_frame();
+            }
+
+            print_bus_row(name, host::bus_stats() - stats, o.frames, flushes - flushes_before);
+        };
+
+        measure("frame/idle", [](int) {});
+
+        std::array<std::vector<uint8_t>, 2> volumes{
+            bench::payloads::volume_update_message(0, 0.25f), bench::payloads::volume_update_message(0, 0.75f) };
+        measure("frame/volume_change", [&](int i) { apply(volumes[i % 2]); });
+
+        measure("frame/full", [](int) { lv_obj_invalidate(lv_screen_active()); });
+
+        auto list = lv_obj_get_child(lv_obj_get_child(lv_screen_active(), -1), 0);
+        auto direction = 1;
+        measure("frame/scroll:8px", [&](int)
+        {
+            if (direction > 0 && lv_obj_get_scroll_bottom(list) <= 0) direction = -1;
+            else if (direction < 0 && lv_obj_get_scroll_top(list) <= 0) direction = 1;
+            lv_obj_scroll_by_bounded(list, 0, -direction * 8, LV_ANIM_OFF);
+        });
+
+        lv_display_delete(disp);
+    }
+
+    void print_i2c_row(const char* name, const host::bus_stats_t& s, double count)
+    {
+        std::printf("%-28s %8.0f %10.2f %12.1f %12.1f\n", name, count, s.i2c.transactions / count, s.i2c.bytes / count, s.i2c.time_ns / count / 1000);
+    }
+
+    void report_touch(const options_t& o)
+    {
+        cst328_target_t target;
+        host::i2c_attach(CST328_I2C_ADDR, std::ref(target));
+
+        std::printf("\ntouch: CST328, I2C %u kHz\n\n", I2C_TOUCH_FREQ_HZ / 1000);
+        std::printf("%-28s %8s %10s %12s %12s\n", "", "count", "i2c tx", "i2c bytes", "i2c est us");
+
+        // interrupt driven, as on the device: every INT edge wakes touch_task which reads the point
+        {
+            auto before = host::bus_stats();
+            cst328_driver_t touch(I2C_NUM_0, I2C_TOUCH_FREQ_HZ, GPIO_NUM_21, GPIO_NUM_22, GPIO_NUM_4);
+            touch.init();
+            print_i2c_row("init", host::bus_stats() - before, 1);
+
+            std::counting_semaphore<> touched(0);
+            touch.on_touch([&](const touch_point_t&) { touched.release(); });
+
+            before = host::bus_stats();
+            for (auto i = 0; i < o.touches; i++)
+            {
+                target.x = static_cast<uint16_t>(i % target.width);
+                target.y = static_cast<uint16_t>(i % target.height);
+                host::gpio_raise_isr(GPIO_NUM_4);
+                touched.acquire();
+            }
+            print_i2c_row("touch event (interrupt)", host::bus_stats() - before, o.touches);
+
+            before = host::bus_stats();
+            for (auto i = 0; i < o.touches; i++)
+                touch.get_touch();
+            print_i2c_row("indev read (interrupt)", host::bus_stats() - before, o.touches);
+        }
+
+        // without INT wired every LVGL indev read goes to the bus
+        {
+            cst328_driver_t touch(I2C_NUM_0, I2C_TOUCH_FREQ_HZ, GPIO_NUM_21, GPIO_NUM_22);
+            touch.init();
+
+            auto before = host::bus_stats();
+            for (auto i = 0; i < o.touches; i++)
+                touch.get_touch();
+            auto polled = host::bus_stats() - before;
+            print_i2c_row("indev read (polled)", polled, o.touches);
+
+            constexpr double READS_PER_SECOND = 1000.0 / LV_DEF_REFR_PERIOD;
+            std::printf("%-28s %8s %10.1f %12.1f %12.1f\n", "  per second of polling", "",
+                polled.i2c.transactions / static_cast<double>(o.touches) * READS_PER_SECOND,
+                polled.i2c.bytes / static_cast<double>(o.touches) * READS_PER_SECOND,
+                polled.i2c.time_ns / static_cast<double>(o.touches) * READS_PER_SECOND / 1000);
+        }
+    }
+
+    void usage(const char* name)
+    {
+        std::fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --streams N          streams shown while rendering (10)\n"
+            "  --frames N           frames per display scenario (100)\n"
+            "  --touches N          touch events / indev reads per touch scenario (100)\n"
+            "  --spi-overhead-us N  fixed cost per SPI transaction (15)\n"
+            "  --i2c-overhead-us N  fixed cost per I2C transaction (30)\n", name);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    options_t o;
+    esp_log_level_set("*", ESP_LOG_NONE);
+
+    for (auto i = 1; i < argc; i++)
+    {
+        std::string_view arg = argv[i];
+        auto value = [&]{ return i + 1 < argc ? std::string(argv[++i]) : std::string("0"); };
+
+        if (arg == "--streams") o.streams = std::stoul(value());
+        else if (arg == "--frames") o.frames = std::max(1, std::stoi(value()));
+        else if (arg == "--touches") o.touches = std::max(1, std::stoi(value()));
+        else if (arg == "--spi-overhead-us") o.model.spi_transaction_ns = static_cast<uint32_t>(std::stod(value()) * 1000);
+        else if (arg == "--i2c-overhead-us") o.model.i2c_transaction_ns = static_cast<uint32_t>(std::stod(value()) * 1000);
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    host::bus_model_set(o.model);
+    host::clock_set_virtual(true);
+    host_lvgl::init();
+
+    report_display(o);
+    report_touch(o);
+
+    return 0;
+}
@@ -0,0 +1,222 @@
+// The panel application on the host: the same frame_host_connection_t, message handling and volume_display_t
+// as main.cpp, rendering into a headless display, with the link on a pty, Unix socket or serial port.
+// Point load_gen (or the bridge) at it to exercise the firmware logic without hardware.
+//
+//   ./build-host/device_host unix-listen:/tmp/panel.sock
+//   ./build-host/load_gen unix:/tmp/panel.sock --streams 10
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <utility>
+
+#include "esp_log.h"
+
+#include "protocol/frame_host_connection.hpp"
+#include "protocol/chunk_assembler.hpp"
+#include "protocol/coalescing_outbox.hpp"
+#include "protocol/protocol.hpp"
+#include "volume_display.hpp"
+#include "utils/lv_sync.hpp"
+
+#include "io/fd_transport.hpp"
+#include "lvgl/headless_display.hpp"
+
+namespace
+{
+    constexpr std::array<uint8_t, 2> MAGIC{0x19, 0x16};
+
+    using connection_t = transport::frame_host_connection_t<host_io::fd_transport_t, MAGIC, CONFIG_CP_RX_FRAME_BUFFER_SIZE, 256, 8, CONFIG_CP_SEND_WINDOW, CONFIG_CP_MAX_MESSAGE_SIZE>;
+
+    std::optional<host_io::fd_transport_t> link;
+    std::optional<connection_t> host_connection;
+    std::optional<transport::coalescing_outbox_t<connection_t, std::tuple<std::string, std::string, bridge_message_type_t>>> user_changes;
+    std::optional<transport::coalescing_outbox_t<connection_t, std::tuple<std::string, std::string>, 384, 32>> icon_requests;
+    std::optional<volume_display_t> volume_display;
+    transport::chunk_assembler_t<64 * 1024> large_message;
+
+    template<typename T>
+    void send_bridge_message(const T& message, transport::channel_t channel = transport::channel_t::control, uint32_t retry_interval_ms = 1000, uint32_t retry_count = 3)
+    {
+        host_connection->send_with([&](std::span<uint8_t> out) { return serialize_bridge_message(message, out); }, retry_interval_ms, retry_count, channel);
+    }
+
+    // as in main.cpp, never waits in an LVGL callback and keeps the latest change of a stream
+    template<typename T>
+    void post_user_change(const T& message)
+    {
+        user_changes->post({ message.id.id, message.id.agent_id, message.type }, [&](std::span<uint8_t> out) { return serialize_bridge_message(message, out); });
+    }
+
+    // as in main.cpp, refresh() runs on the receive task with lv_sync held and must not wait for a slot
+    void post_icon_request(const std::string& source, const std::string& agent_id)
+    {
+        get_icon_message_t message{ .source = source, .agent_id = agent_id };
+        if (!icon_requests->post({ source, agent_id }, [&](std::span<uint8_t> out) { return serialize_bridge_message(message, out); }))
+            std::fprintf(stderr, "icon not requested source=%s\n", source.c_str());
+    }
+
+    void post_refresh_request()
+    {
+        request_refresh_message_t message;
+        user_changes->post({ {}, {}, message.type }, [&](std::span<uint8_t> out) { return serialize_bridge_message(message, out); });
+    }
+
+    void on_bridge_message(std::span<const uint8_t> data)
+    {
+        auto bmsg = parse_bridge_message(data);
+        if (auto* msg = std::get_if<streams_message_t>(&bmsg))
+        {
+            volume_display->refresh(msg->updated, msg->deleted);
+        }
+        else if (auto* msg = std::get_if<icon_message_t>(&bmsg))
+        {
+            volume_display->update_icon(msg->source, msg->agent_id, msg->size, msg->size, msg->icon);
+        }
+    }
+
+    void print_stats()
+    {
+        auto s = host_connection->stats();
+
+        lv_mem_monitor_t mem;
+        {
+            std::scoped_lock lock{lv_sync};
+            lv_mem_monitor(&mem);
+        }
+
+        std::printf("streams %zu | rx frames %u (%u chunked, %u duplicates dropped), reassembled %u (%u fragments dropped) | tx frames %u, retransmissions %u, acked %u, timed out %u, queue full %u, fragmented %u, rto %.1f ms | lvgl heap %zu/%zu B\n",
+            volume_display->size(), s.rx_frames, s.rx_chunked_frames, s.rx_duplicates, s.rx_reassembled, s.rx_fragments_dropped,
+            s.tx_frames, s.retransmissions, s.acked, s.timed_out, s.queue_full, s.tx_fragmented, s.rto_us / 1000.0,
+            mem.total_size - mem.free_size, mem.total_size);
+        std::fflush(stdout);
+    }
+
+    void usage(const char* name)
+    {
+        std::fprintf(stderr,
+            "usage: %s [options] ENDPOINT\n"
+            "  ENDPOINT             pty | unix:PATH | unix-listen:PATH | SERIAL[@BAUD]\n"
+            "  --stats-interval N   print connection stats every N seconds, 0 disables (5)\n"
+            "  --verbose            enable device logging\n", name);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string endpoint;
+    double stats_interval = 5;
+    esp_log_level_set("*", ESP_LOG_WARN);
+
+    for (auto i = 1; i < argc; i++)
+    {
+        std::string_view arg = argv[i];
+        auto value = [&]{ return i + 1 < argc ? std::string(argv[++i]) : std::string("0"); };
+
+        if (arg == "--stats-interval") stats_interval = std::stod(value());
+        else if (arg == "--verbose") esp_log_level_set("*", ESP_LOG_INFO);
+        else if (!arg.starts_with("--") && endpoint.empty()) endpoint = arg;
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (endpoint.empty())
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    host_lvgl::init();
+    host_lvgl::headless_display_t display;
+    app_style::init(display.display());
+
+    link.emplace(host_io::open_endpoint(endpoint, [](const std::string& where)
+    {
+        std::printf("waiting on %s\n", where.c_str());
+        std::fflush(stdout);
+    }));
+
+    host_connection.emplace(*link);
+    host_connection->set_ack_delay(CONFIG_CP_ACK_DELAY_MS);
+    host_connection->set_app_capabilities(static_cast<uint8_t>(transport::pixel_format_t::rgb565a8) | static_cast<uint8_t>(transport::pixel_format_t::a8), 0);
+    host_connection->init();
+    user_changes.emplace(*host_connection);
+    icon_requests.emplace(*host_connection, transport::channel_t::assets);
+
+    volume_display.emplace(0, 0, LV_PCT(100), LV_PCT(100));
+    {
+        std::scoped_lock lock{lv_sync};
+        lv_timer_create([](lv_timer_t*)
+        {
+            user_changes->flush();
+            icon_requests->flush();
+        }, 100, nullptr);
+    }
+    volume_display->on_volume_change([](const event_id& id, float volume)
+    {
+        post_user_change(set_volume_message_t {
+            .id = { id.id, id.agent_id },
+            .volume = volume
+        });
+    });
+    volume_display->on_mute_change([](const event_id& id, bool mute)
+    {
+        post_user_change(set_mute_message_t {
+            .id = { id.id, id.agent_id },
+            .mute = mute
+        });
+    });
+    volume_display->on_icon_missing(post_icon_request);
+
+    host_connection->register_data_handler(on_bridge_message);
+    host_connection->register_chunk_handler([](const transport::frame_chunk_t& chunk)
+    {
+        large_message.add(chunk, on_bridge_message);
+    });
+
+    // as in main.cpp, the streams are asked for at boot and again every time the link comes back
+    send_bridge_message(request_refresh_message_t{}, transport::channel_t::control, 1000, std::numeric_limits<uint32_t>::max());
+    host_connection->register_link_handler([](bool up)
+    {
+        static bool was_up = false;
+        std::printf("link %s\n", up ? "up" : "down");
+        std::fflush(stdout);
+        if (up && std::exchange(was_up, true))
+            post_refresh_request();
+    });
+    host_connection->set_keepalive(CONFIG_CP_KEEPALIVE_INTERVAL_MS, CONFIG_CP_KEEPALIVE_MISSES);
+
+    // the lv_timer_handler task of main.cpp
+    auto next_stats = std::chrono::steady_clock::now();
+    while (!link->closed())
+    {
+        uint32_t next;
+        {
+            std::scoped_lock lock{lv_timer_sync};
+            next = lv_timer_handler();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(std::clamp<uint32_t>(next, 1, 50)));
+
+        if (stats_interval > 0 && std::chrono::steady_clock::now() >= next_stats)
+        {
+            print_stats();
+            next_stats += std::chrono::milliseconds(static_cast<int64_t>(stats_interval * 1000));
+        }
+    }
+
+    std::printf("link closed\n");
+    print_stats();
+
+    // the send task never returns, leave without running destructors under it
+    std::_Exit(0);
+}
@@ -0,0 +1,450 @@
+// iperf for the panel link: measures round-trip time and sustained throughput in both directions over a real
+// UART or BT SPP link (or device_host on a pty/Unix socket) using the ping and bulk frame types, which
+// frame_host_connection_t answers below the MsgPack layer.
+//
+//   rtt   ping/pong round trips for a few payload sizes
+//   up    host -> panel: unacknowledged bulk frames, then a ping whose pong carries the panel's bulk counters
+//   down  panel -> host: a bulk_request, after which the panel streams bulk frames back
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "esp_log.h"
+
+#include "protocol/framer.hpp"
+
+#include "io/fd_transport.hpp"
+
+namespace
+{
+    constexpr std::array<uint8_t, 2> MAGIC{0x19, 0x16};
+
+    using framer_type = transport::framer_t<MAGIC, 16 * 1024>;
+    using clock_type = std::chrono::steady_clock;
+
+    constexpr std::array<const char*, 3> FRAMING_NAMES{ "magic", "cobs", "fec" };
+
+    transport::framing_t parse_framing(const std::string& name)
+    {
+        auto it = std::ranges::find(FRAMING_NAMES, name);
+        return it == FRAMING_NAMES.end() ? transport::framing_t::magic : static_cast<transport::framing_t>(it - FRAMING_NAMES.begin());
+    }
+
+    struct options_t
+    {
+        std::string endpoint;
+        bool rtt = true;
+        bool up = true;
+        bool down = true;
+        std::vector<std::size_t> ping_sizes{ 0, 64, 200 };
+        int pings = 100;
+        std::size_t bytes = 256 * 1024;
+        std::size_t frame_size = 240;          // the panel sends at most MAX_TX_FRAME - 9 (247) per frame
+        std::chrono::milliseconds timeout{2000};
+        transport::framing_t framing = transport::framing_t::magic;
+    };
+
+    double since_us(clock_type::time_point start, clock_type::time_point end = clock_type::now())
+    {
+        return std::chrono::duration<double, std::micro>(end - start).count();
+    }
+
+    struct pong_t
+    {
+        double rtt_us;
+        transport::bulk_report_t report;
+    };
+
+    struct bulk_rx_t
+    {
+        uint32_t frames = 0;
+        uint64_t bytes = 0;
+        clock_type::time_point first;
+        clock_type::time_point last;
+    };
+
+    class perf_link_t
+    {
+    public:
+        explicit perf_link_t(host_io::fd_transport_t& transport)
+            : _transport(transport)
+            , _rx_framer(std::make_unique<framer_type>())
+        {
+            _transport.on_receive([this](std::span<uint8_t> data) { on_data(data); });
+        }
+
+        ~perf_link_t()
+        {
+            _transport.stop();
+        }
+
+        std::optional<pong_t> ping(std::size_t size, std::chrono::milliseconds timeout)
+        {
+            std::vector<uint8_t> payload(size);
+            for (std::size_t i = 0; i < size; i++)
+                payload[i] = static_cast<uint8_t>(i);
+
+            std::unique_lock lock{_sync};
+            auto seq = ++_seq;
+            _pong.reset();
+            lock.unlock();
+
+            auto start = clock_type::now();
+            write(seq, transport::frame_type_t::ping, payload);
+
+            lock.lock();
+            if (!_pong_cv.wait_for(lock, timeout, [&] { return _pong && _pong->seq == seq; }))
+                return {};
+
+            return pong_t{ since_us(start, _pong->at), _pong->report };
+        }
+
+        // Asks the panel to switch framing, its echo is the last frame in the old one.
+        bool set_framing(transport::framing_t framing, std::chrono::milliseconds timeout)
+        {
+            std::array<uint8_t, 1> payload{ static_cast<uint8_t>(framing) };
+
+            std::unique_lock lock{_sync};
+            auto seq = ++_seq;
+            lock.unlock();
+
+            write(seq, transport::frame_type_t::framing, payload);
+
+            lock.lock();
+            if (!_framing_cv.wait_for(lock, timeout, [&] { return _rx_framer->framing() == framing; }))
+                return false;
+            lock.unlock();
+
+            std::scoped_lock tx_lock{_tx_sync};
+            _framer.set_framing(framing);
+            return true;
+        }
+
+        // Writes bulk frames back to back and returns the bytes put on the wire.
+        uint64_t send_bulk(std::size_t bytes, std::size_t frame_size)
+        {
+            std::vector<uint8_t> payload(frame_size);
+            uint64_t written = 0;
+
+            for (std::size_t sent = 0; sent < bytes; sent += frame_size)
+            {
+                auto size = std::min(frame_size, bytes - sent);
+                written += write(++_seq, transport::frame_type_t::bulk, std::span(payload).subspan(0, size));
+            }
+
+            return written;
+        }
+
+        void request_bulk(std::size_t bytes, std::size_t frame_size)
+        {
+            std::array<uint8_t, transport::bulk_request_t::SIZE> payload;
+            transport::bulk_request_t{ static_cast<uint32_t>(bytes), static_cast<uint16_t>(frame_size) }.to_bytes(payload);
+
+            {
+                std::scoped_lock lock{_sync};
+                _bulk = {};
+            }
+            write(++_seq, transport::frame_type_t::bulk_request, payload);
+        }
+
+        // Waits until `bytes` bulk payload arrived or nothing arrived for `idle`.
+        bulk_rx_t wait_bulk(std::size_t bytes, std::chrono::milliseconds idle)
+        {
+            std::unique_lock lock{_sync};
+            while (_bulk.bytes < bytes)
+            {
+                auto received = _bulk.bytes;
+                if (!_bulk_cv.wait_for(lock, idle, [&] { return _bulk.bytes != received; }))
+                    break;
+            }
+
+            return _bulk;
+        }
+
+    private:
+        std::size_t write(uint16_t seq, transport::frame_type_t type, std::span<uint8_t> payload)
+        {
+            std::scoped_lock lock{_tx_sync};
+
+            _tx_buffer.resize(framer_type::calc_max_frame_size(payload.size()));
+            auto size = _framer.to_bytes(_tx_buffer, transport::frame_t{ seq, type, payload });
+            _transport.write(std::span(_tx_buffer).subspan(0, size));
+
+            return size;
+        }
+
+        void on_data(std::span<uint8_t> data)
+        {
+            auto now = clock_type::now();
+
+            _rx_framer->feed(data, [&](const transport::frame_t& frame)
+            {
+                switch (frame.type)
+                {
+                    case transport::frame_type_t::pong:
+                        if (auto report = transport::bulk_report_t::from_bytes(frame.data.last(std::min(frame.data.size(), transport::bulk_report_t::SIZE))))
+                        {
+                            std::scoped_lock lock{_sync};
+                            _pong = received_pong_t{ frame.seq, now, *report };
+                            _pong_cv.notify_all();
+                        }
+                        break;
+                    case transport::frame_type_t::bulk:
+                        {
+                            std::scoped_lock lock{_sync};
+                            if (!_bulk.frames)
+                                _bulk.first = now;
+                            _bulk.frames++;
+                            _bulk.bytes += frame.data.size();
+                            _bulk.last = now;
+                            _bulk_cv.notify_all();
+                        }
+                        break;
+                    case transport::frame_type_t::framing:
+                        if (frame.data.size() == 1)
+                        {
+                            std::scoped_lock lock{_sync};
+                            _rx_framer->set_framing(static_cast<transport::framing_t>(frame.data[0]));
+                            _framing_cv.notify_all();
+                        }
+                        break;
+                    case transport::frame_type_t::data:
+                        // the panel sends request_refresh and log lines on its own, ack them so it does not stall
+                        write(frame.seq, transport::frame_type_t::ack, {});
+                        break;
+                    default:
+                        break;
+                }
+            });
+        }
+
+    private:
+        struct received_pong_t
+        {
+            uint16_t seq;
+            clock_type::time_point at;
+            transport::bulk_report_t report;
+        };
+
+        host_io::fd_transport_t& _transport;
+        framer_type _framer;
+        std::unique_ptr<framer_type> _rx_framer;
+        std::vector<uint8_t> _tx_buffer;
+        std::mutex _tx_sync;
+
+        std::mutex _sync;
+        std::condition_variable _pong_cv;
+        std::condition_variable _bulk_cv;
+        std::condition_variable _framing_cv;
+        std::optional<received_pong_t> _pong;
+        bulk_rx_t _bulk;
+        uint16_t _seq = 0;
+    };
+
+    double percentile(const std::vector<double>& sorted, double p)
+    {
+        if (sorted.empty())
+            return 0;
+
+        auto index = static_cast<std::size_t>(p * (sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+
+    double kib_per_s(uint64_t bytes, double us)
+    {
+        return us > 0 ? bytes / 1024.0 / (us / 1e6) : 0;
+    }
+
+    void run_rtt(perf_link_t& link, const options_t& o)
+    {
+        std::printf("rtt\n  %8s %6s %6s %10s %10s %10s %10s %10s\n", "payload", "sent", "lost", "min ms", "p50 ms", "p90 ms", "p99 ms", "max ms");
+
+        for (auto size: o.ping_sizes)
+        {
+            std::vector<double> rtts;
+            auto lost = 0;
+
+            for (auto i = 0; i < o.pings; i++)
+            {
+                if (auto pong = link.ping(size, o.timeout))
+                    rtts.emplace_back(pong->rtt_us / 1000);
+                else
+                    lost++;
+            }
+
+            std::ranges::sort(rtts);
+            std::printf("  %8zu %6d %6d %10.2f %10.2f %10.2f %10.2f %10.2f\n", size, o.pings, lost,
+                rtts.empty() ? 0 : rtts.front(), percentile(rtts, 0.5), percentile(rtts, 0.9), percentile(rtts, 0.99),
+                rtts.empty() ? 0 : rtts.back());
+            std::fflush(stdout);
+        }
+    }
+
+    bool run_up(perf_link_t& link, const options_t& o)
+    {
+        std::printf("up (host -> panel), %zu B in %zu B frames\n", o.bytes, o.frame_size);
+
+        auto before = link.ping(0, o.timeout);
+        if (!before)
+        {
+            std::printf("  no pong from the panel\n");
+            return false;
+        }
+
+        auto start = clock_type::now();
+        auto wire = link.send_bulk(o.bytes, o.frame_size);
+        auto written_us = since_us(start);
+
+        // the pong is queued behind the bulk frames, so it arrives once the panel has parsed all of them
+        auto after = link.ping(0, std::chrono::milliseconds(o.timeout.count() + static_cast<int64_t>(written_us / 1000) * 4));
+        if (!after)
+        {
+            std::printf("  no pong after the bulk transfer\n");
+            return false;
+        }
+
+        auto elapsed_us = since_us(start) - after->rtt_us / 2;
+        auto frames = static_cast<uint32_t>((o.bytes + o.frame_size - 1) / o.frame_size);
+        auto received_frames = after->report.frames - before->report.frames;
+        auto received_bytes = after->report.bytes - before->report.bytes;
+
+        std::printf("  frames   sent %u, received %u, lost %u\n", frames, received_frames, frames - std::min(frames, received_frames));
+        std::printf("  payload  %.2f KiB/s over %.3f s (%.3f s to write)\n", kib_per_s(received_bytes, elapsed_us), elapsed_us / 1e6, written_us / 1e6);
+        std::printf("  wire     %.2f KiB/s, %.1f%% framing overhead\n", kib_per_s(wire, elapsed_us), 100.0 * (wire - o.bytes) / wire);
+        std::fflush(stdout);
+
+        return true;
+    }
+
+    void run_down(perf_link_t& link, const options_t& o)
+    {
+        std::printf("down (panel -> host), %zu B in %zu B frames\n", o.bytes, o.frame_size);
+
+        auto start = clock_type::now();
+        link.request_bulk(o.bytes, o.frame_size);
+        auto rx = link.wait_bulk(o.bytes, o.timeout);
+
+        if (!rx.frames)
+        {
+            std::printf("  no bulk frames from the panel\n");
+            return;
+        }
+
+        auto first_us = since_us(start, rx.first);
+        auto total_us = since_us(start, rx.last);
+        auto steady_us = since_us(rx.first, rx.last);
+        auto payload_per_frame = static_cast<double>(rx.bytes) / rx.frames;
+        auto wire_per_frame = o.framing == transport::framing_t::cobs ? framer_type::calc_cobs_frame_size(static_cast<std::size_t>(payload_per_frame))
+            : o.framing == transport::framing_t::magic_fec ? framer_type::calc_fec_frame_size(static_cast<std::size_t>(payload_per_frame))
+            : payload_per_frame + framer_type::calc_frame_size(0);
+
+        std::printf("  frames   received %u, %llu of %zu B%s\n", rx.frames, static_cast<unsigned long long>(rx.bytes), o.bytes,
+            rx.bytes < o.bytes ? " (stopped after an idle timeout)" : "");
+        std::printf("  payload  %.2f KiB/s over %.3f s, first frame after %.2f ms\n", kib_per_s(rx.bytes, total_us), total_us / 1e6, first_us / 1000);
+        if (rx.frames > 1)
+            std::printf("  steady   %.2f KiB/s payload, %.2f KiB/s wire\n",
+                kib_per_s(rx.bytes - payload_per_frame, steady_us), kib_per_s(static_cast<uint64_t>((rx.frames - 1) * wire_per_frame), steady_us));
+        std::fflush(stdout);
+    }
+
+    void usage(const char* name)
+    {
+        std::fprintf(stderr,
+            "usage: %s [options] ENDPOINT\n"
+            "  ENDPOINT               pty | unix:PATH | unix-listen:PATH | SERIAL[@BAUD]\n"
+            "  --only rtt|up|down     run a single test, may be repeated\n"
+            "  --ping-sizes N,N,...   ping payload sizes, at most 239 for the panel (0,64,200)\n"
+            "  --pings N              pings per size (100)\n"
+            "  --bytes N              bulk payload per direction (262144)\n"
+            "  --frame-size N         bulk payload per frame (240)\n"
+            "  --timeout-ms N         pong timeout and idle timeout of the down test (2000)\n"
+            "  --framing NAME         switch the link to magic, cobs or fec framing before the tests (magic)\n"
+            "  --verbose              enable framer logging\n", name);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    options_t o;
+    auto only = false;
+    esp_log_level_set("*", ESP_LOG_NONE);
+
+    for (auto i = 1; i < argc; i++)
+    {
+        std::string_view arg = argv[i];
+        auto value = [&]{ return i + 1 < argc ? std::string(argv[++i]) : std::string("0"); };
+
+        if (arg == "--only")
+        {
+            if (!only)
+                o.rtt = o.up = o.down = false;
+            only = true;
+
+            auto test = value();
+            if (test == "rtt") o.rtt = true;
+            else if (test == "up") o.up = true;
+            else if (test == "down") o.down = true;
+            else
+            {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "--ping-sizes")
+        {
+            o.ping_sizes.clear();
+            auto list = value();
+            for (std::size_t start = 0; start < list.size();)
+            {
+                auto end = std::min(list.find(',', start), list.size());
+                o.ping_sizes.emplace_back(std::stoul(list.substr(start, end - start)));
+                start = end + 1;
+            }
+        }
+        else if (arg == "--pings") o.pings = std::max(1, std::stoi(value()));
+        else if (arg == "--bytes") o.bytes = std::stoul(value());
+        else if (arg == "--frame-size") o.frame_size = std::clamp<std::size_t>(std::stoul(value()), 1, UINT16_MAX - framer_type::calc_frame_size(0));
+        else if (arg == "--timeout-ms") o.timeout = std::chrono::milliseconds(std::stoi(value()));
+        else if (arg == "--framing") o.framing = parse_framing(value());
+        else if (arg == "--verbose") esp_log_level_set("*", ESP_LOG_INFO);
+        else if (!arg.starts_with("--") && o.endpoint.empty()) o.endpoint = arg;
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (o.endpoint.empty())
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    host_io::fd_transport_t transport(host_io::open_endpoint(o.endpoint, [](const std::string& where)
+    {
+        std::printf("waiting on %s\n", where.c_str());
+        std::fflush(stdout);
+    }));
+    perf_link_t link(transport);
+
+    if (o.framing != transport::framing_t::magic && !link.set_framing(o.framing, o.timeout))
+    {
+        std::printf("the panel did not confirm the framing switch\n");
+        return 1;
+    }
+
+    if (o.rtt) run_rtt(link, o);
+    if (o.up && !run_up(link, o)) return 1;
+    if (o.down) run_down(link, o);
+
+    return 0;
+}
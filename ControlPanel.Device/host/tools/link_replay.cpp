@@ -0,0 +1,273 @@
+// Replays a link capture (see main/protocol/transport/link_capture.hpp) through the device receive path
+// on the host: framer_t -> parse_bridge_message -> volume_display_t on a headless LVGL display, and
+// reports the time spent in each stage.
+//
+//   parttool.py read_partition --partition-name storage --output link.cap
+//   ./build-host/link_replay link.cap
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "esp_log.h"
+
+#include "protocol/framer.hpp"
+#include "protocol/protocol.hpp"
+#include "protocol/link_capture_format.hpp"
+#include "volume_display.hpp"
+
+#include "lvgl/headless_display.hpp"
+
+namespace
+{
+    constexpr std::array<uint8_t, 2> MAGIC{0x19, 0x16};
+    constexpr std::size_t BUFFER_SIZE = 16 * 1024;
+
+    using framer_type = transport::framer_t<MAGIC, BUFFER_SIZE>;
+    using clock_type = std::chrono::steady_clock;
+
+    struct options_t
+    {
+        std::string path;
+        int repeat = 1;
+        std::size_t slowest = 5;
+        bool render = true;
+    };
+
+    struct stage_t
+    {
+        const char* name;
+        std::vector<double> samples_us{};
+
+        void add(clock_type::time_point start)
+        {
+            samples_us.emplace_back(std::chrono::duration<double, std::micro>(clock_type::now() - start).count());
+        }
+
+        void print()
+        {
+            std::ranges::sort(samples_us);
+
+            auto total = 0.0;
+            for (auto s: samples_us)
+                total += s;
+
+            auto at = [&](double p) { return samples_us.empty() ? 0.0 : samples_us[static_cast<std::size_t>(p * (samples_us.size() - 1) + 0.5)]; };
+
+            std::printf("%-12s %8zu %12.2f %10.1f %10.1f %10.1f %10.1f\n", name, samples_us.size(), total / 1000,
+                samples_us.empty() ? 0.0 : total / samples_us.size(), at(0.5), at(0.99), samples_us.empty() ? 0.0 : samples_us.back());
+        }
+    };
+
+    struct message_cost_t
+    {
+        std::size_t index;
+        uint64_t timestamp_us;
+        std::size_t size;
+        std::string what;
+        double parse_us;
+        double apply_us;
+        double render_us;
+
+        double total() const { return parse_us + apply_us + render_us; }
+    };
+
+    struct replay_t
+    {
+        stage_t feed{"framer"};
+        stage_t parse{"parse"};
+        stage_t refresh{"refresh"};
+        stage_t icon{"update_icon"};
+        stage_t render{"render"};
+
+        std::size_t chunks = 0;
+        std::size_t bytes = 0;
+        std::size_t data_frames = 0;
+        std::size_t ack_frames = 0;
+        std::size_t streams = 0;
+        std::size_t icons = 0;
+        std::size_t other = 0;
+        uint64_t duration_us = 0;
+        std::vector<message_cost_t> messages;
+    };
+
+    double since_us(clock_type::time_point start)
+    {
+        return std::chrono::duration<double, std::micro>(clock_type::now() - start).count();
+    }
+
+    void replay(std::span<const uint8_t> capture, const options_t& o, host_lvgl::headless_display_t& display, replay_t& r)
+    {
+        auto framer = std::make_unique<framer_type>();
+        auto volume_display = std::make_unique<volume_display_t>(0, 0, LV_PCT(100), LV_PCT(100));
+        std::vector<std::vector<uint8_t>> frames;
+
+        link_capture::reader_t reader(capture);
+        while (auto record = reader.next())
+        {
+            r.chunks++;
+            r.bytes += record->data.size();
+            r.duration_us = record->timestamp_us;
+
+            frames.clear();
+
+            auto start = clock_type::now();
+            framer->feed(record->data, [&](const transport::frame_t& frame)
+            {
+                if (frame.type == transport::frame_type_t::ack)
+                {
+                    r.ack_frames++;
+                    return;
+                }
+
+                frames.emplace_back(frame.data.begin(), frame.data.end());
+            });
+            r.feed.add(start);
+
+            for (const auto& data: frames)
+            {
+                message_cost_t cost{ .index = r.data_frames++, .timestamp_us = record->timestamp_us, .size = data.size() };
+
+                start = clock_type::now();
+                auto bmsg = parse_bridge_message(data);
+                r.parse.add(start);
+                cost.parse_us = r.parse.samples_us.back();
+
+                start = clock_type::now();
+                if (auto* msg = std::get_if<streams_message_t>(&bmsg))
+                {
+                    volume_display->refresh(msg->updated, msg->deleted);
+                    r.refresh.add(start);
+                    r.streams++;
+                    cost.what = "streams updated=" + std::to_string(msg->updated.size()) + " deleted=" + std::to_string(msg->deleted.size());
+                }
+                else if (auto* msg = std::get_if<icon_message_t>(&bmsg))
+                {
+                    volume_display->update_icon(msg->source, msg->agent_id, msg->size, msg->size, msg->icon);
+                    r.icon.add(start);
+                    r.icons++;
+                    cost.what = "icon size=" + std::to_string(msg->size);
+                }
+                else
+                {
+                    r.other++;
+                    cost.what = "other";
+                }
+                cost.apply_us = since_us(start);
+
+                if (o.render)
+                {
+                    start = clock_type::now();
+                    lv_refr_now(display.display());
+                    r.render.add(start);
+                    cost.render_us = r.render.samples_us.back();
+                }
+
+                r.messages.emplace_back(std::move(cost));
+            }
+        }
+    }
+
+    void print(replay_t& r, const options_t& o, const host_lvgl::headless_display_t& display)
+    {
+        std::printf("capture: %zu chunks, %zu bytes over %.3f s\n", r.chunks / o.repeat, r.bytes / o.repeat, r.duration_us / 1e6);
+        std::printf("frames: data %zu, ack %zu; messages: streams %zu, icons %zu, other %zu\n",
+            r.data_frames / o.repeat, r.ack_frames / o.repeat, r.streams / o.repeat, r.icons / o.repeat, r.other / o.repeat);
+        if (o.repeat > 1)
+            std::printf("replayed %d times, stage numbers cover all runs\n", o.repeat);
+        if (o.render)
+            std::printf("display: %llu flushes, %llu pixels\n",
+                static_cast<unsigned long long>(display.flushes()), static_cast<unsigned long long>(display.flushed_pixels()));
+
+        std::printf("\n%-12s %8s %12s %10s %10s %10s %10s\n", "stage", "count", "total ms", "mean us", "p50 us", "p99 us", "max us");
+        for (auto stage: { &r.feed, &r.parse, &r.refresh, &r.icon, &r.render })
+            stage->print();
+
+        auto n = std::min(o.slowest, r.messages.size());
+        if (n == 0)
+            return;
+
+        std::ranges::partial_sort(r.messages, r.messages.begin() + static_cast<std::ptrdiff_t>(n),
+            [](const auto& a, const auto& b) { return a.total() > b.total(); });
+
+        std::printf("\nslowest messages\n");
+        for (std::size_t i = 0; i < n; i++)
+        {
+            const auto& m = r.messages[i];
+            std::printf("  #%-5zu t=%9.3f s %7zu B  %-32s parse %8.1f us  apply %8.1f us  render %8.1f us\n",
+                m.index, m.timestamp_us / 1e6, m.size, m.what.c_str(), m.parse_us, m.apply_us, m.render_us);
+        }
+    }
+
+    void usage(const char* name)
+    {
+        std::fprintf(stderr,
+            "usage: %s [options] capture\n"
+            "  --repeat N     replay the capture N times, each on a fresh volume_display_t (1)\n"
+            "  --slowest N    list the N most expensive messages (5)\n"
+            "  --no-render    skip lv_refr_now after each message\n"
+            "  --verbose      enable device logging\n", name);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    options_t o;
+    esp_log_level_set("*", ESP_LOG_NONE);
+
+    for (auto i = 1; i < argc; i++)
+    {
+        std::string_view arg = argv[i];
+        auto value = [&]{ return i + 1 < argc ? std::string(argv[++i]) : std::string("0"); };
+
+        if (arg == "--repeat") o.repeat = std::max(1, std::stoi(value()));
+        else if (arg == "--slowest") o.slowest = std::stoul(value());
+        else if (arg == "--no-render") o.render = false;
+        else if (arg == "--verbose") esp_log_level_set("*", ESP_LOG_INFO);
+        else if (!arg.starts_with("--") && o.path.empty()) o.path = arg;
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (o.path.empty())
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::ifstream file(o.path, std::ios::binary);
+    std::vector<uint8_t> capture{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    if (!file.good() && !file.eof())
+    {
+        std::fprintf(stderr, "cannot read %s\n", o.path.c_str());
+        return 1;
+    }
+
+    if (!link_capture::reader_t(capture).valid())
+    {
+        std::fprintf(stderr, "%s is not a link capture\n", o.path.c_str());
+        return 1;
+    }
+
+    host_lvgl::init();
+    host_lvgl::headless_display_t display;
+    app_style::init(display.display());
+
+    replay_t r;
+    for (auto i = 0; i < o.repeat; i++)
+        replay(capture, o, display, r);
+
+    print(r, o, display);
+
+    return 0;
+}
@@ -0,0 +1,503 @@
+// Bridge stand-in that drives a panel (hardware on a serial port, or device_host on a pty/Unix socket) with a
+// scripted workload: create N streams, change volumes at a fixed rate, delete them again, and answer the
+// icon requests and refreshes the panel sends back. It reports ack latency per phase and how long the panel
+// takes to converge after each phase.
+//
+// Convergence is measured with a probe stream: after a phase one more stream is added, and the panel has
+// caught up once it asks for the probe's icon, because it handles messages in order.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "esp_log.h"
+
+#include "protocol/framer.hpp"
+#include "protocol/protocol.hpp"
+
+#include "bench/payloads.hpp"
+#include "io/fd_transport.hpp"
+
+namespace
+{
+    constexpr std::array<uint8_t, 2> MAGIC{0x19, 0x16};
+    constexpr std::size_t PROBE_INDEX = 1'000'000;
+
+    using framer_type = transport::framer_t<MAGIC, 4096>;
+    using clock_type = std::chrono::steady_clock;
+
+    struct options_t
+    {
+        std::string endpoint;
+        std::size_t streams = 10;
+        std::size_t batch = 0;              // streams per message, 0 sends all of them in one message like the bridge
+        std::size_t step = 0;               // grow the stream count by step after every cycle
+        std::size_t max_streams = 0;
+        int cycles = 1;
+        double volume_rate = 20;
+        double volume_seconds = 5;
+        int title_width = bench::payloads::TITLE_WIDTH;
+        int title_height = bench::payloads::TITLE_HEIGHT;
+        int icon_size = bench::payloads::ICON_SIZE;
+        bool icons = true;
+        std::chrono::milliseconds ack_timeout{5000};    // ControllerConnection defaults
+        int retries = 3;
+        std::chrono::milliseconds converge_timeout{10000};
+    };
+
+    double since_us(clock_type::time_point start)
+    {
+        return std::chrono::duration<double, std::micro>(clock_type::now() - start).count();
+    }
+
+    struct device_event_t
+    {
+        bridge_message_type_t type;
+        std::string source;
+        std::string agent_id;
+    };
+
+    // Stop-and-wait sender and acking receiver, same behaviour as FrameProtocol in the bridge.
+    class bridge_link_t
+    {
+    public:
+        struct result_t
+        {
+            bool acked;
+            int attempts;
+            double latency_us;
+        };
+
+        explicit bridge_link_t(host_io::fd_transport_t& transport)
+            : _transport(transport)
+            , _rx_framer(std::make_unique<framer_type>())
+        {
+            _transport.on_receive([this](std::span<uint8_t> data) { on_data(data); });
+        }
+
+        ~bridge_link_t()
+        {
+            _transport.stop();
+        }
+
+        result_t send(std::span<const uint8_t> message, std::chrono::milliseconds timeout, int retries)
+        {
+            if (message.size() > UINT16_MAX - framer_type::calc_frame_size(0))
+            {
+                std::fprintf(stderr, "message of %zu B does not fit in a frame\n", message.size());
+                return { false, 0, 0 };
+            }
+
+            std::vector<uint8_t> bytes(framer_type::calc_frame_size(message.size()) + 1);
+            transport::frame_t frame{ ++_seq, transport::frame_type_t::data, message };
+            bytes.resize(_framer.to_bytes(bytes, frame));
+
+            auto start = clock_type::now();
+            for (auto attempt = 1; attempt <= retries; attempt++)
+            {
+                _transport.write(bytes);
+                _bytes_sent += bytes.size();
+
+                std::unique_lock lock{_sync};
+                if (_acked.wait_for(lock, timeout, [&] { return _last_ack == frame.seq; }))
+                    return { true, attempt, since_us(start) };
+            }
+
+            return { false, retries, since_us(start) };
+        }
+
+        std::optional<device_event_t> next_event(std::chrono::milliseconds timeout)
+        {
+            std::unique_lock lock{_sync};
+            if (!_event.wait_for(lock, timeout, [&] { return !_events.empty(); }))
+                return {};
+
+            auto e = std::move(_events.front());
+            _events.pop_front();
+            return e;
+        }
+
+        uint64_t bytes_sent() const { return _bytes_sent; }
+
+    private:
+        void on_data(std::span<uint8_t> data)
+        {
+            _rx_framer->feed(data, [&](const transport::frame_t& frame)
+            {
+                if (frame.type == transport::frame_type_t::ack)
+                {
+                    std::scoped_lock lock{_sync};
+                    _last_ack = frame.seq;
+                    _acked.notify_all();
+                    return;
+                }
+
+                if (frame.type == transport::frame_type_t::ping)
+                {
+                    // the panel's keepalive, answered like the bridge does
+                    transport::frame_t pong{ frame.seq, transport::frame_type_t::pong, {} };
+                    _transport.write(std::span(_ack_buffer).subspan(0, _framer.to_bytes(_ack_buffer, pong)));
+                    return;
+                }
+
+                if (frame.type != transport::frame_type_t::data)
+                    return;
+
+                transport::frame_t ack{ frame.seq, transport::frame_type_t::ack, {} };
+                _transport.write(std::span(_ack_buffer).subspan(0, _framer.to_bytes(_ack_buffer, ack)));
+
+                if (frame.seq == _last_rx_seq && _last_rx_seq > 0)
+                    return;
+                _last_rx_seq = frame.seq;
+
+                JsonDocument doc;
+                if (deserializeMsgPack(doc, frame.data.data(), frame.data.size()))
+                    return;
+
+                device_event_t e{ doc["type"].as<bridge_message_type_t>(), doc["source"] | "", doc["agent_id"] | "" };
+
+                std::scoped_lock lock{_sync};
+                _events.emplace_back(std::move(e));
+                _event.notify_all();
+            });
+        }
+
+    private:
+        host_io::fd_transport_t& _transport;
+        framer_type _framer;
+        std::unique_ptr<framer_type> _rx_framer;
+        std::array<uint8_t, framer_type::calc_frame_size(0) * 2> _ack_buffer{};
+
+        std::mutex _sync;
+        std::condition_variable _acked;
+        std::condition_variable _event;
+        std::deque<device_event_t> _events;
+        uint16_t _seq = 0;
+        uint16_t _last_ack = 0;
+        uint16_t _last_rx_seq = 0;
+        std::atomic<uint64_t> _bytes_sent = 0;
+    };
+
+    struct phase_t
+    {
+        std::string name;
+        std::size_t messages = 0;
+        std::size_t bytes = 0;
+        uint32_t retries = 0;
+        uint32_t timeouts = 0;
+        std::vector<double> latencies_us;
+        std::optional<double> converge_us;
+        double seconds = 0;
+
+        bool failed() const { return timeouts > 0 || !converge_us; }
+    };
+
+    struct counters_t
+    {
+        uint32_t get_icon = 0;
+        uint32_t icons_sent = 0;
+        uint32_t request_refresh = 0;
+        uint32_t set_volume = 0;
+        uint32_t set_mute = 0;
+        uint32_t log_lines = 0;
+    };
+
+    class workload_t
+    {
+    public:
+        workload_t(bridge_link_t& link, const options_t& o)
+            : _link(link)
+            , _o(o)
+        {
+        }
+
+        phase_t create(std::size_t count)
+        {
+            phase_t phase{ .name = "create:" + std::to_string(count) };
+            auto start = clock_type::now();
+
+            auto batch = _o.batch ? _o.batch : count;
+            for (std::size_t first = _live; first < _live + count; first += batch)
+            {
+                auto n = std::min(batch, _live + count - first);
+                send(phase, bench::payloads::streams_message(n, 0, first, _o.title_width, _o.title_height));
+            }
+            _live += count;
+
+            converge(phase, start);
+            return phase;
+        }
+
+        phase_t change_volumes()
+        {
+            phase_t phase{ .name = "volume:" + std::to_string(static_cast<int>(_o.volume_rate)) + "/s" };
+            auto start = clock_type::now();
+
+            if (_live > 0 && _o.volume_rate > 0)
+            {
+                auto interval = std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>(1.0 / _o.volume_rate));
+                auto end = start + std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>(_o.volume_seconds));
+                auto next = start;
+
+                for (std::size_t i = 0; clock_type::now() < end; i++)
+                {
+                    std::this_thread::sleep_until(next);
+                    next += interval;
+
+                    auto volume = static_cast<float>(i % 101) / 100.0f;
+                    send(phase, bench::payloads::volume_update_message(i % _live, volume));
+                    pump_events(phase);
+                }
+            }
+
+            converge(phase, start);
+            return phase;
+        }
+
+        phase_t remove_all()
+        {
+            phase_t phase{ .name = "delete:" + std::to_string(_live) };
+            auto start = clock_type::now();
+
+            auto batch = _o.batch ? _o.batch : _live;
+            for (std::size_t first = 0; first < _live; first += batch)
+                send(phase, bench::payloads::streams_message(0, std::min(batch, _live - first), first));
+            _live = 0;
+
+            converge(phase, start);
+            return phase;
+        }
+
+        const counters_t& counters() const { return _counters; }
+
+    private:
+        void send(phase_t& phase, const std::vector<uint8_t>& message)
+        {
+            auto r = _link.send(message, _o.ack_timeout, _o.retries);
+
+            phase.messages++;
+            phase.bytes += message.size();
+            phase.retries += r.attempts > 1 ? r.attempts - 1 : 0;
+
+            if (r.acked)
+                phase.latencies_us.emplace_back(r.latency_us);
+            else
+                phase.timeouts++;
+        }
+
+        // Answers what the panel asked for; returns true once it asked for the current probe's icon.
+        bool handle(phase_t& phase, const device_event_t& e)
+        {
+            switch (e.type)
+            {
+                case bridge_message_type_t::get_icon:
+                {
+                    _counters.get_icon++;
+
+                    std::size_t index = 0;
+                    if (std::sscanf(e.source.c_str(), "/usr/lib/application-%zu/", &index) != 1)
+                        return false;
+
+                    if (index == _probe)
+                        return true;
+
+                    if (_o.icons && index < PROBE_INDEX)
+                    {
+                        send(phase, bench::payloads::icon_message(index, _o.icon_size));
+                        _counters.icons_sent++;
+                    }
+                    return false;
+                }
+                case bridge_message_type_t::request_refresh:
+                    _counters.request_refresh++;
+                    if (_live)
+                        send(phase, bench::payloads::streams_message(_live, 0, 0, _o.title_width, _o.title_height));
+                    return false;
+                case bridge_message_type_t::set_volume: _counters.set_volume++; return false;
+                case bridge_message_type_t::set_mute: _counters.set_mute++; return false;
+                case bridge_message_type_t::log_line: _counters.log_lines++; return false;
+                default: return false;
+            }
+        }
+
+        void pump_events(phase_t& phase)
+        {
+            while (auto e = _link.next_event(std::chrono::milliseconds(0)))
+                handle(phase, *e);
+        }
+
+        void converge(phase_t& phase, clock_type::time_point start)
+        {
+            _probe = PROBE_INDEX + _probes++;
+            send(phase, bench::payloads::streams_message(1, 0, _probe, 8, 8));
+
+            auto deadline = clock_type::now() + _o.converge_timeout;
+            while (clock_type::now() < deadline)
+            {
+                auto e = _link.next_event(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock_type::now()));
+                if (e && handle(phase, *e))
+                {
+                    phase.converge_us = since_us(start);
+                    break;
+                }
+            }
+
+            phase.seconds = since_us(start) / 1e6;
+
+            // the probe is not part of the workload, take it out again without counting it
+            phase_t ignored;
+            send(ignored, bench::payloads::streams_message(0, 1, _probe));
+            _probe = 0;
+        }
+
+    private:
+        bridge_link_t& _link;
+        const options_t& _o;
+        std::size_t _live = 0;
+        std::size_t _probe = 0;
+        std::size_t _probes = 0;
+        counters_t _counters;
+    };
+
+    double percentile(std::vector<double>& sorted, double p)
+    {
+        if (sorted.empty())
+            return 0;
+        return sorted[std::min(static_cast<std::size_t>(p * (sorted.size() - 1) + 0.5), sorted.size() - 1)];
+    }
+
+    void print_header()
+    {
+        std::printf("%-16s %6s %10s %9s %9s %9s %9s %8s %8s %12s\n",
+            "phase", "msgs", "KiB", "ack p50", "ack p90", "ack p99", "ack max", "retries", "timeout", "converge ms");
+    }
+
+    void print(phase_t& p)
+    {
+        std::ranges::sort(p.latencies_us);
+        auto& l = p.latencies_us;
+
+        std::printf("%-16s %6zu %10.1f %9.2f %9.2f %9.2f %9.2f %8u %8u ",
+            p.name.c_str(), p.messages, p.bytes / 1024.0, percentile(l, 0.5) / 1000, percentile(l, 0.9) / 1000,
+            percentile(l, 0.99) / 1000, (l.empty() ? 0 : l.back()) / 1000, p.retries, p.timeouts);
+
+        if (p.converge_us) std::printf("%12.1f\n", *p.converge_us / 1000);
+        else std::printf("%12s\n", "no");
+
+        std::fflush(stdout);
+    }
+
+    void usage(const char* name)
+    {
+        std::fprintf(stderr,
+            "usage: %s [options] ENDPOINT\n"
+            "  ENDPOINT               pty | unix:PATH | unix-listen:PATH | SERIAL[@BAUD]\n"
+            "  --streams N            streams created per cycle (10)\n"
+            "  --batch N              streams per message, 0 puts them all in one message like the bridge (0)\n"
+            "  --cycles N             create/volume/delete cycles (1)\n"
+            "  --step N               add N streams every cycle and stop at the first cycle that fails (0)\n"
+            "  --max-streams N        upper bound for --step\n"
+            "  --volume-rate N        volume changes per second (20)\n"
+            "  --volume-seconds N     length of the volume phase (5)\n"
+            "  --title WxH            title sprite size (220x18)\n"
+            "  --icon-size N          icon size sent for get_icon (32)\n"
+            "  --no-icons             do not answer get_icon\n"
+            "  --ack-timeout-ms N     per attempt (5000)\n"
+            "  --retries N            attempts per message (3)\n"
+            "  --converge-timeout-ms N (10000)\n"
+            "  --verbose              enable framer logging\n", name);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    options_t o;
+    esp_log_level_set("*", ESP_LOG_NONE);
+
+    for (auto i = 1; i < argc; i++)
+    {
+        std::string_view arg = argv[i];
+        auto value = [&]{ return i + 1 < argc ? std::string(argv[++i]) : std::string("0"); };
+
+        if (arg == "--streams") o.streams = std::stoul(value());
+        else if (arg == "--batch") o.batch = std::stoul(value());
+        else if (arg == "--cycles") o.cycles = std::max(1, std::stoi(value()));
+        else if (arg == "--step") o.step = std::stoul(value());
+        else if (arg == "--max-streams") o.max_streams = std::stoul(value());
+        else if (arg == "--volume-rate") o.volume_rate = std::stod(value());
+        else if (arg == "--volume-seconds") o.volume_seconds = std::stod(value());
+        else if (arg == "--title")
+        {
+            auto v = value();
+            if (std::sscanf(v.c_str(), "%dx%d", &o.title_width, &o.title_height) != 2)
+            {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "--icon-size") o.icon_size = std::stoi(value());
+        else if (arg == "--no-icons") o.icons = false;
+        else if (arg == "--ack-timeout-ms") o.ack_timeout = std::chrono::milliseconds(std::stoi(value()));
+        else if (arg == "--retries") o.retries = std::max(1, std::stoi(value()));
+        else if (arg == "--converge-timeout-ms") o.converge_timeout = std::chrono::milliseconds(std::stoi(value()));
+        else if (arg == "--verbose") esp_log_level_set("*", ESP_LOG_INFO);
+        else if (!arg.starts_with("--") && o.endpoint.empty()) o.endpoint = arg;
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (o.endpoint.empty())
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (o.step && !o.max_streams)
+        o.max_streams = SIZE_MAX;
+
+    host_io::fd_transport_t link(host_io::open_endpoint(o.endpoint, [](const std::string& where)
+    {
+        std::printf("waiting on %s\n", where.c_str());
+        std::fflush(stdout);
+    }));
+    bridge_link_t bridge(link);
+    workload_t workload(bridge, o);
+
+    print_header();
+
+    auto streams = o.streams;
+    for (auto cycle = 0; o.step ? streams <= o.max_streams : cycle < o.cycles; cycle++, streams += o.step)
+    {
+        auto failed = false;
+        for (auto phase: { workload.create(streams), workload.change_volumes(), workload.remove_all() })
+        {
+            print(phase);
+            failed |= phase.failed();
+        }
+
+        if (failed && o.step)
+        {
+            std::printf("\npanel fell behind at %zu streams\n", streams);
+            break;
+        }
+    }
+
+    const auto& c = workload.counters();
+    std::printf("\nfrom the panel: get_icon %u (answered %u), request_refresh %u, set_volume %u, set_mute %u, log lines %u; %.1f KiB written\n",
+        c.get_icon, c.icons_sent, c.request_refresh, c.set_volume, c.set_mute, c.log_lines, bridge.bytes_sent() / 1024.0);
+
+    return 0;
+}
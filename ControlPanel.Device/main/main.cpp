@@ -4,6 +4,8 @@
 #include <optional>
 #include <mutex>
 #include <string.h>
+#include <tuple>
+#include <utility>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -28,7 +30,10 @@
 #include "utils/lv_sync.hpp"
 #include "utils/lvgl_logging.hpp"
 
+#include "protocol/crc16_bench.hpp"
 #include "protocol/frame_host_connection.hpp"
+#include "protocol/chunk_assembler.hpp"
+#include "protocol/coalescing_outbox.hpp"
 #include "protocol/transport/uart_transport.hpp"
 #include "protocol/transport/bt_uart_transport.hpp"
 #include "protocol/protocol.hpp"
@@ -78,7 +83,14 @@ static std::optional<backlight_timer_t<waveshare_st7789_t>> backlight_timer;
 
 static constexpr std::array<uint8_t, 2> MAGIC{0x19, 0x16};
 static std::optional<transport::bt_uart_transport_t> frame_transport;
-static std::optional<transport::frame_host_connection_t<transport::bt_uart_transport_t, MAGIC>> host_connection;
+static std::optional<transport::frame_host_connection_t<transport::bt_uart_transport_t, MAGIC, CONFIG_CP_RX_FRAME_BUFFER_SIZE, 256, 8, CONFIG_CP_SEND_WINDOW, CONFIG_CP_MAX_MESSAGE_SIZE>> host_connection;
+static transport::chunk_assembler_t<64 * 1024> large_message;
+
+// stream id, agent id and message kind
+using user_change_key_t = std::tuple<std::string, std::string, bridge_message_type_t>;
+static std::optional<transport::coalescing_outbox_t<decltype(host_connection)::value_type, user_change_key_t>> user_changes;
+// source and agent id, a path can be long
+static std::optional<transport::coalescing_outbox_t<decltype(host_connection)::value_type, std::tuple<std::string, std::string>, 384, 32>> icon_requests;
 
 static void nvs_init()
 {
@@ -184,10 +196,16 @@ void host_connection_init(std::optional<TFrameTransport>& ft)
         static_assert(!sizeof(TFrameTransport*), "frame transport is not initialized");
     }
 
+    transport::link_capture_t::init();
     ft->init();
 
     host_connection.emplace(*ft);
+    host_connection->set_ack_delay(CONFIG_CP_ACK_DELAY_MS);
+    // app icons and stream titles, see volume_display_t
+    host_connection->set_app_capabilities(static_cast<uint8_t>(transport::pixel_format_t::rgb565a8) | static_cast<uint8_t>(transport::pixel_format_t::a8), 0);
     host_connection->init();
+    user_changes.emplace(*host_connection);
+    icon_requests.emplace(*host_connection, transport::channel_t::assets);
 
     if constexpr (std::is_same_v<TFrameTransport, transport::uart_transport_t>)
     {
@@ -197,28 +215,68 @@ void host_connection_init(std::optional<TFrameTransport>& ft)
     ESP_LOGI(TAG, "Frame processor initialized");
 }
 
-void host_connection_register_handler()
+// Serialized straight into a tx slot of the connection.
+template<typename T>
+static void send_bridge_message(const T& message, transport::channel_t channel = transport::channel_t::control, uint32_t retry_interval_ms = 1000, uint32_t retry_count = 3)
+{
+    host_connection->send_with([&](std::span<uint8_t> out) { return serialize_bridge_message(message, out); }, retry_interval_ms, retry_count, channel);
+}
+
+// LVGL callbacks run with lv_sync held, waiting there for a slot would freeze the UI while the link is down. A change
+// that did not go out yet is replaced by the next one of the same stream and kind, the bridge only needs the latest.
+template<typename T>
+static void post_user_change(const T& message)
 {
-    host_connection->register_data_handler(+[](std::span<const uint8_t> data)
+    user_changes->post({ message.id.id, message.id.agent_id, message.type }, [&](std::span<uint8_t> out) { return serialize_bridge_message(message, out); });
+}
+
+// Called from volume_display_t::refresh() on the receive task with lv_sync held, a request that finds the assets
+// channel full must not wait for the link there. It waits for flush() instead, and a source asked for again
+// meanwhile is requested once.
+static void post_icon_request(const std::string& source, const std::string& agent_id)
+{
+    get_icon_message_t message{ .source = source, .agent_id = agent_id };
+    if (!icon_requests->post({ source, agent_id }, [&](std::span<uint8_t> out) { return serialize_bridge_message(message, out); }))
+        ESP_LOGW(TAG, "icon not requested source=%s", source.c_str());
+}
+
+// Called on the send task when the link comes up, a refresh that did not go out yet covers the next one.
+static void post_refresh_request()
+{
+    request_refresh_message_t message;
+    user_changes->post({ {}, {}, message.type }, [&](std::span<uint8_t> out) { return serialize_bridge_message(message, out); });
+}
+
+static void on_bridge_message(std::span<const uint8_t> data)
+{
+    backlight_timer->kick();
+
+    auto bmsg = parse_bridge_message(data);
+    if (auto* msg = std::get_if<streams_message_t>(&bmsg))
     {
-        backlight_timer->kick();
+        ESP_LOGD(TAG, "refresh updated=%d deleted=%d", msg->updated.size(), msg->deleted.size());
 
-        auto bmsg = parse_bridge_message(data);
-        if (auto* msg = std::get_if<streams_message_t>(&bmsg))
-        {
-            ESP_LOGD(TAG, "refresh updated=%d deleted=%d", msg->updated.size(), msg->deleted.size());
+        volume_display->refresh(msg->updated, msg->deleted);
+        auto ms = volume_display->size() > 0
+            ? BL_TIMER_LONG
+            : BL_TIMER_SHORT;
+        backlight_timer->set_timeout(ms);
+    }
+    else if (auto* msg = std::get_if<icon_message_t>(&bmsg))
+    {
+        ESP_LOGD(TAG, "icon source=%s agent_id=%s sz=%d", msg->source.c_str(), msg->agent_id.c_str(), msg->icon.size());
+        volume_display->update_icon(msg->source, msg->agent_id, msg->size, msg->size, msg->icon);
+    }
+}
 
-            volume_display->refresh(msg->updated, msg->deleted);
-            auto ms = volume_display->size() > 0
-                ? BL_TIMER_LONG
-                : BL_TIMER_SHORT;
-            backlight_timer->set_timeout(ms);
-        }
-        else if (auto* msg = std::get_if<icon_message_t>(&bmsg))
-        {
-            ESP_LOGD(TAG, "icon source=%s agent_id=%s sz=%d", msg->source.c_str(), msg->agent_id.c_str(), msg->icon.size());
-            volume_display->update_icon(msg->source, msg->agent_id, msg->size, msg->size, msg->icon);
-        }
+void host_connection_register_handler()
+{
+    host_connection->register_data_handler(on_bridge_message);
+
+    // full refreshes with many title sprites are larger than the receive buffer
+    host_connection->register_chunk_handler(+[](const transport::frame_chunk_t& chunk)
+    {
+        large_message.add(chunk, on_bridge_message);
     });
 }
 
@@ -242,6 +300,11 @@ static lv_display_t* st7789_create_lvgl_display()
 extern "C" void app_main(void)
 {
     nvs_init();
+
+#ifdef CONFIG_CP_CRC16_BENCH
+    transport::crc16_bench();
+#endif
+
     host_connection_init(frame_transport);
 
     ESP_LOGI(TAG, "Starting app_main...");
@@ -254,30 +317,47 @@ extern "C" void app_main(void)
     lvgl_timer_init();
 
     volume_display.emplace(0, 0, LV_PCT(100), LV_PCT(100));
+    {
+        // changes and icon requests that found the send queue full go out once it has room again
+        std::scoped_lock lock{lv_sync};
+        lv_timer_create(+[](lv_timer_t*)
+        {
+            user_changes->flush();
+            icon_requests->flush();
+        }, 100, nullptr);
+    }
     volume_display->on_volume_change(+[](const event_id& id, float volume)
     {
-        host_connection->send(serialize_bridge_message(set_volume_message_t {
+        post_user_change(set_volume_message_t {
             .id = { id.id, id.agent_id },
             .volume = volume
-        }));
+        });
     });
     volume_display->on_mute_change(+[](const event_id& id, bool mute)
     {
-        host_connection->send(serialize_bridge_message(set_mute_message_t {
+        post_user_change(set_mute_message_t {
             .id = { id.id, id.agent_id },
             .mute = mute
-        }));
-    });
-    volume_display->on_icon_missing(+[](const std::string& source, const std::string& agent_id)
-    {
-        host_connection->send(serialize_bridge_message(get_icon_message_t {
-            .source = source,
-            .agent_id = agent_id
-        }));
+        });
     });
+    volume_display->on_icon_missing(post_icon_request);
 
     host_connection_register_handler();
-    host_connection->send(serialize_bridge_message(request_refresh_message_t{}), 1000, std::numeric_limits<uint32_t>::max());
+
+    // The streams are asked for at boot, retried until the bridge is there, and again every time the link comes back
+    // after it went down: the bridge may have restarted or Bluetooth dropped. Without a keepalive nothing tells.
+    send_bridge_message(request_refresh_message_t{}, transport::channel_t::control, 1000, std::numeric_limits<uint32_t>::max());
+    if constexpr (CONFIG_CP_KEEPALIVE_INTERVAL_MS > 0)
+    {
+        // the link starts down, its first up is covered by the boot refresh; only called on the send task
+        host_connection->register_link_handler(+[](bool up)
+        {
+            static bool was_up = false;
+            if (up && std::exchange(was_up, true))
+                post_refresh_request();
+        });
+        host_connection->set_keepalive(CONFIG_CP_KEEPALIVE_INTERVAL_MS, CONFIG_CP_KEEPALIVE_MISSES);
+    }
 
     ESP_LOGI(TAG, "Initialization completed");
 }
\ No newline at end of file
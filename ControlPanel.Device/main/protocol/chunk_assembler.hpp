@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdint.h>
+#include <span>
+#include <vector>
+
+#include "esp_log.h"
+
+#include "framer.hpp"
+
+namespace transport
+{
+    // Puts the chunks of a frame too large for the framer buffer back together for consumers that need the whole
+    // payload, like the MsgPack parser. The heap is only used while such a frame arrives, instead of a receive
+    // buffer sized for the largest message being reserved all the time.
+    template<std::size_t MaxSize>
+    class chunk_assembler_t
+    {
+        static constexpr char TAG[] = "CHUNKS";
+
+    public:
+        // Calls on_complete with the payload once the last chunk arrived with a valid crc.
+        template<typename F>
+        void add(const frame_chunk_t& chunk, F&& on_complete)
+        {
+            if (chunk.offset == 0 && chunk.status == chunk_status_t::partial)
+            {
+                if (chunk.size > MaxSize)
+                {
+                    ESP_LOGE(TAG, "frame too large sz=%d max=%d", chunk.size, MaxSize);
+                    return;
+                }
+
+                _data.clear();
+                _data.reserve(chunk.size);
+                _seq = chunk.seq;
+                _active = true;
+            }
+
+            if (!_active)
+                return;
+
+            if (chunk.seq != _seq || chunk.offset != _data.size() || _data.size() + chunk.data.size() > MaxSize)
+            {
+                ESP_LOGE(TAG, "dropping frame seq=%d offset=%d size=%d", chunk.seq, chunk.offset, _data.size());
+                release();
+                return;
+            }
+
+            _data.insert(_data.end(), chunk.data.begin(), chunk.data.end());
+
+            if (chunk.status == chunk_status_t::complete)
+                on_complete(std::span<const uint8_t>(_data));
+
+            if (chunk.status != chunk_status_t::partial)
+                release();
+        }
+
+    private:
+        void release()
+        {
+            std::vector<uint8_t>().swap(_data);
+            _active = false;
+        }
+
+    private:
+        std::vector<uint8_t> _data;
+        uint16_t _seq = 0;
+        bool _active = false;
+    };
+}
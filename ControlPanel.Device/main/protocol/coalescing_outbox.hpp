@@ -0,0 +1,187 @@
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <map>
+#include <mutex>
+#include <span>
+
+#include "esp_log.h"
+
+#include "frame_host_connection.hpp"
+
+namespace transport
+{
+    struct outbox_stats_t
+    {
+        uint32_t posted;
+        uint32_t coalesced;         // replaced a message of the same key that had not gone out yet
+        uint32_t sent;              // went out, acked or not
+        uint32_t dropped;           // too large, or no room for another key
+    };
+
+    // Latest value wins for messages that set state, like the volume of a stream. Each key has at most one message
+    // on the link; what is posted meanwhile replaces the message waiting behind it, so a slider dragged across its
+    // range sends a new value every round trip instead of filling the send queue with stale ones. Messages go out
+    // with full_policy_t::drop and post() never blocks, one that found no free slot waits for flush().
+    template<typename TConnection, typename TKey, std::size_t MaxSize = 192, std::size_t MaxKeys = 16>
+    class coalescing_outbox_t
+    {
+        static constexpr char TAG[] = "OUTBOX";
+
+        struct entry_t
+        {
+            std::array<uint8_t, MaxSize> message;
+            std::size_t size = 0;           // 0 when nothing waits
+            std::array<uint8_t, MaxSize> sent;
+            std::size_t sent_size = 0;
+            bool in_flight = false;
+        };
+
+    public:
+        coalescing_outbox_t(TConnection& connection, channel_t channel = channel_t::control, uint32_t retry_interval_ms = 1000, uint32_t retry_count = 3)
+            : _connection(connection), _channel(channel), _retry_interval_ms(retry_interval_ms), _retry_count(retry_count)
+        {
+        }
+
+        // serialize writes the message into the span it is given and returns its size, as for send_with().
+        template<typename F>
+        requires std::is_invocable_r_v<std::size_t, F, std::span<uint8_t>>
+        bool post(const TKey& key, F&& serialize)
+        {
+            {
+                std::scoped_lock lock{_sync};
+                _stats.posted++;
+
+                auto it = _entries.find(key);
+                if (it == _entries.end())
+                {
+                    if (_entries.size() >= MaxKeys)
+                    {
+                        ESP_LOGW(TAG, "too many keys max=%d", MaxKeys);
+                        _stats.dropped++;
+                        return false;
+                    }
+
+                    it = _entries.try_emplace(key).first;
+                }
+
+                auto& entry = it->second;
+                std::array<uint8_t, MaxSize> message;
+                auto size = serialize(std::span(message));
+                if (size == 0 || size > MaxSize)
+                {
+                    ESP_LOGE(TAG, "message not posted sz=%d max=%d", size, MaxSize);
+                    _stats.dropped++;
+                    erase_idle(it);
+                    return false;
+                }
+
+                if (entry.size > 0)
+                    _stats.coalesced++;
+
+                std::copy_n(message.begin(), size, entry.message.begin());
+                entry.size = size;
+                if (entry.in_flight)
+                    return true;
+            }
+
+            send_next(key);
+            return true;
+        }
+
+        // Sends the messages that found no free slot when they were posted.
+        void flush()
+        {
+            std::array<TKey, MaxKeys> keys;
+            std::size_t count = 0;
+            {
+                std::scoped_lock lock{_sync};
+                for (const auto& [key, entry]: _entries)
+                {
+                    if (!entry.in_flight && entry.size > 0)
+                        keys[count++] = key;
+                }
+            }
+
+            for (std::size_t i = 0; i < count; i++)
+                send_next(keys[i]);
+        }
+
+        outbox_stats_t stats() const
+        {
+            std::scoped_lock lock{_sync};
+            return _stats;
+        }
+
+    private:
+        void send_next(const TKey& key)
+        {
+            std::span<const uint8_t> message;
+            {
+                std::scoped_lock lock{_sync};
+                auto it = _entries.find(key);
+                if (it == _entries.end() || it->second.in_flight || it->second.size == 0)
+                    return;
+
+                // the in-flight copy is only touched again by the callback, std::map does not move its entries
+                auto& entry = it->second;
+                entry.sent = entry.message;
+                entry.sent_size = std::exchange(entry.size, 0);
+                entry.in_flight = true;
+                message = std::span(entry.sent).first(entry.sent_size);
+            }
+
+            // a message dropped for want of a slot reports from within send(), it is put back for flush() then
+            // instead of being sent again right away
+            _connection.send(message, _retry_interval_ms, _retry_count, _channel, full_policy_t::drop, [this, key](send_result_t result)
+            {
+                if (on_done(key, result))
+                    send_next(key);
+            });
+        }
+
+        // Returns true when a newer message waits and can go out now.
+        bool on_done(const TKey& key, send_result_t result)
+        {
+            std::scoped_lock lock{_sync};
+            auto it = _entries.find(key);
+            if (it == _entries.end())
+                return false;
+
+            auto& entry = it->second;
+            entry.in_flight = false;
+            if (result == send_result_t::dropped)
+            {
+                if (entry.size == 0)
+                {
+                    entry.message = entry.sent;
+                    entry.size = entry.sent_size;
+                }
+                return false;
+            }
+
+            _stats.sent++;
+            if (entry.size > 0)
+                return true;
+
+            erase_idle(it);
+            return false;
+        }
+
+        void erase_idle(typename std::map<TKey, entry_t>::iterator it)
+        {
+            if (!it->second.in_flight && it->second.size == 0)
+                _entries.erase(it);
+        }
+
+    private:
+        TConnection& _connection;
+        channel_t _channel;
+        uint32_t _retry_interval_ms;
+        uint32_t _retry_count;
+        std::map<TKey, entry_t> _entries;
+        outbox_stats_t _stats{};
+        mutable std::mutex _sync;
+    };
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <span>
+#include <type_traits>
+#include <variant>
+#include <etl/crc16_ccitt.h>
+
+#include "esp_attr.h"
+#include "esp_rom_crc.h"
+#include "sdkconfig.h"
+
+namespace transport
+{
+    // CRC-16/CCITT-FALSE (poly 0x1021, init 0xffff, no reflection, no final xor), the checksum of every frame.
+    enum class crc16_backend_t
+    {
+        etl,            // etl::crc16_ccitt_t<4>, 16 entry nibble table
+        table,          // 256 entry table, one lookup per byte
+        slicing_by_4,   // 4 x 256 entry tables, four bytes per step
+        rom             // crc16_be from the ESP32 ROM
+    };
+
+#if defined(CONFIG_CP_CRC16_ETL)
+    inline constexpr crc16_backend_t FRAME_CRC16_BACKEND = crc16_backend_t::etl;
+#elif defined(CONFIG_CP_CRC16_SLICING_BY_4)
+    inline constexpr crc16_backend_t FRAME_CRC16_BACKEND = crc16_backend_t::slicing_by_4;
+#elif defined(CONFIG_CP_CRC16_ROM)
+    inline constexpr crc16_backend_t FRAME_CRC16_BACKEND = crc16_backend_t::rom;
+#else
+    inline constexpr crc16_backend_t FRAME_CRC16_BACKEND = crc16_backend_t::table;
+#endif
+
+    namespace details
+    {
+        using crc16_tables_t = std::array<std::array<uint16_t, 256>, 4>;
+
+        // tables[0] is the classic byte table, tables[k] advances a byte through k more zero bytes
+        constexpr crc16_tables_t make_crc16_tables()
+        {
+            crc16_tables_t ret{};
+
+            for (uint32_t b = 0; b < 256; b++)
+            {
+                uint16_t crc = b << 8;
+                for (auto i = 0; i < 8; i++)
+                    crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+                ret[0][b] = crc;
+            }
+
+            for (std::size_t k = 1; k < ret.size(); k++)
+            {
+                for (uint32_t b = 0; b < 256; b++)
+                    ret[k][b] = (ret[k - 1][b] << 8) ^ ret[0][ret[k - 1][b] >> 8];
+            }
+
+            return ret;
+        }
+
+        // DRAM rather than IRAM: IRAM only allows 32 bit loads, the functions using the tables are in IRAM,
+        // so neither depends on the flash cache while the bt stack or a flash write has it busy.
+        // Only the tables of the backends in use are linked, 512 B for table and 2 KB for slicing_by_4.
+        DRAM_ATTR inline constexpr std::array<uint16_t, 256> crc16_table = make_crc16_tables()[0];
+        DRAM_ATTR inline constexpr crc16_tables_t crc16_slicing_tables = make_crc16_tables();
+    }
+
+    // Incremental checksum, bytes can be added in any number of calls as they arrive.
+    template<crc16_backend_t Backend = FRAME_CRC16_BACKEND>
+    class crc16_ccitt_t
+    {
+    public:
+        static constexpr uint16_t INIT = 0xFFFF;
+
+        void add(std::span<const uint8_t> data)
+        {
+            if constexpr (Backend == crc16_backend_t::etl)
+            {
+                _etl.add(data.begin(), data.end());
+            }
+            else
+            {
+                _crc = update(_crc, data.data(), data.size());
+            }
+        }
+
+        uint16_t value() const
+        {
+            if constexpr (Backend == crc16_backend_t::etl)
+                return _etl.value();
+            else
+                return _crc;
+        }
+
+        void reset()
+        {
+            if constexpr (Backend == crc16_backend_t::etl)
+                _etl.reset();
+            else
+                _crc = INIT;
+        }
+
+        static uint16_t compute(std::span<const uint8_t> data)
+        {
+            crc16_ccitt_t crc;
+            crc.add(data);
+            return crc.value();
+        }
+
+    private:
+        static IRAM_ATTR uint16_t update(uint16_t crc, const uint8_t* data, std::size_t size)
+        {
+            const auto& t0 = []() -> const std::array<uint16_t, 256>&
+            {
+                if constexpr (Backend == crc16_backend_t::slicing_by_4)
+                    return details::crc16_slicing_tables[0];
+                else
+                    return details::crc16_table;
+            }();
+
+            if constexpr (Backend == crc16_backend_t::slicing_by_4)
+            {
+                const auto& t = details::crc16_slicing_tables;
+                for (; size >= 4; size -= 4, data += 4)
+                {
+                    crc = t[3][(crc >> 8) ^ data[0]] ^ t[2][(crc & 0xFF) ^ data[1]] ^ t[1][data[2]] ^ t[0][data[3]];
+                }
+            }
+
+            if constexpr (Backend == crc16_backend_t::rom)
+            {
+                // the rom routine inverts the crc on the way in and out
+                return static_cast<uint16_t>(~esp_rom_crc16_be(static_cast<uint16_t>(~crc), data, size));
+            }
+
+            for (; size > 0; size--, data++)
+            {
+                crc = (crc << 8) ^ t0[(crc >> 8) ^ *data];
+            }
+
+            return crc;
+        }
+
+    private:
+        uint16_t _crc = INIT;
+        [[no_unique_address]] std::conditional_t<Backend == crc16_backend_t::etl, etl::crc16_ccitt_t<4>, std::monostate> _etl{};
+    };
+
+    using frame_crc16_t = crc16_ccitt_t<>;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "sdkconfig.h"
+
+#ifdef CONFIG_CP_CRC16_BENCH
+
+#include <stdint.h>
+#include <algorithm>
+#include <inttypes.h>
+#include <limits>
+#include <vector>
+
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "esp_random.h"
+
+#include "crc16.hpp"
+
+namespace transport
+{
+    namespace details
+    {
+        template<crc16_backend_t Backend>
+        void crc16_bench_backend(const char* name, const std::vector<uint8_t>& data)
+        {
+            static constexpr char TAG[] = "CRC16_BENCH";
+
+            for (std::size_t size: { 16, 256, 4096, 12000 })
+            {
+                std::span<const uint8_t> span{data.data(), std::min(size, data.size())};
+                auto best = std::numeric_limits<uint32_t>::max();
+                uint16_t crc = 0;
+
+                for (auto i = 0; i < 32; i++)
+                {
+                    auto start = esp_cpu_get_cycle_count();
+                    crc ^= crc16_ccitt_t<Backend>::compute(span);
+                    best = std::min(best, esp_cpu_get_cycle_count() - start);
+                }
+
+                ESP_LOGI(TAG, "%-12s %5zu B %8" PRIu32 " cycles %6.2f cycles/B (crc %04x)", name, span.size(), best,
+                    static_cast<double>(best) / span.size(), crc);
+            }
+        }
+    }
+
+    // Logs the cost of every crc16 backend on the running chip, to pick CP_CRC16_BACKEND with real numbers.
+    inline void crc16_bench()
+    {
+        std::vector<uint8_t> data(12000);
+        esp_fill_random(data.data(), data.size());
+
+        details::crc16_bench_backend<crc16_backend_t::etl>("etl", data);
+        details::crc16_bench_backend<crc16_backend_t::table>("table", data);
+        details::crc16_bench_backend<crc16_backend_t::slicing_by_4>("slicing_by_4", data);
+        details::crc16_bench_backend<crc16_backend_t::rom>("rom", data);
+    }
+}
+
+#endif
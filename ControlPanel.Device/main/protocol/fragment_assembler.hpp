@@ -0,0 +1,126 @@
+#pragma once
+
+#include <stdint.h>
+#include <span>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+
+#include "framer.hpp"
+#include "frame_buffer.hpp"
+
+namespace transport
+{
+    struct fragment_stats_t
+    {
+        uint32_t reassembled;       // messages put back together and delivered
+        uint32_t dropped;           // fragments of messages that could not be completed
+        uint32_t timeouts;          // messages dropped because their next fragment did not arrive in time
+    };
+
+    // Puts the fragments of messages larger than a frame back together. The fragments of one sender channel arrive
+    // in order, the connection only delivers data frames once, so one message of the channel is assembled at a time
+    // into a static buffer. A message missing a fragment the sender gave up on is dropped when the next message
+    // starts or after TIMEOUT_MS.
+    template<std::size_t MaxSize>
+    class fragment_assembler_t
+    {
+        static constexpr char TAG[] = "FRAGMENTS";
+
+    public:
+        // longer than a fragment the sender retries with the default 3 x 1000 ms
+        static constexpr uint32_t TIMEOUT_MS = 5000;
+
+        // Calls on_complete with the message once its last fragment arrived. payload still starts with the header.
+        template<typename F>
+        void add(const fragment_header_t& header, std::span<const uint8_t> payload, TickType_t now, F&& on_complete)
+        {
+            if (header.index >= header.count)
+            {
+                ESP_LOGW(TAG, "invalid fragment index=%d count=%d", header.index, header.count);
+                _stats.dropped++;
+                return;
+            }
+
+            if (header.index == 0)
+            {
+                if (_active)
+                {
+                    ESP_LOGW(TAG, "message id=%d incomplete, %d of %d fragments", _message_id, _next, _count);
+                    drop();
+                }
+
+                _buffer.clear();
+                _message_id = header.message_id;
+                _count = header.count;
+                _next = 0;
+                _active = true;
+            }
+
+            if (!_active || header.message_id != _message_id || header.index != _next)
+            {
+                ESP_LOGW(TAG, "dropping fragment id=%d index=%d", header.message_id, header.index);
+                _stats.dropped++;
+                if (_active && header.message_id == _message_id)
+                    drop();
+                return;
+            }
+
+            if (!_buffer.try_insert(payload.subspan(fragment_header_t::SIZE)))
+            {
+                ESP_LOGE(TAG, "message id=%d too large max=%d", _message_id, MaxSize);
+                _stats.dropped++;
+                drop();
+                return;
+            }
+
+            _next++;
+            _last_at = now;
+
+            if (_next < _count)
+                return;
+
+            _active = false;
+            _stats.reassembled++;
+            on_complete(std::span<const uint8_t>(_buffer.span()));
+        }
+
+        // Drops a message whose next fragment is overdue, returns the ticks until it is or portMAX_DELAY when
+        // no message is being assembled.
+        TickType_t expire(TickType_t now)
+        {
+            if (!_active)
+                return portMAX_DELAY;
+
+            auto elapsed = now - _last_at;
+            if (elapsed < pdMS_TO_TICKS(TIMEOUT_MS))
+                return pdMS_TO_TICKS(TIMEOUT_MS) - elapsed;
+
+            ESP_LOGW(TAG, "message id=%d timed out, %d of %d fragments", _message_id, _next, _count);
+            _stats.timeouts++;
+            drop();
+            return portMAX_DELAY;
+        }
+
+        fragment_stats_t stats() const
+        {
+            return _stats;
+        }
+
+    private:
+        void drop()
+        {
+            _stats.dropped += _next;
+            _active = false;
+        }
+
+    private:
+        frame_buffer_t<MaxSize> _buffer;
+        uint16_t _message_id = 0;
+        uint8_t _count = 0;
+        uint8_t _next = 0;
+        TickType_t _last_at = 0;
+        bool _active = false;
+        fragment_stats_t _stats{};
+    };
+}
@@ -1,55 +1,45 @@
 #pragma once
 
+#include <stdint.h>
+#include <algorithm>
 #include <array>
+#include <cstring>
 #include <span>
 
 namespace transport
 {
+    // Collects the bytes of a frame that arrives split across several reads, always from the start of the array,
+    // so the frame can be handed out as one contiguous span.
     template<std::size_t Size>
     struct frame_buffer_t
     {
         bool try_insert(std::span<const uint8_t> data)
         {
-            if (data.size() > _buffer.size() - _w_pos)
+            if (data.size() > _buffer.size() - _size)
                 return false;
             
-            std::memcpy(&_buffer[_w_pos], data.data(), data.size());
-            _w_pos += data.size();
+            std::memcpy(&_buffer[_size], data.data(), data.size());
+            _size += data.size();
 
             return true;
         }
 
-        void shift_left_from(std::span<const uint8_t> mark)
+        void clear()
         {
-            auto pos = find_sequence(span(), mark);
-            if (pos == -1)
-            {
-                clear();
-                return;
-            }
-
-            const auto mark_pos = pos + _r_pos;
-            const auto remaining = _w_pos - mark_pos;
-            std::memmove(_buffer.data(), &_buffer[mark_pos], remaining);
-            _r_pos = 0;
-            _w_pos = remaining;
+            _size = 0;
         }
 
-        void seek(std::size_t offset)
+        // Drops the first size bytes, the ones behind them move to the start of the array.
+        void erase_front(std::size_t size)
         {
-            configASSERT(_r_pos + offset <= _w_pos);
-            _r_pos += offset;
-        }
-
-        void clear()
-        {
-            _r_pos = 0;
-            _w_pos = 0;
+            size = std::min(size, _size);
+            std::memmove(_buffer.data(), _buffer.data() + size, _size - size);
+            _size -= size;
         }
 
         std::size_t size() const
         {
-            return _w_pos - _r_pos;
+            return _size;
         }
 
         static constexpr std::size_t capacity()
@@ -57,14 +47,18 @@ namespace transport
             return Size;
         }
 
+        std::span<const uint8_t> span() const
+        {
+            return std::span<const uint8_t>{_buffer.data(), _size};
+        }
+
         std::span<uint8_t> span()
         {
-            return std::span<uint8_t>{_buffer.data() + _r_pos, size()};
+            return std::span<uint8_t>{_buffer.data(), _size};
         }
 
     private:
-        std::size_t _r_pos = 0;
-        std::size_t _w_pos = 0;
+        std::size_t _size = 0;
         std::array<uint8_t, Size> _buffer;
     };
-}
\ No newline at end of file
+}
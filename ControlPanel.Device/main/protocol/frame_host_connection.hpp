@@ -1,8 +1,20 @@
 #pragma once
 
-#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <inttypes.h>
+#include <mutex>
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_timer.h"
+
+#include "utils/esp_utility.hpp"
 #include "framer.hpp"
+#include "fragment_assembler.hpp"
+#include "rtt_estimator.hpp"
+#include "seq_window.hpp"
 #include "transport/frame_transport.hpp"
 
 namespace transport
@@ -14,32 +26,201 @@ namespace transport
 
         template<std::size_t N>
         constexpr bool is_u8_array_v<std::array<uint8_t, N>> = true;
+
+        // A statistics counter bumped from the send task, the receive context and senders alike, or a copy of a value
+        // one of them owns for stats() to read. Nothing is ordered by a counter, relaxed operations are enough to not
+        // lose counts.
+        class counter_t
+        {
+        public:
+            void operator=(uint32_t n)
+            {
+                _value.store(n, std::memory_order_relaxed);
+            }
+
+            void operator++(int)
+            {
+                _value.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            void operator+=(uint32_t n)
+            {
+                _value.fetch_add(n, std::memory_order_relaxed);
+            }
+
+            operator uint32_t() const
+            {
+                return _value.load(std::memory_order_relaxed);
+            }
+
+        private:
+            std::atomic<uint32_t> _value = 0;
+        };
     }
 
-    template<typename TTransport, std::array Magic, std::size_t BufferSize = 16 * 1024, std::size_t MAX_TX_FRAME = 256, std::size_t SEND_QUEUE_SIZE = 8>
+    // Logical channels sharing the link. Each has its own send queue, the send task always takes the next frame from
+    // the first channel in this order that has one. They share the seq space and the window on the wire, so the
+    // current bridge still sees one stream of data frames.
+    enum class channel_t : uint8_t
+    {
+        control = 0,        // user commands and refresh requests, has slots of its own and the last frame of the window
+        assets = 1,         // icon requests
+        diagnostics = 2     // log lines
+    };
+
+    constexpr std::size_t CHANNEL_COUNT = 3;
+
+    // How a message handed to send() or send_with() ended.
+    enum class send_result_t : uint8_t
+    {
+        acked = 0,
+        timed_out = 1,      // given up after retry_count attempts, for a fragmented message any of its fragments
+        dropped = 2         // never sent: no free slot, too large, or fragments for a peer that does not take them
+    };
+
+    // What send() and send_with() do when the channel has no free slot.
+    enum class full_policy_t : uint8_t
+    {
+        wait = 0,           // the caller waits retry_count times retry_interval_ms for one
+        drop = 1            // the message is dropped right away, for callers that must never block like LVGL callbacks
+    };
+
+    // Called once with the result of a message. Runs on the send task when its last frame leaves the window and
+    // must not block there, a message dropped before it was queued reports from within send().
+    using send_callback_t = std::function<void(send_result_t)>;
+
+    // Called with true when the link comes up and false when it goes down. Runs on the send task like a
+    // send_callback_t and must not block there either.
+    using link_callback_t = std::function<void(bool)>;
+
+    struct connection_stats_t
+    {
+        uint32_t tx_frames;         // data frames sent for the first time
+        uint32_t retransmissions;
+        uint32_t acked;
+        uint32_t timed_out;         // data frames given up after retry_count attempts
+        uint32_t queue_full;        // send() calls that could not enqueue, or fragments of them
+        uint32_t rx_frames;         // data frames received with a valid crc
+        uint32_t rx_chunked_frames; // of those, too large for the receive buffer and delivered in chunks
+        uint32_t rx_acks;
+        uint32_t rx_pings;          // answered with a pong
+        uint32_t rx_bulk_frames;
+        uint32_t rx_bulk_bytes;
+        uint32_t tx_bulk_frames;
+        uint32_t rx_crc_errors;
+        uint32_t rx_dropped_bytes;  // received bytes that were not part of a valid frame
+        uint32_t rx_fec_corrected;  // frames repaired by the fec instead of being retransmitted
+        uint32_t rx_fec_uncorrectable;
+        uint32_t rx_out_of_order;   // data frames behind a gap, dropped and left to the sender's retransmission
+        uint32_t rx_duplicates;     // data frames received again after their ack was lost, acked but not delivered
+        uint32_t tx_acks;           // standalone ack frames
+        uint32_t tx_piggybacked_acks; // acks carried on outgoing data frames instead
+        uint32_t tx_window;         // frames that may be in flight, 1 until the peer accepted a window
+        uint32_t tx_fragmented;     // messages larger than a frame sent as fragments
+        uint32_t tx_fragments_dropped; // fragments not sent because the peer did not accept a window
+        uint32_t rx_reassembled;    // messages put back together from fragments
+        uint32_t rx_fragments_dropped; // fragments of messages that could not be completed
+        uint32_t rx_reassembly_timeouts; // of those messages, the ones whose next fragment did not arrive in time
+        uint32_t srtt_us;           // smoothed round trip time of data frames and their acks, 0 before the first sample
+        uint32_t rttvar_us;
+        uint32_t rto_us;            // current retransmission timeout, backed off after timeouts
+        uint32_t rtt_samples;
+        uint32_t rx_overflows;      // times the transport's receive buffer overflowed and lost what it held
+        uint32_t tx_credit;         // bytes the peer can buffer beyond the last frame it read, 0 when it does not say
+        uint32_t tx_credit_stalls;  // times a queued frame had to wait for the frames in flight to leave room
+        uint32_t tx_keepalives;     // pings sent because nothing was received for the keepalive interval
+        uint32_t link_downs;        // times the peer stopped answering them
+        uint32_t peer_version;      // protocol version in the peer's hello, 0 while it did not send one
+    };
+
+    template<typename TTransport, std::array Magic, std::size_t BufferSize = 16 * 1024, std::size_t MAX_TX_FRAME = 256, std::size_t SEND_QUEUE_SIZE = 8, std::size_t SEND_WINDOW = 8, std::size_t MAX_MESSAGE = 2048>
     requires frame_transport_t<TTransport> && details::is_u8_array_v<std::remove_cvref_t<decltype(Magic)>>
     class frame_host_connection_t
     {
-        using connection_framer_t = framer_t<Magic.size(), BufferSize>;
+        using connection_framer_t = framer_t<Magic, BufferSize>;
         
         static constexpr size_t MAX_TX_BODY = MAX_TX_FRAME - connection_framer_t::calc_frame_size(0);
+        static constexpr size_t MAX_PING_BODY = MAX_TX_BODY - bulk_report_t::SIZE;
+        static constexpr size_t MAX_FRAGMENT_DATA = MAX_TX_BODY - fragment_header_t::SIZE;
+
+        // MAX_TX_FRAME limits the body as a magic frame, cobs and fec frames of the same body can be larger
+        static constexpr size_t MAX_TX_WIRE = connection_framer_t::calc_max_frame_size(MAX_TX_BODY);
+        static constexpr size_t MAX_CONTROL_WIRE = connection_framer_t::calc_max_frame_size(std::max(window_request_t::SIZE, 1 + credit_t::SIZE));
+        static constexpr size_t MAX_HELLO_WIRE = connection_framer_t::calc_max_frame_size(hello_t::SIZE);
+
+        static_assert((MAX_MESSAGE + MAX_FRAGMENT_DATA - 1) / MAX_FRAGMENT_DATA <= UINT8_MAX, "a message is at most 255 fragments");
+        static_assert(SEND_WINDOW >= 1 && SEND_WINDOW <= 64, "the receiver tells a restarted peer from a late frame by a seq distance of 64");
+
+        // window requests go out while nothing is in flight, until one is accepted
+        static constexpr uint32_t WINDOW_REQUEST_INTERVAL_MS = 1000;
+        static constexpr uint32_t WINDOW_REQUEST_ATTEMPTS = 3;
+        // hellos go out until the peer answers one, a peer that never does is as old as the current bridge
+        static constexpr uint32_t HELLO_INTERVAL_MS = 1000;
+        static constexpr uint32_t HELLO_ATTEMPTS = 3;
+        // a data frame further than this from the expected seq means the peer started over
+        static constexpr int16_t RESTART_DISTANCE = 64;
+        static constexpr uint32_t FAST_RETRANSMIT_DUP_ACKS = 2;
+        static constexpr std::size_t PIGGYBACK_SIZE = 2;
+        // room left in the receive buffer for frames the credit does not count
+        static constexpr std::size_t RX_CREDIT_MARGIN = 4 * MAX_CONTROL_WIRE;
+        // copies of one frame that may still wait in the peer's buffer, more than the default three sends
+        static constexpr std::size_t MAX_COPY_ENDS = 4;
+
+        // Frames waiting beyond the window, the pool has a slot for each of them and for each frame in flight.
+        static constexpr std::size_t TX_POOL_SIZE = SEND_QUEUE_SIZE + SEND_WINDOW;
+        static_assert(TX_POOL_SIZE <= UINT8_MAX, "slots are passed as uint8_t indices");
+
+        // The first slots of the pool are only taken by the control channel, a burst of log lines or icon requests
+        // cannot make a volume change wait for a free slot.
+        static constexpr std::size_t CONTROL_SLOTS = std::max<std::size_t>(SEND_QUEUE_SIZE / 2, 1);
+
+        struct tx_slot_t
+        {
+            std::array<uint8_t, PIGGYBACK_SIZE + MAX_TX_FRAME> frame;  // [ack room][header][payload][crc]
+            std::size_t size;
+            std::array<uint64_t, MAX_COPY_ENDS> copy_ends;  // _tx_bytes after each copy the peer may not have read
+            uint8_t copies;
+            uint32_t r_interval;
+            uint32_t r_count;
+            frame_type_t type;      // data or fragment
+            uint16_t seq;
+            int64_t first_sent_us;
+            int64_t sent_us;
+            uint32_t attempt;
+            bool retransmitted;     // its ack does not tell which transmission it answers, no rtt sample
+            bool done;              // acked or given up, leaves the window once the frames before it did
+            send_result_t result;   // once done
+            send_callback_t on_done;    // on the last frame of a message
+        };
 
     public:
         static constexpr char TAG[] = "FP";
 
         frame_host_connection_t(TTransport& transport)
             : _transport(transport)
-            , _framer(Magic)
         {
             _transport.on_receive([&](auto d){ on_data(d); });
         }
 
-        void init()
+        // The send task can be left out when the owner drives poll() itself (host link simulator).
+        void init(bool start_send_task = true)
         {
-            _send_queue = xQueueCreate(SEND_QUEUE_SIZE, sizeof(frame_info_t));
-            configASSERT(_send_queue);
-            
-            xTaskCreate(THIS_CALLBACK(this, send_task), "send_task", 4096, this, 10, &_send_task);
+            // all hold slot indices and have room for the whole pool, only the free slots limit send()
+            for (auto& queue: _send_queues)
+            {
+                queue = xQueueCreate(TX_POOL_SIZE, sizeof(uint8_t));
+                configASSERT(queue);
+            }
+
+            _control_slots = xQueueCreate(CONTROL_SLOTS, sizeof(uint8_t));
+            _free_slots = xQueueCreate(TX_POOL_SIZE, sizeof(uint8_t));
+            configASSERT(_control_slots && _free_slots);
+
+            for (uint8_t i = 0; i < TX_POOL_SIZE; i++)
+                release_slot(i);
+
+            if (start_send_task)
+                xTaskCreate(THIS_CALLBACK(this, send_task), "send_task", 4096, this, 10, &_send_task);
         }
 
         template<typename F>
@@ -48,32 +229,389 @@ namespace transport
             _data_handler = std::forward<F>(cb);
         }
 
-        void send(std::span<uint8_t> data, uint32_t retry_interval_ms = 1000, uint32_t retry_count = 3)
+        // Data frames larger than BufferSize go to this handler in chunks, the last one tells whether the crc matched.
+        // Without one they are acked and dropped.
+        template<typename F>
+        void register_chunk_handler(F&& cb)
+        {
+            _chunk_handler = std::forward<F>(cb);
+        }
+
+        // See set_keepalive().
+        template<typename F>
+        void register_link_handler(F&& cb)
+        {
+            _link_handler = std::forward<F>(cb);
+        }
+
+        // Always true without a keepalive, nothing then tells when the peer is gone. So is a link to a peer that is
+        // not pinged, see set_keepalive().
+        bool link_up() const
+        {
+            return _keepalive_interval_us == 0 || !peer_answers_pings() || _link_up;
+        }
+
+        // Frames send() and send_with() take for a message of size bytes, more than 1 when it goes out in fragments.
+        static constexpr std::size_t frame_count(std::size_t size)
+        {
+            return size <= MAX_TX_BODY ? 1 : (size + MAX_FRAGMENT_DATA - 1) / MAX_FRAGMENT_DATA;
+        }
+
+        // Copies data into a pool slot and queues it. Data larger than a frame goes out in fragments, up to MAX_MESSAGE.
+        void send(std::span<const uint8_t> data, uint32_t retry_interval_ms = 1000, uint32_t retry_count = 3, channel_t channel = channel_t::control,
+            full_policy_t when_full = full_policy_t::wait, send_callback_t on_done = {})
         {
-            auto frame_size = _framer.calc_frame_size(data.size());
-            if (frame_size > MAX_TX_FRAME || data.size() > MAX_TX_BODY)
+            if (data.size() > MAX_TX_BODY)
             {
-                ESP_LOGE(TAG, "data too large sz=%d frame_sz=%d max_data=%d max_frame=%d", data.size(), frame_size, MAX_TX_BODY, MAX_TX_FRAME);
+                std::unique_lock lock{_fragment_sync, std::defer_lock};
+                if (!lock_fragments(lock, when_full))
+                    return report(on_done, send_result_t::dropped);
+
+                send_fragments(channel, data, retry_interval_ms, retry_count, when_full, std::move(on_done));
                 return;
             }
-            
-            std::unique_lock lock{_send_sync};
 
-            frame_info_t frame_info {
-                .seq = ++_seq_cnt,
-                .type = frame_type_t::data,
-                .size = data.size(),
-                .r_interval = retry_interval_ms,
-                .r_count = retry_count
-            };
-            std::memcpy(frame_info.data, data.data(), data.size());
+            send_with([&](std::span<uint8_t> buffer)
+            {
+                std::ranges::copy(data, buffer.begin());
+                return data.size();
+            }, retry_interval_ms, retry_count, channel, when_full, std::move(on_done));
+        }
+
+        // Lets serialize write the payload straight into a pool slot, the frame header and crc are written around it
+        // when it goes out. serialize returns the payload size, 0 drops the message. A size larger than the span it
+        // was given asks for a larger one: it is called again with room for MAX_MESSAGE and the message goes out in
+        // fragments. With full_policy_t::wait it waits retry_count times retry_interval_ms for a free slot, with
+        // full_policy_t::drop it never blocks.
+        // A frame that is not acked is resent whenever the retransmission timeout measured on the link runs out. It is
+        // given up once it was sent retry_count times and retry_interval_ms * retry_count passed since the first time.
+        // on_done gets the result of the whole message.
+        template<typename F>
+        requires std::is_invocable_r_v<std::size_t, F, std::span<uint8_t>>
+        void send_with(F&& serialize, uint32_t retry_interval_ms = 1000, uint32_t retry_count = 3, channel_t channel = channel_t::control,
+            full_policy_t when_full = full_policy_t::wait, send_callback_t on_done = {})
+        {
+            auto index = acquire_slot(channel, retry_interval_ms, retry_count, when_full);
+            if (!index)
+                return report(on_done, send_result_t::dropped);
 
-            do
+            auto& slot = _tx_pool[*index];
+            auto size = serialize(slot_data(slot));
+            if (size == 0 || size > MAX_TX_BODY)
             {
-                if (xQueueSend(_send_queue, &frame_info, pdMS_TO_TICKS(retry_interval_ms)))
-                    break;
-                
-            } while (--frame_info.r_count > 0);
+                release_slot(*index);
+                if (size == 0)
+                    return report(on_done, send_result_t::dropped);
+
+                std::unique_lock lock{_fragment_sync, std::defer_lock};
+                if (!lock_fragments(lock, when_full))
+                    return report(on_done, send_result_t::dropped);
+
+                size = serialize(std::span(_fragment_buffer));
+                if (size == 0 || size > MAX_MESSAGE)
+                {
+                    if (size > 0)
+                        ESP_LOGE(TAG, "data too large sz=%d max_message=%d max_frame=%d", size, MAX_MESSAGE, MAX_TX_FRAME);
+                    return report(on_done, send_result_t::dropped);
+                }
+
+                send_fragments(channel, std::span(_fragment_buffer).first(size), retry_interval_ms, retry_count, when_full, std::move(on_done));
+                return;
+            }
+
+            queue_slot(*index, channel, frame_type_t::data, size, retry_interval_ms, retry_count, std::move(on_done));
+        }
+
+        // Runs the sender until it has to wait and returns the ticks until it has to run again.
+        // Up to the negotiated window of queued frames are in flight at once, as many as fit in the peer's credit,
+        // each with its own retransmit timer, taken from the channels in priority order. The timers run for the
+        // retransmission timeout estimated from the round trips of earlier frames.
+        // Peers that do not answer the window request get one frame at a time, acked frame by frame.
+        // Bulk frames requested by the other side fill the time spent waiting.
+        TickType_t poll()
+        {
+            while (true)
+            {
+                auto now = xTaskGetTickCount();
+                auto now_us = esp_timer_get_time();
+                auto wait = portMAX_DELAY;
+
+                if (auto due = flush_delayed_ack(now); due != portMAX_DELAY)
+                    wait = due;
+
+                wait = std::min(wait, expire_reassembly(now));
+                wait = std::min(wait, keepalive(now_us));
+
+                update_read_through();
+                retire_acked(now_us);
+
+                if (fast_retransmit_due())
+                {
+                    // the same ack repeated for frames behind a gap, resend what is in flight without waiting for the timers
+                    for (std::size_t i = 0; i < _in_flight; i++)
+                    {
+                        auto& slot = window_slot(i);
+                        if (slot.done)
+                            continue;
+
+                        if (max_wire_size(slot) > credit_left())
+                            break;
+
+                        retransmit(slot);
+                    }
+                }
+
+                bool gave_up = false;
+                bool resynced = false;
+                bool oldest = true;
+                for (std::size_t i = 0; i < _in_flight; i++)
+                {
+                    auto& slot = window_slot(i);
+                    if (slot.done)
+                        continue;
+
+                    // the receiver drops everything behind a lost frame, only the oldest one uses up its attempts
+                    auto charged = std::exchange(oldest, false);
+
+                    auto rto = _rtt.rto_us();
+                    auto elapsed = now_us - slot.sent_us;
+                    if (elapsed < rto)
+                    {
+                        wait = std::min(wait, us_to_ticks(rto - elapsed));
+                        continue;
+                    }
+
+                    // A timer that ran out because the peer is slow to read, not because the frame was lost, must not
+                    // add a copy its full buffer has no room for. When none of what is in flight arrives the peer
+                    // tells nothing about reading it, so the oldest frame also goes once the peer stopped acking
+                    // for a timeout: by then it read whatever it got.
+                    if (max_wire_size(slot) > credit_left())
+                    {
+                        auto quiet = now_us - last_ack_at_us();
+                        if (!charged)
+                            continue;
+
+                        if (quiet < rto)
+                        {
+                            wait = std::min(wait, us_to_ticks(rto - quiet));
+                            continue;
+                        }
+
+                        _peer_read_through = _tx_bytes;
+                    }
+
+                    if (charged)
+                        _rtt.back_off();
+
+                    auto lifetime = static_cast<int64_t>(slot.r_interval) * slot.r_count * 1000;
+                    if (!charged || ++slot.attempt < slot.r_count || now_us - slot.first_sent_us < lifetime)
+                    {
+                        // a lost resync leaves the receiver waiting for a frame that was given up, repeat it first
+                        if (!resynced && peer_behind())
+                            request_window(true);
+                        resynced = true;
+
+                        retransmit(slot);
+                        wait = std::min(wait, us_to_ticks(_rtt.rto_us()));
+                        continue;
+                    }
+
+                    ESP_LOGW(TAG, "frame seq=%d not acked after %d attempts", slot.seq, slot.attempt);
+                    _stats.timed_out++;
+                    slot.done = true;
+                    slot.result = send_result_t::timed_out;
+                    gave_up = true;
+
+                    // the receiver drops the rest of the message, it fails with its last fragment
+                    if (auto header = fragment_header(slot); header && header->channel < CHANNEL_COUNT)
+                        _failed_message[header->channel] = header->message_id;
+                }
+
+                if (gave_up)
+                {
+                    retire_acked(now_us);
+                    if (peer_behind())
+                        request_window(true);
+                    continue;
+                }
+
+                if (hello_due(now))
+                {
+                    send_hello(0);
+                    _hello_sent_at = now;
+                    _hellos_sent++;
+                }
+
+                if (_in_flight == 0 && window_request_due(now))
+                {
+                    request_window(false);
+                    _window_requested_at = now;
+                    _window_requests++;
+                }
+
+                if (auto index = _in_flight < tx_window() ? next_queued(credit_left()) : std::nullopt)
+                {
+                    // numbered as they go out, a frame that never made it into the queue leaves no gap for the receiver
+                    _window[(_window_head + _in_flight) % SEND_WINDOW] = *index;
+                    auto& slot = window_slot(_in_flight++);
+                    slot.seq = ++_seq_cnt;
+                    slot.first_sent_us = now_us;
+                    slot.attempt = 0;
+                    slot.retransmitted = false;
+                    slot.done = false;
+                    _stats.tx_frames++;
+
+                    transmit(slot);
+                    continue;
+                }
+
+                if (transmit_bulk())
+                    continue;
+
+                if (hello_pending())
+                    wait = std::min(wait, pdMS_TO_TICKS(HELLO_INTERVAL_MS) - std::min(now - _hello_sent_at, pdMS_TO_TICKS(HELLO_INTERVAL_MS)));
+
+                // with frames in flight the next ack wakes the task anyway
+                if (_in_flight == 0 && _window_requests > 0 && window_request_pending())
+                    wait = std::min(wait, pdMS_TO_TICKS(WINDOW_REQUEST_INTERVAL_MS) - std::min(now - _window_requested_at, pdMS_TO_TICKS(WINDOW_REQUEST_INTERVAL_MS)));
+
+                publish_rtt();
+                return wait;
+            }
+        }
+
+        // Frames waiting in the send queues, not counting the ones in flight.
+        std::size_t pending() const
+        {
+            std::size_t ret = 0;
+            for (auto queue: _send_queues)
+                ret += uxQueueMessagesWaiting(queue);
+            return ret;
+        }
+
+        std::size_t pending(channel_t channel) const
+        {
+            return uxQueueMessagesWaiting(_send_queues[static_cast<std::size_t>(channel)]);
+        }
+
+        // Slots send() on the channel can take without waiting (host link simulator).
+        std::size_t free_slots(channel_t channel) const
+        {
+            auto ret = uxQueueMessagesWaiting(_free_slots);
+            return channel == channel_t::control ? ret + uxQueueMessagesWaiting(_control_slots) : ret;
+        }
+
+        connection_stats_t stats() const
+        {
+            connection_stats_t ret{};
+            ret.tx_frames = _stats.tx_frames;
+            ret.retransmissions = _stats.retransmissions;
+            ret.acked = _stats.acked;
+            ret.timed_out = _stats.timed_out;
+            ret.queue_full = _stats.queue_full;
+            ret.rx_frames = _stats.rx_frames;
+            ret.rx_chunked_frames = _stats.rx_chunked_frames;
+            ret.rx_acks = _stats.rx_acks;
+            ret.rx_pings = _stats.rx_pings;
+            ret.rx_bulk_frames = _stats.rx_bulk_frames;
+            ret.rx_bulk_bytes = _stats.rx_bulk_bytes;
+            ret.tx_bulk_frames = _stats.tx_bulk_frames;
+            ret.rx_out_of_order = _stats.rx_out_of_order;
+            ret.rx_duplicates = _stats.rx_duplicates;
+            ret.tx_acks = _stats.tx_acks;
+            ret.tx_piggybacked_acks = _stats.tx_piggybacked_acks;
+            ret.tx_fragmented = _stats.tx_fragmented;
+            ret.tx_fragments_dropped = _stats.tx_fragments_dropped;
+            ret.rx_fragments_dropped = _stats.rx_fragments_dropped;
+            ret.tx_credit_stalls = _stats.tx_credit_stalls;
+            ret.tx_keepalives = _stats.tx_keepalives;
+            ret.link_downs = _stats.link_downs;
+            ret.rx_crc_errors = _stats.rx_crc_errors;
+            ret.rx_dropped_bytes = _stats.rx_dropped_bytes;
+            ret.rx_fec_corrected = _stats.rx_fec_corrected;
+            ret.rx_fec_uncorrectable = _stats.rx_fec_uncorrectable;
+            ret.tx_window = tx_window();
+            {
+                std::scoped_lock lock{_hello_sync};
+                ret.peer_version = _peer_hello ? _peer_hello->version : 0;
+            }
+            ret.srtt_us = _stats.srtt_us;
+            ret.rttvar_us = _stats.rttvar_us;
+            ret.rto_us = _stats.rto_us;
+            ret.rtt_samples = _stats.rtt_samples;
+            if constexpr (rx_buffered_transport_t<TTransport>)
+                ret.rx_overflows = _transport.rx_overflows();
+
+            {
+                std::unique_lock lock{_ack_sync};
+                ret.tx_credit = _tx_credit.value_or(0);
+            }
+
+            std::unique_lock lock{_reassembly_sync};
+            for (const auto& reassembly: _reassembly)
+            {
+                auto fragments = reassembly.stats();
+                ret.rx_reassembled += fragments.reassembled;
+                ret.rx_fragments_dropped += fragments.dropped;
+                ret.rx_reassembly_timeouts += fragments.timeouts;
+            }
+            return ret;
+        }
+
+        // Switches the framing of this end only, the other end has to do the same (host link simulator).
+        // Normally the host asks for it with a framing frame.
+        void set_framing(framing_t framing)
+        {
+            std::scoped_lock lock{_tx_sync};
+            _framer.set_framing(framing);
+        }
+
+        // How long an in-order data frame may wait for its ack once the peer accepted cumulative acks. The ack goes
+        // out on the next data frame sent, after a quarter of the peer's window, or when the delay is up, whichever is first.
+        // 0 acks every frame right away.
+        void set_ack_delay(uint32_t ms)
+        {
+            _ack_delay_ms = ms;
+        }
+
+        // Pings the peer after interval_ms without a frame from it, any frame it sends counts as an answer. The link
+        // goes down after miss_count pings in a row went unanswered, and comes up again with the next frame that
+        // arrives, pings keep going out every interval_ms meanwhile. The link starts down and comes up once the peer
+        // is heard from. 0 turns the keepalive off, the default. Can be called once the send task runs, after
+        // register_link_handler().
+        // Only a peer whose hello lists link_feature_t::ping is pinged. A bridge older than the hello would log
+        // every ping as an unknown frame and let the link go down whenever it is idle.
+        void set_keepalive(uint32_t interval_ms, uint32_t miss_count)
+        {
+            _keepalive_miss_count = std::max<uint32_t>(miss_count, 1);
+            _keepalive_interval_us = static_cast<int64_t>(interval_ms) * 1000;
+            wake_send_task();
+        }
+
+        // Image formats (pixel_format_t bits) and payload encodings (compression_t bits) the application takes, sent
+        // in the hello along with what the connection supports. Set before init().
+        void set_app_capabilities(uint8_t pixel_formats, uint8_t compressions)
+        {
+            _pixel_formats = pixel_formats;
+            _compressions = compressions;
+        }
+
+        // What this end and the peer agreed on, once the peer answered a hello. A peer that does not know hellos
+        // is left with stop-and-wait until it accepts a window, and with messages of one frame unless it does.
+        // The peer's largest frame also bounds the headers this end's framer takes from it.
+        std::optional<link_settings_t> settings() const
+        {
+            std::scoped_lock lock{_hello_sync};
+            if (!_peer_hello)
+                return {};
+
+            return link_settings_t::negotiate(local_hello(0), *_peer_hello);
+        }
+
+        // Largest window this end asks for and accepts, at most SEND_WINDOW (host link simulator).
+        void set_max_window(std::size_t window)
+        {
+            _max_window = std::clamp<std::size_t>(window, 1, SEND_WINDOW);
         }
 
     private:
@@ -81,92 +619,1186 @@ namespace transport
         {
             _framer.feed(data, [&](const frame_t& frame)
             {
+                heard_from_peer();
+
                 switch (frame.type)
                 {
                     case frame_type_t::ack:
                         {
                             std::unique_lock lock{_ack_sync};
+                            _dup_acks = frame.seq == _last_ack ? _dup_acks + 1 : 0;
                             _last_ack = frame.seq;
-                            _new_ack.notify_all();
+                            _last_ack_at_us = esp_timer_get_time();
+                            if (auto credit = credit_t::from_bytes(frame.data))
+                            {
+                                _tx_credit = credit->bytes;
+                                _peer_read_seq = credit->read_seq;
+                            }
+                            _stats.rx_acks++;
                         }
+                        wake_send_task();
+                        break;
+                    case frame_type_t::data_ack:
+                        if (frame.data.size() < PIGGYBACK_SIZE)
+                            break;
+                        on_piggybacked_ack(static_cast<uint16_t>(frame.data[0] << 8 | frame.data[1]));
+                        on_data_frame(frame.seq, frame.data.subspan(PIGGYBACK_SIZE));
                         break;
                     case frame_type_t::data:
-                        frame_t ack_frame{frame.seq, frame_type_t::ack, {}};
-                        send_bytes(to_bytes(_ack_buffer, ack_frame));
+                        on_data_frame(frame.seq, frame.data);
+                        break;
+                    case frame_type_t::fragment:
+                        on_fragment(frame.seq, frame.data);
+                        break;
+                    case frame_type_t::ping:
+                        on_ping(frame);
+                        break;
+                    case frame_type_t::pong:
+                        // only keepalives are sent from here, heard_from_peer() is all there is to do
+                        break;
+                    case frame_type_t::bulk:
+                        _stats.rx_bulk_frames++;
+                        _stats.rx_bulk_bytes += frame.data.size();
+                        break;
+                    case frame_type_t::bulk_request:
+                        on_bulk_request(frame);
+                        break;
+                    case frame_type_t::framing:
+                        on_framing(frame);
+                        break;
+                    case frame_type_t::window:
+                        on_window_request(frame);
+                        break;
+                    case frame_type_t::window_ack:
+                        on_window_ack(frame);
+                        break;
+                    case frame_type_t::hello:
+                        on_hello(frame);
+                        break;
+                    default:
+                        ESP_LOGW(TAG, "unexpected frame type=%d seq=%d", static_cast<int>(frame.type), frame.seq);
+                        break;
+                }
+            },
+            [&](const frame_chunk_t& chunk)
+            {
+                heard_from_peer();
 
-                        if (_data_handler) _data_handler(frame.data);
-                        
+                switch (chunk.type)
+                {
+                    case frame_type_t::data:
+                        // the seq is only checked once the crc is, earlier chunks may belong to a frame that is dropped
+                        if (chunk.status == chunk_status_t::complete)
+                        {
+                            auto accepted = accept_data(chunk.seq);
+                            if (accepted)
+                            {
+                                _stats.rx_frames++;
+                                _stats.rx_chunked_frames++;
+                            }
+                            if (_chunk_handler) _chunk_handler(accepted ? chunk : frame_chunk_t{ chunk.seq, chunk.type, chunk.offset, chunk.size, {}, chunk_status_t::failed });
+                        }
+                        else if (_chunk_handler)
+                        {
+                            _chunk_handler(chunk);
+                        }
+                        break;
+                    case frame_type_t::bulk:
+                        // the last chunk's offset is the payload size
+                        if (chunk.status == chunk_status_t::complete)
+                        {
+                            _stats.rx_bulk_frames++;
+                            _stats.rx_bulk_bytes += chunk.offset;
+                        }
+                        break;
+                    default:
+                        if (chunk.status != chunk_status_t::partial)
+                            ESP_LOGW(TAG, "unexpected chunked frame type=%d seq=%d", static_cast<int>(chunk.type), chunk.seq);
                         break;
                 }
             });
+
+            auto framer = _framer.stats();
+            _stats.rx_crc_errors = framer.crc_errors;
+            _stats.rx_dropped_bytes = framer.dropped_bytes;
+            _stats.rx_fec_corrected = framer.fec_corrected;
+            _stats.rx_fec_uncorrectable = framer.fec_uncorrectable;
         }
 
-        void send_task()
+        void on_data_frame(uint16_t seq, std::span<const uint8_t> data)
         {
-            frame_info_t frame_info;
-            while (true)
-            {
-                if (!xQueueReceive(_send_queue, &frame_info, portMAX_DELAY))
-                    continue;
-                
-                frame_t frame{frame_info.seq, frame_info.type, std::span<uint8_t>(frame_info.data, frame_info.size)};
+            if (!accept_data(seq))
+                return;
 
-                std::array<uint8_t, MAX_TX_FRAME> buffer;
-                auto frame_bytes = to_bytes(buffer, frame);
+            _stats.rx_frames++;
+            if (_data_handler) _data_handler(data);
+        }
 
-                for (auto i = 0; i < frame_info.r_count; i++)
-                {
-                    send_bytes(frame_bytes);
+        // Fragments are acked like data frames, the message goes to the data handler once its last one arrived.
+        void on_fragment(uint16_t seq, std::span<const uint8_t> data)
+        {
+            if (!accept_data(seq))
+                return;
 
-                    std::unique_lock lock{_ack_sync};
-                    auto success = _new_ack.wait_for(lock, std::chrono::milliseconds(frame_info.r_interval), [&]
-                    {
-                        return _last_ack == frame.seq;
-                    });
+            _stats.rx_frames++;
 
-                    if (success)
-                        break;
-                }
+            auto header = fragment_header_t::from_bytes(data);
+            if (!header || header->channel >= CHANNEL_COUNT)
+            {
+                ESP_LOGW(TAG, "invalid fragment sz=%d", data.size());
+                _stats.rx_fragments_dropped++;
+                return;
+            }
+
+            std::optional<std::span<const uint8_t>> message;
+            {
+                std::unique_lock lock{_reassembly_sync};
+                _reassembly[header->channel].add(*header, data, xTaskGetTickCount(), [&](std::span<const uint8_t> completed)
+                {
+                    message = completed;
+                });
             }
+
+            // the handler may send, and so wait for the send task, which takes the lock to expire messages. Only add()
+            // writes the assembler's buffer and it runs in this receive context alone, so the message stays valid.
+            if (message && _data_handler) _data_handler(*message);
         }
 
-        std::span<uint8_t> to_bytes(std::span<uint8_t> buffer, const frame_t& frame)
+        TickType_t expire_reassembly(TickType_t now)
         {
-            auto sz = _framer.to_bytes(buffer, frame);
-            return buffer.subspan(0, sz);
+            std::unique_lock lock{_reassembly_sync};
+            auto wait = portMAX_DELAY;
+            for (auto& reassembly: _reassembly)
+                wait = std::min(wait, reassembly.expire(now));
+            return wait;
         }
 
-        void send_bytes(std::span<uint8_t> bytes)
+        // A piggybacked ack only moves forward, unlike a standalone one it is not a hint that a frame was lost.
+        void on_piggybacked_ack(uint16_t seq)
         {
-            std::scoped_lock lock{_tx_sync};
-            _transport.write(bytes);
+            {
+                std::unique_lock lock{_ack_sync};
+                if (static_cast<int16_t>(seq - _last_ack) <= 0)
+                    return;
+
+                _last_ack = seq;
+                _last_ack_at_us = esp_timer_get_time();
+                _dup_acks = 0;
+            }
+            wake_send_task();
         }
 
-    private:
-        struct frame_info_t
+        // Acks a received data frame and returns whether it is the next one to deliver. Once the peer asked for
+        // a window, frames are only taken in order and the ack covers everything up to the last one taken.
+        bool accept_data(uint16_t seq)
         {
-            uint16_t seq;
-            frame_type_t type;
-            uint8_t data[MAX_TX_BODY];
-            uint32_t size;
-            uint32_t r_interval;
-            uint32_t r_count;
-        };
+            std::unique_lock lock{_rx_sync};
+            _rx_last_read = seq;
 
-        TTransport& _transport;
-        connection_framer_t _framer;
+            if (!_rx_cumulative)
+            {
+                send_ack(seq);
+                if (_rx_seen.mark(seq))
+                    return true;
 
-        std::function<void(std::span<const uint8_t>)> _data_handler;
+                _stats.rx_duplicates++;
+                return false;
+            }
 
-        TaskHandle_t _send_task;
-        QueueHandle_t _send_queue;
-        std::mutex _send_sync;
-        std::mutex _tx_sync;
+            auto distance = static_cast<int16_t>(seq - _rx_expected);
+            if (distance > RESTART_DISTANCE || distance < -RESTART_DISTANCE)
+            {
+                // the peer started over without a window request, it is not going to understand cumulative acks
+                ESP_LOGW(TAG, "peer restarted seq=%d expected=%d, back to one frame at a time", seq, _rx_expected);
+                _rx_cumulative = false;
+                _rx_unacked = 0;
+                _rx_seen.reset();
+                _rx_seen.mark(seq);
+                reset_tx_window();
+                send_ack(seq);
+                return true;
+            }
 
-        std::array<uint8_t, connection_framer_t::calc_frame_size(0) * 2> _ack_buffer;
-        uint16_t _last_ack = 0;
-        std::condition_variable _new_ack;
-        std::mutex _ack_sync;
-        uint16_t _seq_cnt = 0;
+            if (distance != 0)
+            {
+                // gaps and duplicates are acked right away, the repeated ack is what makes the sender resend early
+                if (distance > 0)
+                    _stats.rx_out_of_order++;
+                else
+                    _stats.rx_duplicates++;
+
+                send_ack(_rx_expected - 1);
+                return false;
+            }
+
+            _rx_expected++;
+            if (_ack_delay_ms == 0 || ++_rx_unacked >= std::max<std::size_t>(_rx_window / 4, 1))
+            {
+                send_ack(_rx_expected - 1);
+                return true;
+            }
+
+            if (_rx_unacked == 1)
+            {
+                _ack_due = xTaskGetTickCount() + pdMS_TO_TICKS(_ack_delay_ms);
+                wake_send_task();
+            }
+
+            return true;
+        }
+
+        // Sends the delayed ack once it is due, returns the ticks until it is or portMAX_DELAY when none is pending.
+        TickType_t flush_delayed_ack(TickType_t now)
+        {
+            std::unique_lock lock{_rx_sync};
+            if (_rx_unacked == 0)
+                return portMAX_DELAY;
+
+            if (auto left = static_cast<int32_t>(_ack_due - now); left > 0)
+                return left;
+
+            send_ack(_rx_expected - 1);
+            return portMAX_DELAY;
+        }
+
+        // Takes the pending delayed ack to carry it on a data frame.
+        std::optional<uint16_t> take_delayed_ack()
+        {
+            std::unique_lock lock{_rx_sync};
+            if (_rx_unacked == 0)
+                return {};
+
+            _rx_unacked = 0;
+            _stats.tx_piggybacked_acks++;
+            return static_cast<uint16_t>(_rx_expected - 1);
+        }
+
+        // covers every delayed frame, called with _rx_sync held once the receiver is cumulative
+        void send_ack(uint16_t seq)
+        {
+            _rx_unacked = 0;
+            _stats.tx_acks++;
+
+            std::array<uint8_t, credit_t::SIZE> credit;
+            send_frame(frame_t{seq, frame_type_t::ack, rx_credit(credit)});
+        }
+
+        // Frames are acked as they are read out of the transport's buffer, in the order they arrived. What the
+        // sender wrote after the last frame read is on the wire or still in the buffer, so the whole buffer is the
+        // credit, less a margin for the acks and window frames that share it. A reader that is slow to handle
+        // frames reads the next ones later and acks them later, which holds the sender back. Only a peer that
+        // asked for a window knows what to do with it. Called with _rx_sync held.
+        std::span<const uint8_t> rx_credit(std::span<uint8_t, credit_t::SIZE> buffer)
+        {
+            if constexpr (rx_buffered_transport_t<TTransport>)
+            {
+                auto size = _transport.rx_buffer_size();
+                if (!_rx_cumulative || size == 0)
+                    return {};
+
+                auto bytes = size > RX_CREDIT_MARGIN ? size - RX_CREDIT_MARGIN : 0;
+                credit_t{ static_cast<uint16_t>(std::min<std::size_t>(bytes, UINT16_MAX)), _rx_last_read }.to_bytes(buffer);
+                return buffer;
+            }
+            else
+            {
+                return {};
+            }
+        }
+
+        void on_window_request(const frame_t& frame)
+        {
+            auto request = window_request_t::from_bytes(frame.data);
+            if (!request)
+                return;
+
+            // left unanswered, the peer then sends one frame at a time as to a peer that does not know windows
+            if (_max_window == 1)
+                return;
+
+            std::unique_lock lock{_rx_sync};
+
+            // a request behind the expected seq is a late resync, unless it is far enough back to be a restarted peer
+            auto distance = static_cast<int16_t>(request->next_seq - _rx_expected);
+            if (!_rx_cumulative || distance > 0 || distance < -RESTART_DISTANCE)
+            {
+                ESP_LOGI(TAG, "peer window=%d next_seq=%d", request->size, request->next_seq);
+                _rx_cumulative = true;
+                _rx_expected = request->next_seq;
+                _rx_unacked = 0;
+            }
+            _rx_window = std::min<std::size_t>(request->size, _max_window);
+
+            // the credit covers the first window, before any frame of it is acked
+            std::array<uint8_t, 1 + credit_t::SIZE> accepted{ static_cast<uint8_t>(_max_window) };
+            auto credit = rx_credit(std::span(accepted).template subspan<1>());
+            send_frame(frame_t{frame.seq, frame_type_t::window_ack, std::span(accepted).first(1 + credit.size())});
+        }
+
+        void on_window_ack(const frame_t& frame)
+        {
+            if (frame.data.empty() || frame.data[0] == 0)
+                return;
+
+            {
+                std::unique_lock lock{_ack_sync};
+                if (_window_acked)
+                    return;
+
+                _window_acked = true;
+                _tx_window = std::min<std::size_t>(frame.data[0], _max_window);
+                if (auto credit = credit_t::from_bytes(frame.data.subspan(1)))
+                    _tx_credit = credit->bytes;
+                _last_ack_at_us = esp_timer_get_time();
+            }
+
+            ESP_LOGI(TAG, "window %d accepted", tx_window());
+            wake_send_task();
+        }
+
+        // A hello that is not an answer itself gets this end's, also when the peer sends it again after a restart.
+        void on_hello(const frame_t& frame)
+        {
+            auto hello = hello_t::from_bytes(frame.data);
+            if (!hello || hello->version == 0)
+            {
+                ESP_LOGW(TAG, "bad hello sz=%d", frame.data.size());
+                return;
+            }
+
+            {
+                std::scoped_lock lock{_hello_sync};
+                _peer_hello = *hello;
+                _hello_exchanged = true;
+            }
+
+            // a bit flip in a len then costs that frame only, not the ones behind it until the bogus body is filled
+            _framer.set_max_len(hello->max_frame);
+
+            auto agreed = link_settings_t::negotiate(local_hello(0), *hello);
+            ESP_LOGI(TAG, "peer v%d frame=%d window=%d message=%d features=%04x", hello->version, hello->max_frame,
+                agreed.window, agreed.max_message, agreed.features);
+
+            if (!(hello->flags & hello_t::REPLY))
+                send_hello(hello_t::REPLY);
+
+            wake_send_task();
+        }
+
+        hello_t local_hello(uint8_t flags) const
+        {
+            uint16_t features = static_cast<uint16_t>(link_feature_t::chunked) | static_cast<uint16_t>(link_feature_t::window)
+                | static_cast<uint16_t>(link_feature_t::fragments) | static_cast<uint16_t>(link_feature_t::ping);
+            std::size_t rx_buffer = 0;
+            if constexpr (rx_buffered_transport_t<TTransport>)
+            {
+                features |= static_cast<uint16_t>(link_feature_t::credit);
+                rx_buffer = _transport.rx_buffer_size();
+            }
+
+            return hello_t{
+                .version = hello_t::VERSION,
+                .flags = flags,
+                .max_frame = static_cast<uint16_t>(MAX_TX_BODY),
+                .rx_frame_buffer = static_cast<uint16_t>(std::min<std::size_t>(BufferSize - connection_framer_t::calc_max_frame_size(0), UINT16_MAX)),
+                .rx_buffer = static_cast<uint16_t>(std::min<std::size_t>(rx_buffer, UINT16_MAX)),
+                .window = static_cast<uint8_t>(_max_window),
+                .max_message = static_cast<uint16_t>(MAX_MESSAGE),
+                .framings = static_cast<uint8_t>(framing_mask(framing_t::magic) | framing_mask(framing_t::cobs) | framing_mask(framing_t::magic_fec)),
+                .compressions = _compressions,
+                .pixel_formats = _pixel_formats,
+                .features = features
+            };
+        }
+
+        void send_hello(uint8_t flags)
+        {
+            std::array<uint8_t, hello_t::SIZE> payload;
+            local_hello(flags).to_bytes(payload);
+            send_frame(frame_t{0, frame_type_t::hello, payload});
+        }
+
+        // Until the peer answered, or HELLO_INTERVAL_MS after the last of the hellos went unanswered.
+        bool hello_pending() const
+        {
+            std::scoped_lock lock{_hello_sync};
+            if (_hello_exchanged)
+                return false;
+
+            return _hellos_sent < HELLO_ATTEMPTS || xTaskGetTickCount() - _hello_sent_at < pdMS_TO_TICKS(HELLO_INTERVAL_MS);
+        }
+
+        bool hello_due(TickType_t now) const
+        {
+            return hello_pending() && _hellos_sent < HELLO_ATTEMPTS && (_hellos_sent == 0 || now - _hello_sent_at >= pdMS_TO_TICKS(HELLO_INTERVAL_MS));
+        }
+
+        // A peer that did not answer the hellos may still answer the window request. One whose hello gives a window
+        // of 1 would leave it unanswered, like this end does.
+        bool peer_takes_window() const
+        {
+            std::scoped_lock lock{_hello_sync};
+            return !_peer_hello || (_peer_hello->supports(link_feature_t::window) && _peer_hello->window > 1);
+        }
+
+        // A peer that accepted a window knows fragments as well, one asked for no window only tells in its hello.
+        bool peer_takes_fragments() const
+        {
+            if (tx_window_acked())
+                return true;
+
+            std::scoped_lock lock{_hello_sync};
+            return _peer_hello && _peer_hello->supports(link_feature_t::fragments);
+        }
+
+        bool peer_answers_pings() const
+        {
+            std::scoped_lock lock{_hello_sync};
+            return _peer_hello && _peer_hello->supports(link_feature_t::ping);
+        }
+
+        // Largest message the peer puts back together from fragments, MAX_MESSAGE until its hello tells.
+        std::size_t peer_max_message() const
+        {
+            std::scoped_lock lock{_hello_sync};
+            return _peer_hello && _peer_hello->supports(link_feature_t::fragments) ? std::min<std::size_t>(_peer_hello->max_message, MAX_MESSAGE) : MAX_MESSAGE;
+        }
+
+        void on_ping(const frame_t& frame)
+        {
+            if (frame.data.size() > MAX_PING_BODY)
+            {
+                ESP_LOGW(TAG, "ping too large sz=%d max=%d", frame.data.size(), MAX_PING_BODY);
+                return;
+            }
+
+            std::memcpy(_pong_body.data(), frame.data.data(), frame.data.size());
+            bulk_report_t{ _stats.rx_bulk_frames, _stats.rx_bulk_bytes }
+                .to_bytes(std::span(_pong_body).subspan(frame.data.size()).template first<bulk_report_t::SIZE>());
+
+            _stats.rx_pings++;
+
+            frame_t pong_frame{frame.seq, frame_type_t::pong, std::span(_pong_body).subspan(0, frame.data.size() + bulk_report_t::SIZE)};
+            send_frame(pong_frame);
+        }
+
+        void on_bulk_request(const frame_t& frame)
+        {
+            auto request = bulk_request_t::from_bytes(frame.data);
+            if (!request)
+                return;
+
+            ESP_LOGI(TAG, "bulk request bytes=%d frame_size=%d", request->bytes, request->frame_size);
+
+            {
+                std::unique_lock lock{_bulk_sync};
+                _bulk_remaining = request->bytes;
+                _bulk_frame_size = std::clamp<std::size_t>(request->frame_size, 1, MAX_TX_BODY);
+            }
+            wake_send_task();
+        }
+
+        void on_framing(const frame_t& frame)
+        {
+            if (frame.data.size() != 1 || frame.data[0] > static_cast<uint8_t>(framing_t::magic_fec))
+            {
+                ESP_LOGW(TAG, "unsupported framing request sz=%d", frame.data.size());
+                return;
+            }
+
+            // the echo still goes out in the old framing, everything written after it in the new one
+            std::scoped_lock lock{_tx_sync};
+            _transport.write(to_bytes(_control_buffer, frame_t{frame.seq, frame_type_t::framing, frame.data}));
+            _framer.set_framing(static_cast<framing_t>(frame.data[0]));
+        }
+
+        // Sends the next frame of a requested bulk transfer, returns false when there is nothing left to send.
+        bool transmit_bulk()
+        {
+            std::size_t size;
+            {
+                std::unique_lock lock{_bulk_sync};
+                if (!_bulk_remaining)
+                    return false;
+
+                size = std::min<std::size_t>(_bulk_frame_size, _bulk_remaining);
+                _bulk_remaining -= size;
+            }
+
+            for (std::size_t i = 0; i < size; i++)
+                _bulk_body[i] = static_cast<uint8_t>(_bulk_seq + i);
+
+            frame_t frame{++_bulk_seq, frame_type_t::bulk, std::span(_bulk_body).subspan(0, size)};
+            send_frame(frame);
+            _stats.tx_bulk_frames++;
+
+            return true;
+        }
+
+        void heard_from_peer()
+        {
+            _last_rx_us = esp_timer_get_time();
+            if (!_link_up && _keepalive_interval_us)
+                wake_send_task();
+        }
+
+        // Sends a ping once nothing was received for an interval, since the last frame or the last ping, and counts
+        // the pings nothing came back for. Returns the ticks until the next one is due.
+        TickType_t keepalive(int64_t now_us)
+        {
+            int64_t interval_us = _keepalive_interval_us;
+            if (interval_us == 0 || !peer_answers_pings())
+                return portMAX_DELAY;
+
+            int64_t heard_us = _last_rx_us;
+            if (heard_us > _keepalive_sent_us)
+            {
+                _keepalive_misses = 0;
+                set_link_up(true);
+            }
+
+            auto quiet_us = now_us - std::max(heard_us, _keepalive_sent_us);
+            if (quiet_us < interval_us)
+                return us_to_ticks(interval_us - quiet_us);
+
+            if (_keepalive_sent_us > heard_us && ++_keepalive_misses >= _keepalive_miss_count)
+                set_link_up(false);
+
+            _keepalive_sent_us = now_us;
+            _stats.tx_keepalives++;
+            send_frame(frame_t{++_keepalive_seq, frame_type_t::ping, {}});
+
+            return us_to_ticks(interval_us);
+        }
+
+        void set_link_up(bool up)
+        {
+            if (_link_up == up)
+                return;
+
+            _link_up = up;
+            if (up)
+            {
+                // the timeouts backed off while nothing came through, what is in flight goes again right away
+                ESP_LOGI(TAG, "link up");
+                _rtt.reset_backoff();
+
+                // the peer may have been replaced meanwhile by one that supports more or less, its answer tells
+                if (_stats.link_downs > 0)
+                {
+                    std::scoped_lock lock{_hello_sync};
+                    _hello_exchanged = false;
+                    _hellos_sent = 0;
+                }
+            }
+            else
+            {
+                ESP_LOGW(TAG, "link down, %" PRIu32 " keepalives unanswered", _keepalive_misses);
+                _stats.link_downs++;
+            }
+
+            if (_link_handler)
+                _link_handler(up);
+        }
+
+        void send_task()
+        {
+            while (true)
+            {
+                ulTaskNotifyTake(pdTRUE, poll());
+            }
+        }
+
+        void wake_send_task()
+        {
+            if (_send_task) xTaskNotifyGive(_send_task);
+        }
+
+        // With a window acks are cumulative, without one the peer acks each frame with its own seq.
+        bool acked(uint16_t seq)
+        {
+            std::unique_lock lock{_ack_sync};
+            return _window_acked ? static_cast<int16_t>(_last_ack - seq) >= 0 : _last_ack == seq;
+        }
+
+        // Frames leave the window in order, acked or given up. The newest frame acked gives the rtt sample, unless
+        // it was retransmitted. The ack of the frames before it may have been delayed to cover it.
+        void retire_acked(int64_t now_us)
+        {
+            bool progress = false;
+            std::optional<int64_t> sample;
+            while (_in_flight > 0)
+            {
+                auto& slot = window_slot(0);
+                if (!slot.done && acked(slot.seq))
+                {
+                    _stats.acked++;
+                    slot.done = true;
+                    slot.result = send_result_t::acked;
+                    progress = true;
+
+                    // a resent frame that was acked leaves open which of its copies arrived (Karn's rule), it must not
+                    // drop the sample of a frame before it that was sent once
+                    if (!slot.retransmitted)
+                    {
+                        _peer_read_through = std::max(_peer_read_through, slot.copy_ends[0]);
+                        sample = now_us - slot.sent_us;
+                    }
+                }
+
+                if (!slot.done)
+                    break;
+
+                auto result = message_result(slot);
+                auto on_done = std::exchange(slot.on_done, nullptr);
+                release_slot(_window[_window_head]);
+                _window_head = (_window_head + 1) % SEND_WINDOW;
+                _in_flight--;
+                report(on_done, result);
+            }
+
+            // the backoff ends with the first ack that moves the window, a sample or not
+            if (sample)
+                _rtt.add_sample(*sample);
+            if (progress)
+                _rtt.reset_backoff();
+        }
+
+        // The estimator belongs to the send task, stats() reads what it was when the task last went to wait.
+        void publish_rtt()
+        {
+            _stats.srtt_us = static_cast<uint32_t>(_rtt.srtt_us());
+            _stats.rttvar_us = static_cast<uint32_t>(_rtt.rttvar_us());
+            _stats.rto_us = static_cast<uint32_t>(_rtt.rto_us());
+            _stats.rtt_samples = _rtt.samples();
+        }
+
+        // Rounded up, a retransmission must not go out before its timeout even with ticks of 10 ms.
+        static TickType_t us_to_ticks(int64_t us)
+        {
+            return static_cast<TickType_t>((us * configTICK_RATE_HZ + 999'999) / 1'000'000);
+        }
+
+        tx_slot_t& window_slot(std::size_t i)
+        {
+            return _tx_pool[_window[(_window_head + i) % SEND_WINDOW]];
+        }
+
+        // The payload sits behind room for a header and a piggybacked ack, so either can be written in front of it.
+        static std::span<uint8_t> slot_data(tx_slot_t& slot)
+        {
+            return std::span(slot.frame).subspan(PIGGYBACK_SIZE + connection_framer_t::DATA_OFFSET, MAX_TX_BODY);
+        }
+
+        void release_slot(uint8_t index)
+        {
+            xQueueSend(index < CONTROL_SLOTS ? _control_slots : _free_slots, &index, 0);
+        }
+
+        // Control traffic takes its own slots first, then shared ones, and waits for its own ones to come back.
+        std::optional<uint8_t> acquire_slot(channel_t channel, uint32_t retry_interval_ms, uint32_t retry_count, full_policy_t when_full)
+        {
+            uint8_t index;
+            auto control = channel == channel_t::control;
+            if (control && (xQueueReceive(_control_slots, &index, 0) || xQueueReceive(_free_slots, &index, 0)))
+                return index;
+
+            auto wait = when_full == full_policy_t::wait;
+            for (uint32_t attempt = 0; !xQueueReceive(control ? _control_slots : _free_slots, &index, wait ? pdMS_TO_TICKS(retry_interval_ms) : 0); )
+            {
+                if (!wait || ++attempt >= retry_count)
+                {
+                    _stats.queue_full++;
+                    return {};
+                }
+            }
+
+            return index;
+        }
+
+        void queue_slot(uint8_t index, channel_t channel, frame_type_t type, std::size_t size, uint32_t retry_interval_ms, uint32_t retry_count,
+            send_callback_t on_done = {})
+        {
+            auto& slot = _tx_pool[index];
+            slot.type = type;
+            slot.size = size;
+            slot.r_interval = retry_interval_ms;
+            slot.r_count = retry_count;
+            slot.on_done = std::move(on_done);
+
+            xQueueSend(_send_queues[static_cast<std::size_t>(channel)], &index, 0);
+            wake_send_task();
+        }
+
+        // Takes the next slot to send from the highest priority channel that has one. With a window of more than one
+        // frame, the last free place in it is kept for control traffic. A frame larger than the credit left holds
+        // back the channels behind it too, until acks make room.
+        std::optional<uint8_t> next_queued(std::size_t credit)
+        {
+            auto window = tx_window();
+            for (std::size_t channel = 0; channel < CHANNEL_COUNT; channel++)
+            {
+                if (channel != static_cast<std::size_t>(channel_t::control) && window > 1 && _in_flight + 1 >= window)
+                    return {};
+
+                bool stalled = false;
+                if (auto index = next_queued(_send_queues[channel], credit, stalled))
+                {
+                    _credit_stalled = false;
+                    return index;
+                }
+
+                if (stalled)
+                {
+                    if (!std::exchange(_credit_stalled, true))
+                        _stats.tx_credit_stalls++;
+                    return {};
+                }
+            }
+
+            return {};
+        }
+
+        // Fragments wait at the head of their queue for the answer to the window request or the hello, a peer that
+        // gives neither does not know fragment frames either and they are dropped.
+        std::optional<uint8_t> next_queued(QueueHandle_t queue, std::size_t credit, bool& stalled)
+        {
+            uint8_t index;
+            while (xQueuePeek(queue, &index, 0))
+            {
+                if (_tx_pool[index].type != frame_type_t::fragment || peer_takes_fragments())
+                {
+                    if (max_wire_size(_tx_pool[index]) > credit)
+                    {
+                        stalled = true;
+                        return {};
+                    }
+
+                    xQueueReceive(queue, &index, 0);
+                    return index;
+                }
+
+                if (window_request_pending() || hello_pending())
+                    return {};
+
+                ESP_LOGW(TAG, "peer does not take fragments, dropping sz=%d", _tx_pool[index].size);
+                xQueueReceive(queue, &index, 0);
+                auto on_done = std::exchange(_tx_pool[index].on_done, nullptr);
+                release_slot(index);
+                _stats.tx_fragments_dropped++;
+                report(on_done, send_result_t::dropped);
+            }
+
+            return {};
+        }
+
+        // Queues data as fragment frames, called with _fragment_sync held so the fragments of two messages are not
+        // mixed up. Fragments that find no free slot are not sent, the receiver drops what it got of the message.
+        // A caller that must not wait only starts when there is a slot for every fragment.
+        void send_fragments(channel_t channel, std::span<const uint8_t> data, uint32_t retry_interval_ms, uint32_t retry_count,
+            full_policy_t when_full, send_callback_t on_done)
+        {
+            // the peer's assembler would drop the message after all of its fragments went over the link
+            if (auto max_message = peer_max_message(); data.size() > max_message)
+            {
+                ESP_LOGE(TAG, "data too large sz=%d max_message=%d max_frame=%d", data.size(), max_message, MAX_TX_FRAME);
+                return report(on_done, send_result_t::dropped);
+            }
+
+            auto count = static_cast<uint8_t>(frame_count(data.size()));
+            if (when_full == full_policy_t::drop && free_slots(channel) < count)
+            {
+                _stats.queue_full++;
+                return report(on_done, send_result_t::dropped);
+            }
+
+            auto message_id = ++_fragment_message_id;
+            for (uint8_t i = 0; i < count; i++)
+            {
+                auto index = acquire_slot(channel, retry_interval_ms, retry_count, when_full);
+                if (!index)
+                    return report(on_done, send_result_t::dropped);
+
+                auto part = data.subspan(i * MAX_FRAGMENT_DATA).first(std::min(MAX_FRAGMENT_DATA, data.size() - i * MAX_FRAGMENT_DATA));
+                auto payload = slot_data(_tx_pool[*index]);
+                fragment_header_t{ static_cast<uint8_t>(channel), message_id, i, count }.to_bytes(payload.template first<fragment_header_t::SIZE>());
+                std::ranges::copy(part, payload.begin() + fragment_header_t::SIZE);
+
+                queue_slot(*index, channel, frame_type_t::fragment, fragment_header_t::SIZE + part.size(), retry_interval_ms, retry_count,
+                    i + 1 == count ? std::move(on_done) : send_callback_t{});
+            }
+
+            _stats.tx_fragmented++;
+        }
+
+        // Another message may hold it while it waits for slots for its fragments.
+        bool lock_fragments(std::unique_lock<std::mutex>& lock, full_policy_t when_full)
+        {
+            if (when_full == full_policy_t::wait)
+            {
+                lock.lock();
+                return true;
+            }
+
+            if (lock.try_lock())
+                return true;
+
+            _stats.queue_full++;
+            return false;
+        }
+
+        std::optional<fragment_header_t> fragment_header(tx_slot_t& slot)
+        {
+            if (slot.type != frame_type_t::fragment)
+                return {};
+
+            return fragment_header_t::from_bytes(slot_data(slot).first(slot.size));
+        }
+
+        // A message whose fragments were acked still failed when the receiver dropped it for one that was given up.
+        send_result_t message_result(tx_slot_t& slot)
+        {
+            if (slot.result != send_result_t::acked)
+                return slot.result;
+
+            auto header = fragment_header(slot);
+            if (header && header->channel < CHANNEL_COUNT && _failed_message[header->channel] == header->message_id)
+                return send_result_t::timed_out;
+
+            return send_result_t::acked;
+        }
+
+        static void report(const send_callback_t& on_done, send_result_t result)
+        {
+            if (on_done)
+                on_done(result);
+        }
+
+        // The peer read everything written up to the frame it last read. It reads in the order things were written
+        // and never goes back, so of a frame sent more than once it read the first copy that ends past what it is
+        // known to have read. Where that is not known for sure the earlier copy is taken, the sender may wait longer
+        // than needed but never overruns the buffer.
+        void update_read_through()
+        {
+            std::optional<uint16_t> seq;
+            {
+                std::unique_lock lock{_ack_sync};
+                seq = std::exchange(_peer_read_seq, std::nullopt);
+            }
+
+            for (std::size_t i = 0; seq && i < _in_flight; i++)
+            {
+                auto& slot = window_slot(i);
+                if (slot.seq != *seq)
+                    continue;
+
+                auto end = std::find_if(slot.copy_ends.begin(), slot.copy_ends.begin() + slot.copies,
+                    [this](uint64_t end) { return end > _peer_read_through; });
+                if (end != slot.copy_ends.begin() + slot.copies)
+                    _peer_read_through = *end;
+            }
+        }
+
+        // Bytes the next frame may take on the wire: the peer's credit less the bytes written after the last frame
+        // it read, retransmissions included. With nothing in flight a frame always goes out, the peer has read
+        // everything it was sent before.
+        std::size_t credit_left()
+        {
+            std::unique_lock lock{_ack_sync};
+            if (!_tx_credit || _in_flight == 0)
+                return SIZE_MAX;
+
+            auto used = _tx_bytes - _peer_read_through;
+            return *_tx_credit > used ? *_tx_credit - used : 0;
+        }
+
+        // Sized for any framing and a piggybacked ack, the bytes a frame takes are only known once it is written.
+        static std::size_t max_wire_size(const tx_slot_t& slot)
+        {
+            return connection_framer_t::calc_max_frame_size(slot.size + PIGGYBACK_SIZE);
+        }
+
+        int64_t last_ack_at_us() const
+        {
+            std::unique_lock lock{_ack_sync};
+            return _last_ack_at_us;
+        }
+
+        std::size_t tx_window() const
+        {
+            std::unique_lock lock{_ack_sync};
+            return _tx_window;
+        }
+
+        // Called from the receive context when the peer started over, the send task asks it for a window again.
+        void reset_tx_window()
+        {
+            {
+                std::unique_lock lock{_ack_sync};
+                _window_acked = false;
+                _tx_window = 1;
+                _tx_credit.reset();
+            }
+
+            _window_requests = 0;
+            wake_send_task();
+        }
+
+        // Oldest seq still to be delivered, the frames before it are acked or given up.
+        uint16_t window_base()
+        {
+            for (std::size_t i = 0; i < _in_flight; i++)
+            {
+                if (!window_slot(i).done)
+                    return window_slot(i).seq;
+            }
+
+            return _seq_cnt + 1;
+        }
+
+        // The peer acks the last frame it took in order, below the window base it is waiting for a frame that was given up.
+        bool peer_behind()
+        {
+            if (!tx_window_acked())
+                return false;
+
+            std::unique_lock lock{_ack_sync};
+            return static_cast<int16_t>(_last_ack - (window_base() - 1)) < 0;
+        }
+
+        // Once per window base, the receiver repeats its last ack for every frame it drops behind a gap.
+        bool fast_retransmit_due()
+        {
+            if (_in_flight == 0)
+                return false;
+
+            auto base = window_base();
+            std::unique_lock lock{_ack_sync};
+            if (!_window_acked || _dup_acks < FAST_RETRANSMIT_DUP_ACKS || static_cast<uint16_t>(_last_ack + 1) != base || _fast_retransmit_seq == base)
+                return false;
+
+            _fast_retransmit_seq = base;
+            return true;
+        }
+
+        bool tx_window_acked() const
+        {
+            std::unique_lock lock{_ack_sync};
+            return _window_acked;
+        }
+
+        // Not asked for with a window of 1: cumulative acks only pay off with frames in flight, and without them a
+        // given up frame holds back everything behind it until a resync gets through. Such an end stays with
+        // frame by frame acks, the hello tells it whether the peer takes fragments.
+        // Nor before the hello exchange is over, a bridge that does not know windows tells so in its answer.
+        bool window_request_pending() const
+        {
+            return _max_window > 1 && !tx_window_acked() && _window_requests < WINDOW_REQUEST_ATTEMPTS && !hello_pending() && peer_takes_window();
+        }
+
+        bool window_request_due(TickType_t now) const
+        {
+            return window_request_pending() && (_window_requests == 0 || now - _window_requested_at >= pdMS_TO_TICKS(WINDOW_REQUEST_INTERVAL_MS));
+        }
+
+        // Sent while nothing is in flight, so the receiver expects exactly the next frame to go out. A resync moves
+        // the receiver past frames that were given up, to the oldest one still in flight.
+        void request_window(bool resync)
+        {
+            auto base = window_base();
+            ESP_LOGD(TAG, "%s window=%d next_seq=%d", resync ? "resync" : "request", _max_window, base);
+
+            std::array<uint8_t, window_request_t::SIZE> payload;
+            window_request_t{ static_cast<uint8_t>(_max_window), base }.to_bytes(payload);
+            send_frame(frame_t{base, frame_type_t::window, payload});
+        }
+
+        void retransmit(tx_slot_t& slot)
+        {
+            _stats.retransmissions++;
+            slot.retransmitted = true;
+            transmit(slot);
+        }
+
+        // Frames the slot on every attempt, a retransmission after a framing switch has to use the new framing.
+        // A delayed ack for the peer rides along on data frames that have room for it: the header then starts at
+        // the front of the slot and the ack takes the place of its last bytes.
+        void transmit(tx_slot_t& slot)
+        {
+            slot.sent_us = esp_timer_get_time();
+
+            std::span<uint8_t> frame(slot.frame);
+            if (slot.type == frame_type_t::data && slot.size + PIGGYBACK_SIZE <= MAX_TX_BODY)
+            {
+                if (auto ack = take_delayed_ack())
+                {
+                    frame[connection_framer_t::DATA_OFFSET] = *ack >> 8;
+                    frame[connection_framer_t::DATA_OFFSET + 1] = *ack & 0xff;
+                    written(slot, send_in_place(frame, slot.size + PIGGYBACK_SIZE, slot.seq, frame_type_t::data_ack));
+                    return;
+                }
+            }
+
+            written(slot, send_in_place(frame.subspan(PIGGYBACK_SIZE), slot.size, slot.seq, slot.type));
+        }
+
+        void written(tx_slot_t& slot, std::size_t bytes)
+        {
+            _tx_bytes += bytes;
+            if (!slot.retransmitted)
+                slot.copies = 0;
+
+            // copies the peer has read are done with, when there are still too many the latest replaces the last
+            auto read = std::remove_if(slot.copy_ends.begin(), slot.copy_ends.begin() + slot.copies,
+                [this](uint64_t end) { return end <= _peer_read_through; });
+            slot.copies = std::min<std::size_t>(read - slot.copy_ends.begin(), MAX_COPY_ENDS - 1);
+            slot.copy_ends[slot.copies++] = _tx_bytes;
+        }
+
+        std::size_t send_in_place(std::span<uint8_t> frame, std::size_t data_size, uint16_t seq, frame_type_t type)
+        {
+            std::scoped_lock lock{_tx_sync};
+            auto bytes = _framer.to_bytes_in_place(frame, data_size, seq, type, _tx_buffer);
+            _transport.write(bytes);
+            return bytes.size();
+        }
+
+        std::span<uint8_t> to_bytes(std::span<uint8_t> buffer, const frame_t& frame)
+        {
+            auto sz = _framer.to_bytes(buffer, frame);
+            return buffer.subspan(0, sz);
+        }
+
+        // Frames are only written under _tx_sync, so one buffer serves every control frame. Pongs and bulk frames
+        // can be as large as a data frame and take the one cobs and fec data frames are written to.
+        void send_frame(const frame_t& frame)
+        {
+            std::scoped_lock lock{_tx_sync};
+            std::span<uint8_t> buffer = _control_buffer;
+            if (connection_framer_t::calc_max_frame_size(frame.data.size()) > buffer.size())
+                buffer = _tx_buffer;
+
+            _transport.write(to_bytes(buffer, frame));
+        }
+
+    private:
+        TTransport& _transport;
+        connection_framer_t _framer;
+
+        std::function<void(std::span<const uint8_t>)> _data_handler;
+        std::function<void(const frame_chunk_t&)> _chunk_handler;
+        link_callback_t _link_handler;
+
+        TaskHandle_t _send_task = nullptr;
+        std::array<QueueHandle_t, CHANNEL_COUNT> _send_queues{};
+        QueueHandle_t _control_slots = nullptr;
+        QueueHandle_t _free_slots = nullptr;
+        std::mutex _tx_sync;
+
+        std::array<tx_slot_t, TX_POOL_SIZE> _tx_pool{};
+        std::array<uint8_t, SEND_WINDOW> _window{};
+        std::size_t _window_head = 0;
+        std::size_t _in_flight = 0;
+        // written under _tx_sync only: cobs and fec data frames, pongs and bulk frames, magic data frames go out of
+        // their slot. The rest are acks, hellos and the other control frames.
+        std::array<uint8_t, MAX_TX_WIRE> _tx_buffer;
+        std::array<uint8_t, std::max(MAX_CONTROL_WIRE, MAX_HELLO_WIRE)> _control_buffer;
+
+        std::array<uint8_t, MAX_MESSAGE> _fragment_buffer;  // send_with() messages larger than a slot
+        uint16_t _fragment_message_id = 0;
+        std::mutex _fragment_sync;
+
+        std::array<fragment_assembler_t<MAX_MESSAGE>, CHANNEL_COUNT> _reassembly;
+        mutable std::mutex _reassembly_sync;
+
+        std::size_t _max_window = SEND_WINDOW;
+        std::size_t _tx_window = 1;
+        bool _window_acked = false;
+        std::atomic<uint32_t> _window_requests = 0;     // counted by the send task, reset by a restarted peer's frame
+        TickType_t _window_requested_at = 0;
+
+        bool _rx_cumulative = false;
+        seq_window_t _rx_seen;
+        uint16_t _rx_expected = 0;
+        std::size_t _rx_window = 1;
+        std::size_t _rx_unacked = 0;    // frames taken in order whose ack is delayed
+        uint16_t _rx_last_read = 0;     // data frame read last, in order or not
+        TickType_t _ack_due = 0;
+        uint32_t _ack_delay_ms = 5;
+        std::mutex _rx_sync;
+
+        uint16_t _last_ack = 0;
+        uint32_t _dup_acks = 0;
+        uint16_t _fast_retransmit_seq = 0;
+        std::optional<std::size_t> _tx_credit;  // from the peer's last ack that carried one
+        std::optional<uint16_t> _peer_read_seq; // from the same ack, not looked at yet
+        int64_t _last_ack_at_us = 0;
+        uint64_t _tx_bytes = 0;                 // data frames written, every copy, owned by the send task
+        uint64_t _peer_read_through = 0;        // of those, the ones the peer has read
+        bool _credit_stalled = false;           // owned by the send task
+        mutable std::mutex _ack_sync;
+        uint16_t _seq_cnt = 0;      // owned by the send task
+        std::array<std::optional<uint16_t>, CHANNEL_COUNT> _failed_message{};    // last fragmented message given up, owned by the send task
+        rtt_estimator_t _rtt;       // owned by the send task
+
+        std::atomic<int64_t> _keepalive_interval_us = 0;
+        std::atomic<uint32_t> _keepalive_miss_count = 3;
+        std::atomic<int64_t> _last_rx_us = 0;   // any valid frame, set by the receive context
+        int64_t _keepalive_sent_us = 0;         // owned by the send task, as is the rest of the keepalive state
+        uint32_t _keepalive_misses = 0;
+        uint16_t _keepalive_seq = 0;
+        std::atomic<bool> _link_up = false;
+
+        std::optional<hello_t> _peer_hello;     // the last one, kept while a new exchange is under way
+        bool _hello_exchanged = false;          // the peer sent a hello since this end last started one
+        uint32_t _hellos_sent = 0;              // owned by the send task
+        TickType_t _hello_sent_at = 0;
+        uint8_t _pixel_formats = 0;
+        uint8_t _compressions = 0;
+        mutable std::mutex _hello_sync;
+
+        std::array<uint8_t, MAX_TX_BODY> _pong_body;
+
+        std::array<uint8_t, MAX_TX_BODY> _bulk_body;
+        uint32_t _bulk_remaining = 0;
+        std::size_t _bulk_frame_size = 0;
+        uint16_t _bulk_seq = 0;
+        std::mutex _bulk_sync;
+
+        // the counted part of connection_stats_t and copies of what the send task and the receive context own, the
+        // rest is read from where it is kept under its lock when stats() is called
+        struct
+        {
+            details::counter_t tx_frames;
+            details::counter_t retransmissions;
+            details::counter_t acked;
+            details::counter_t timed_out;
+            details::counter_t queue_full;
+            details::counter_t rx_frames;
+            details::counter_t rx_chunked_frames;
+            details::counter_t rx_acks;
+            details::counter_t rx_pings;
+            details::counter_t rx_bulk_frames;
+            details::counter_t rx_bulk_bytes;
+            details::counter_t tx_bulk_frames;
+            details::counter_t rx_out_of_order;
+            details::counter_t rx_duplicates;
+            details::counter_t tx_acks;
+            details::counter_t tx_piggybacked_acks;
+            details::counter_t tx_fragmented;
+            details::counter_t tx_fragments_dropped;
+            details::counter_t rx_fragments_dropped;
+            details::counter_t tx_credit_stalls;
+            details::counter_t tx_keepalives;
+            details::counter_t link_downs;
+            details::counter_t rx_crc_errors;           // from the framer, after each feed()
+            details::counter_t rx_dropped_bytes;
+            details::counter_t rx_fec_corrected;
+            details::counter_t rx_fec_uncorrectable;
+            details::counter_t srtt_us;                 // from the rtt estimator, see publish_rtt()
+            details::counter_t rttvar_us;
+            details::counter_t rto_us;
+            details::counter_t rtt_samples;
+        } _stats;
     };
 }
\ No newline at end of file
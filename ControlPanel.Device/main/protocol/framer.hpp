@@ -1,13 +1,20 @@
 #pragma once
 
 #include <stdint.h>
+#include <array>
+#include <optional>
+#include <span>
+#include <tuple>
 #include <ranges>
 #include <algorithm>
+#include <limits>
 #include <etl/byte_stream.h>
-#include <etl/crc16_ccitt.h>
 
+#include "freertos/FreeRTOS.h"
 #include "esp_log.h"
 
+#include "crc16.hpp"
+#include "reed_solomon.hpp"
 #include "utils.hpp"
 #include "frame_buffer.hpp"
 
@@ -16,7 +23,65 @@ namespace transport
     enum class frame_type_t : uint8_t
     {
         data = 0,
-        ack = 1
+        ack = 1,            // to a peer that asked for a window, may carry the receiver's credit (credit_t)
+
+        // link self-test, handled by frame_host_connection_t below the message layer
+        ping = 2,           // answered with a pong carrying the same seq and payload
+        pong = 3,           // ping payload followed by the receiver's bulk counters (bulk_report_t)
+        bulk = 4,           // unacknowledged filler, only counted by the receiver
+        bulk_request = 5,   // asks the receiver to send bulk frames back (bulk_request_t)
+
+        framing = 6,        // switches both directions to the framing_t in the payload, echoed back before the receiver switches
+
+        window = 7,         // asks to send data frames ahead of their acks (window_request_t), the receiver switches to cumulative acks
+        window_ack = 8,     // accepts a window request, the payload is the largest window the receiver takes, then its credit like an ack
+        data_ack = 9,       // data frame carrying a cumulative ack in its first 2 bytes, only sent to peers that asked for a window
+        fragment = 10,      // data frame carrying part of a message larger than a frame (fragment_header_t), only sent to peers that accepted a window
+        hello = 11          // what the sender supports (hello_t), answered with the receiver's own unless it is an answer itself
+    };
+
+    enum class framing_t : uint8_t
+    {
+        magic = 0,          // magic, len, seq, type, data, crc16
+        cobs = 1,           // cobs(seq, type, data, crc16) followed by a zero delimiter
+        magic_fec = 2       // magic, rs(len, seq, type), rs blocks of (data, crc16)
+    };
+
+    constexpr uint8_t framing_mask(framing_t framing)
+    {
+        return static_cast<uint8_t>(1u << static_cast<uint8_t>(framing));
+    }
+
+    // Link features a hello advertises, as bits.
+    enum class link_feature_t : uint16_t
+    {
+        chunked = 1 << 0,   // takes frames larger than its receive buffer, in chunks
+        window = 1 << 1,    // answers window frames, acks cumulatively and takes data_ack frames
+        fragments = 1 << 2, // puts fragment frames back together
+        credit = 1 << 3,    // acks may carry a credit_t
+        ping = 1 << 4       // answers ping frames, keepalives included
+    };
+
+    // Encodings of the message payloads above the link, as bits of hello_t::compressions. Nothing is compressed yet,
+    // uncompressed payloads need no bit and are always understood.
+    enum class compression_t : uint8_t
+    {
+        none = 0
+    };
+
+    // Image formats the end takes in messages, as bits of hello_t::pixel_formats.
+    enum class pixel_format_t : uint8_t
+    {
+        rgb565a8 = 1 << 0,  // app icons: rgb565 pixels followed by an 8 bit alpha plane (LVGL RGB565A8)
+        a8 = 1 << 1         // stream title sprites: 8 bit alpha only
+    };
+
+    struct framer_stats_t
+    {
+        uint32_t crc_errors;
+        uint32_t dropped_bytes;     // received bytes that were not part of a delivered frame
+        uint32_t fec_corrected;     // frames with bytes repaired by the fec
+        uint32_t fec_uncorrectable; // frames with more corrupted bytes than the fec can repair
     };
 
     enum class frame_field_t
@@ -33,12 +98,285 @@ namespace transport
     {
         uint16_t seq;
         frame_type_t type;
-        std::span<uint8_t> data;
+        std::span<const uint8_t> data;
+    };
+
+    enum class chunk_status_t : uint8_t
+    {
+        partial,        // more of the frame follows
+        complete,       // the frame ended with a valid crc, data is empty
+        failed          // the frame ended with a bad crc or was cut short, data is empty
+    };
+
+    // Part of a frame too large for the framer buffer. The chunks of a frame arrive in order starting at offset 0
+    // and end with a complete or failed chunk; only then is it known whether the data handed out so far was valid.
+    struct frame_chunk_t
+    {
+        uint16_t seq;
+        frame_type_t type;
+        std::size_t offset;         // of data in the frame payload
+        std::size_t size;           // payload size of the whole frame, 0 with cobs framing where it is not known in advance
+        std::span<const uint8_t> data;
+        chunk_status_t status;
+    };
+
+    // Passed as on_chunk when the caller only takes whole frames, frames too large for the buffer are dropped.
+    struct no_chunks_t
+    {
+        void operator()(const frame_chunk_t&) const {}
+    };
+
+    // Payload of a bulk_request frame.
+    struct bulk_request_t
+    {
+        static constexpr std::size_t SIZE = 6;
+
+        uint32_t bytes;             // total bulk payload to send back
+        uint16_t frame_size;        // payload per bulk frame, the sender caps it at its largest frame
+
+        void to_bytes(std::span<uint8_t, SIZE> buffer) const
+        {
+            etl::byte_stream_writer writer(buffer, etl::endian::big);
+            writer.write<uint32_t>(bytes);
+            writer.write<uint16_t>(frame_size);
+        }
+
+        static std::optional<bulk_request_t> from_bytes(std::span<const uint8_t> data)
+        {
+            if (data.size() < SIZE)
+                return {};
+
+            etl::byte_stream_reader reader(static_cast<const void*>(data.data()), SIZE, etl::endian::big);
+            return bulk_request_t{ *reader.read<uint32_t>(), *reader.read<uint16_t>() };
+        }
+    };
+
+    // Payload of a window frame. Also sent again to move the receiver past frames the sender gave up on.
+    struct window_request_t
+    {
+        static constexpr std::size_t SIZE = 3;
+
+        uint8_t size;               // frames the sender wants to have in flight
+        uint16_t next_seq;          // oldest seq the sender still delivers, the receiver expects it next
+
+        void to_bytes(std::span<uint8_t, SIZE> buffer) const
+        {
+            etl::byte_stream_writer writer(buffer, etl::endian::big);
+            writer.write<uint8_t>(size);
+            writer.write<uint16_t>(next_seq);
+        }
+
+        static std::optional<window_request_t> from_bytes(std::span<const uint8_t> data)
+        {
+            if (data.size() < SIZE)
+                return {};
+
+            etl::byte_stream_reader reader(static_cast<const void*>(data.data()), SIZE, etl::endian::big);
+            return window_request_t{ *reader.read<uint8_t>(), *reader.read<uint16_t>() };
+        }
+    };
+
+    // Payload of an ack from a receiver whose transport has a bounded buffer and no flow control of its own:
+    // the sender may have that many bytes written after the last data frame the receiver read.
+    struct credit_t
+    {
+        static constexpr std::size_t SIZE = 4;
+
+        uint16_t bytes;
+        uint16_t read_seq;          // last data frame read, in order or not
+
+        void to_bytes(std::span<uint8_t, SIZE> buffer) const
+        {
+            etl::byte_stream_writer writer(buffer, etl::endian::big);
+            writer.write<uint16_t>(bytes);
+            writer.write<uint16_t>(read_seq);
+        }
+
+        static std::optional<credit_t> from_bytes(std::span<const uint8_t> data)
+        {
+            if (data.size() < SIZE)
+                return {};
+
+            etl::byte_stream_reader reader(static_cast<const void*>(data.data()), SIZE, etl::endian::big);
+            return credit_t{ *reader.read<uint16_t>(), *reader.read<uint16_t>() };
+        }
+    };
+
+    // Start of a fragment frame payload, the rest is part of the message. The fragments of a message are sent
+    // in order with consecutive indices, fragments of messages on other channels may come in between.
+    struct fragment_header_t
+    {
+        static constexpr std::size_t SIZE = 5;
+
+        uint8_t channel;            // logical channel of the sender, the receiver assembles one message per channel
+        uint16_t message_id;
+        uint8_t index;
+        uint8_t count;              // fragments of the whole message
+
+        void to_bytes(std::span<uint8_t, SIZE> buffer) const
+        {
+            etl::byte_stream_writer writer(buffer, etl::endian::big);
+            writer.write<uint8_t>(channel);
+            writer.write<uint16_t>(message_id);
+            writer.write<uint8_t>(index);
+            writer.write<uint8_t>(count);
+        }
+
+        static std::optional<fragment_header_t> from_bytes(std::span<const uint8_t> data)
+        {
+            if (data.size() < SIZE)
+                return {};
+
+            etl::byte_stream_reader reader(static_cast<const void*>(data.data()), SIZE, etl::endian::big);
+            return fragment_header_t{ *reader.read<uint8_t>(), *reader.read<uint16_t>(), *reader.read<uint8_t>(), *reader.read<uint8_t>() };
+        }
+    };
+
+    // Payload of a hello frame: what the sending end supports. Both ends send one when the link starts or comes back
+    // and answer the peer's with their own, then pick the same settings from the pair (link_settings_t). The framings
+    // are what the host may ask for with a framing frame, the hello does not switch them. Later versions only append
+    // fields, an end reads the ones it knows and ignores the rest.
+    struct hello_t
+    {
+        static constexpr std::size_t SIZE = 16;
+        static constexpr uint8_t VERSION = 1;
+        static constexpr uint8_t REPLY = 0x01;
+
+        uint8_t version;
+        uint8_t flags;              // REPLY when it answers the peer's hello
+        uint16_t max_frame;         // largest frame body the end sends
+        uint16_t rx_frame_buffer;   // largest frame body it takes whole, saturated
+        uint16_t rx_buffer;         // bytes its transport buffers before they are read, 0 when it does not say
+        uint8_t window;             // frames it takes in flight, 1 is stop-and-wait
+        uint16_t max_message;       // largest fragmented message it puts back together
+        uint8_t framings;           // framing_mask() of every framing it switches to
+        uint8_t compressions;       // compression_t bits
+        uint8_t pixel_formats;      // pixel_format_t bits
+        uint16_t features;          // link_feature_t bits
+
+        bool supports(link_feature_t feature) const
+        {
+            return features & static_cast<uint16_t>(feature);
+        }
+
+        void to_bytes(std::span<uint8_t, SIZE> buffer) const
+        {
+            etl::byte_stream_writer writer(buffer, etl::endian::big);
+            writer.write<uint8_t>(version);
+            writer.write<uint8_t>(flags);
+            writer.write<uint16_t>(max_frame);
+            writer.write<uint16_t>(rx_frame_buffer);
+            writer.write<uint16_t>(rx_buffer);
+            writer.write<uint8_t>(window);
+            writer.write<uint16_t>(max_message);
+            writer.write<uint8_t>(framings);
+            writer.write<uint8_t>(compressions);
+            writer.write<uint8_t>(pixel_formats);
+            writer.write<uint16_t>(features);
+        }
+
+        static std::optional<hello_t> from_bytes(std::span<const uint8_t> data)
+        {
+            if (data.size() < SIZE)
+                return {};
+
+            etl::byte_stream_reader reader(static_cast<const void*>(data.data()), SIZE, etl::endian::big);
+            hello_t ret;
+            ret.version = *reader.read<uint8_t>();
+            ret.flags = *reader.read<uint8_t>();
+            ret.max_frame = *reader.read<uint16_t>();
+            ret.rx_frame_buffer = *reader.read<uint16_t>();
+            ret.rx_buffer = *reader.read<uint16_t>();
+            ret.window = *reader.read<uint8_t>();
+            ret.max_message = *reader.read<uint16_t>();
+            ret.framings = *reader.read<uint8_t>();
+            ret.compressions = *reader.read<uint8_t>();
+            ret.pixel_formats = *reader.read<uint8_t>();
+            ret.features = *reader.read<uint16_t>();
+            return ret;
+        }
+    };
+
+    // Settings both ends of a link arrive at from their two hellos, whichever end computes them.
+    struct link_settings_t
+    {
+        uint8_t version;            // the lower one, each end speaks the older protocol
+        std::size_t window;         // 1 when either end asks for none, then no window frame is sent
+        std::size_t max_message;    // larger messages are not fragmented, they are dropped by the sender
+        uint8_t compressions;       // both take
+        uint8_t pixel_formats;
+        uint16_t features;          // both support
+
+        bool supports(link_feature_t feature) const
+        {
+            return features & static_cast<uint16_t>(feature);
+        }
+
+        static link_settings_t negotiate(const hello_t& a, const hello_t& b)
+        {
+            return link_settings_t{
+                .version = std::min(a.version, b.version),
+                .window = std::max<std::size_t>(std::min(a.window, b.window), 1),
+                .max_message = std::min(a.max_message, b.max_message),
+                .compressions = static_cast<uint8_t>(a.compressions & b.compressions),
+                .pixel_formats = static_cast<uint8_t>(a.pixel_formats & b.pixel_formats),
+                .features = static_cast<uint16_t>(a.features & b.features)
+            };
+        }
     };
 
-    template<std::size_t MagicSize, std::size_t BufferSize>
+    // Trailer of a pong frame: bulk traffic the pinged side has received so far.
+    struct bulk_report_t
+    {
+        static constexpr std::size_t SIZE = 8;
+
+        uint32_t frames;
+        uint32_t bytes;
+
+        void to_bytes(std::span<uint8_t, SIZE> buffer) const
+        {
+            etl::byte_stream_writer writer(buffer, etl::endian::big);
+            writer.write<uint32_t>(frames);
+            writer.write<uint32_t>(bytes);
+        }
+
+        static std::optional<bulk_report_t> from_bytes(std::span<const uint8_t> data)
+        {
+            if (data.size() < SIZE)
+                return {};
+
+            etl::byte_stream_reader reader(static_cast<const void*>(data.data()), SIZE, etl::endian::big);
+            return bulk_report_t{ *reader.read<uint32_t>(), *reader.read<uint32_t>() };
+        }
+    };
+
+    // Incremental frame parser. feed() can be called with chunks of any size: the parse state (magic bytes
+    // matched so far, header fields, bytes of the current frame) is kept between calls, so every received byte
+    // is looked at once. Bytes outside a frame are scanned in place and never copied. A frame that arrives whole
+    // within one feed() call is parsed and delivered straight from the caller's span, only frames split across
+    // calls are collected in the buffer.
+    //
+    // Resync: a header with an impossible length, or one beyond set_max_len(), is dropped and only its own bytes
+    // are searched again for the magic. A frame with a bad crc is searched again from behind its magic, so a
+    // damaged len costs that frame only and not the ones it ran into, at one crc per false magic found in it.
+    // Fec frames and chunked frames are skipped as a whole.
+    //
+    // A frame larger than the buffer is dropped, unless feed() is given an on_chunk callback: the frame is then
+    // handed out in order as frame_chunk_t pieces while it arrives, the crc is checked at the end and reported
+    // with the last chunk. With magic framing the pieces come straight from the caller's span, fec framing
+    // buffers one block and cobs framing one buffer of unstuffed bytes at a time.
+    //
+    // With framing_t::cobs frames are byte stuffed and end at the next zero byte, which cannot occur inside a
+    // frame. A corrupted frame then costs only itself: the parser continues at the next delimiter, where with
+    // magic framing a damaged len can swallow the frames behind it.
+    //
+    // framing_t::magic_fec is the magic framing with Reed-Solomon parity behind the header and behind every
+    // FEC_BLOCK bytes of data and crc16. The parity repairs a few corrupted bytes per block before the crc is
+    // checked, so a noisy link loses a frame to a retransmission far less often, and protects len as well.
+    template<std::array Magic, std::size_t BufferSize>
     class framer_t {
         static constexpr char TAG[] = "FRAMER";
+        static constexpr std::size_t MagicSize = Magic.size();
 
     public:
 
@@ -46,27 +384,25 @@ namespace transport
         using type_t = std::underlying_type_t<frame_type_t>;
         using len_t = uint16_t;
 
-        framer_t(std::span<const uint8_t, MagicSize> magic)
-            : _magic(magic)
-        {
-        }
-
         std::size_t to_bytes(std::span<uint8_t> buffer, const frame_t& frame)
         {
-            configASSERT(calc_frame_size(frame.data.size()) < buffer.size());
-
-            etl::byte_stream_writer writer(buffer, etl::endian::big);
+            if (_framing == framing_t::cobs)
+                return to_cobs_bytes(buffer, frame);
+            if (_framing == framing_t::magic_fec)
+                return to_fec_bytes(buffer, frame);
 
-            writer.write<const uint8_t>(_magic);
-            writer.write<len_t>(frame.data.size());
-            writer.write<seq_t>(frame.seq);
-            writer.write<type_t>(static_cast<uint8_t>(frame.type));
-            writer.write<uint8_t>(frame.data);
-            writer.write<uint16_t>(crc16_ccitt(writer.used_data()));
+            return to_magic_bytes(buffer, frame);
+        }
 
-            ESP_LOGD(TAG, "frame to bytes seq=%d type=%d size=%d", frame.seq, static_cast<uint8_t>(frame.type), frame.data.size());
+        // Frames data_size bytes already placed at buffer[DATA_OFFSET], with room for the crc behind them. The magic
+        // framing writes the header and crc around them in place. Cobs and fec rewrite the body, so they encode into
+        // scratch and leave buffer as it is for a retransmission.
+        std::span<uint8_t> to_bytes_in_place(std::span<uint8_t> buffer, std::size_t data_size, uint16_t seq, frame_type_t type, std::span<uint8_t> scratch)
+        {
+            if (_framing != framing_t::magic)
+                return scratch.first(to_bytes(scratch, frame_t{seq, type, buffer.subspan(DATA_OFFSET, data_size)}));
 
-            return writer.size_bytes();
+            return buffer.first(write_magic_frame(buffer, data_size, seq, type));
         }
 
         template<frame_field_t... excludes>
@@ -86,91 +422,813 @@ namespace transport
             return ret;
         }
 
+        // Worst case size of a cobs frame, one code byte per 254 bytes plus the delimiter.
+        static constexpr std::size_t calc_cobs_frame_size(std::size_t data_size)
+        {
+            auto raw = COBS_HEADER_SIZE + data_size + sizeof(ushort);
+            return raw + raw / 254 + 1 + 1;
+        }
+
+        static constexpr std::size_t calc_fec_frame_size(std::size_t data_size)
+        {
+            auto body = data_size + sizeof(ushort);
+            return HEADER_SIZE + FEC_HEADER_PARITY + body + (body + FEC_BLOCK - 1) / FEC_BLOCK * FEC_PARITY;
+        }
+
+        // Where to_bytes_in_place expects the body.
+        static constexpr std::size_t DATA_OFFSET = MagicSize + sizeof(len_t) + sizeof(seq_t) + sizeof(type_t);
+
+        // Largest frame any framing makes of data_size bytes, for sizing tx buffers.
+        static constexpr std::size_t calc_max_frame_size(std::size_t data_size)
+        {
+            return std::max({ static_cast<std::size_t>(calc_frame_size(data_size)), calc_cobs_frame_size(data_size), calc_fec_frame_size(data_size) });
+        }
+
+        // Switches both directions, a partially received frame is dropped.
+        void set_framing(framing_t framing)
+        {
+            ESP_LOGI(TAG, "framing %d -> %d", static_cast<int>(_framing), static_cast<int>(framing));
+
+            _framing = framing;
+            _state = state_t::magic;
+            _magic_matched = 0;
+            reset_cobs();
+        }
+
+        framing_t framing() const
+        {
+            return _framing;
+        }
+
+        // Largest body the peer says it sends. A header announcing more is a damaged one and is resynced on at once,
+        // rather than waiting for a body that swallows the frames behind it.
+        void set_max_len(std::size_t len)
+        {
+            _max_len = std::min<std::size_t>(len, std::numeric_limits<len_t>::max());
+        }
+
+        framer_stats_t stats() const
+        {
+            return _stats;
+        }
+
+        template <class F, class C = no_chunks_t>
+        void feed(std::span<const uint8_t> data, F&& on_frame, C&& on_chunk = {})
+        {
+            while (!data.empty())
+            {
+                if (_framing == framing_t::cobs)
+                {
+                    data = read_cobs(data, on_frame, on_chunk);
+                    continue;
+                }
+
+                switch (_state)
+                {
+                    case state_t::magic:
+                        data = find_frame_start(data, on_frame);
+                        break;
+                    case state_t::header:
+                        data = read_header<!std::is_same_v<std::remove_cvref_t<C>, no_chunks_t>>(data);
+                        break;
+                    case state_t::body:
+                        data = read_body(data, on_frame);
+                        break;
+                    case state_t::chunked_body:
+                        data = read_chunked_body(data, on_chunk);
+                        break;
+                }
+            }
+        }
+
+    private:
+        enum class state_t
+        {
+            magic,
+            header,
+            body,
+            chunked_body
+        };
+
+        struct header_t
+        {
+            len_t len;
+            seq_t seq;
+            type_t type;
+            std::size_t frame_size;     // without fec parity
+            std::size_t wire_size;
+        };
+
+        static constexpr std::size_t HEADER_SIZE = DATA_OFFSET;
+        static constexpr std::size_t COBS_HEADER_SIZE = sizeof(seq_t) + sizeof(type_t);
+
+        // RS(136, 128) corrects 4 bytes per block of data and crc16, the 5 header bytes get 4 parity bytes for 2
+        static constexpr std::size_t FEC_BLOCK = 128;
+        static constexpr std::size_t FEC_PARITY = 8;
+        static constexpr std::size_t FEC_HEADER_PARITY = 4;
+        using fec_t = reed_solomon_t<FEC_PARITY>;
+        using fec_header_t = reed_solomon_t<FEC_HEADER_PARITY>;
+        static_assert(FEC_BLOCK <= fec_t::MAX_DATA);
+        static_assert(BufferSize >= HEADER_SIZE + FEC_HEADER_PARITY && BufferSize >= FEC_BLOCK + FEC_PARITY, "chunked delivery needs room for a header and a fec block");
+
+        std::size_t header_size() const
+        {
+            return _framing == framing_t::magic_fec ? HEADER_SIZE + FEC_HEADER_PARITY : HEADER_SIZE;
+        }
+
+        // kmp failure function of Magic, lets a magic split across feed() calls be matched one byte at a time
+        static constexpr std::array<uint8_t, MagicSize> MAGIC_FALLBACK = []
+        {
+            std::array<uint8_t, MagicSize> ret{};
+            for (std::size_t i = 1, k = 0; i < MagicSize; i++)
+            {
+                while (k > 0 && Magic[i] != Magic[k])
+                    k = ret[k - 1];
+                if (Magic[i] == Magic[k])
+                    k++;
+                ret[i] = k;
+            }
+            return ret;
+        }();
+
+        static std::size_t match_magic_byte(std::size_t matched, uint8_t b)
+        {
+            while (matched > 0 && b != Magic[matched])
+                matched = MAGIC_FALLBACK[matched - 1];
+            return b == Magic[matched] ? matched + 1 : 0;
+        }
+
+        template <class F>
+        std::span<const uint8_t> find_frame_start(std::span<const uint8_t> data, F& on_frame)
+        {
+            if (_magic_matched > 0)
+            {
+                auto matched = match_magic_byte(_magic_matched, data.front());
+                _stats.dropped_bytes += _magic_matched + 1 - matched;
+                _magic_matched = matched;
+                data = data.subspan(1);
+            }
+            else if (auto start = find_magic<Magic>(data); start != -1)
+            {
+                // fast path, the whole frame is in the caller's span: parse it there instead of copying it,
+                // fec frames may need repairs and always go through the buffer
+                _stats.dropped_bytes += start;
+                data = data.subspan(start);
+                if (auto header = decode_header(data); header && _framing == framing_t::magic && header->wire_size <= _buffer.capacity() && header->frame_size <= data.size())
+                {
+                    ESP_LOGI(TAG, "frame found");
+                    auto frame = data.first(header->frame_size);
+                    if (!deliver(frame, *header, frame_crc16_t::compute(frame.first(header->frame_size - sizeof(ushort))), on_frame))
+                    {
+                        _buffer.clear();
+                        _buffer.try_insert(frame);
+                        count_crc_error(1);
+                        rescan_buffer(on_frame);
+                    }
+                    return data.subspan(header->frame_size);
+                }
+
+                _magic_matched = MagicSize;
+                data = data.subspan(MagicSize);
+            }
+            else
+            {
+                // no magic in data, but its end can be the beginning of one
+                for (auto b: data.last(std::min(data.size(), MagicSize - 1)))
+                    _magic_matched = match_magic_byte(_magic_matched, b);
+                _stats.dropped_bytes += data.size() - _magic_matched;
+                return {};
+            }
+
+            if (_magic_matched == MagicSize)
+            {
+                ESP_LOGI(TAG, "frame found");
+
+                _magic_matched = 0;
+                _buffer.clear();
+                _buffer.try_insert(Magic);
+                _crc.reset();
+                _crc.add(Magic);
+                _state = state_t::header;
+            }
+
+            return data;
+        }
+
+        template <bool Chunked>
+        std::span<const uint8_t> read_header(std::span<const uint8_t> data)
+        {
+            auto n = std::min(data.size(), header_size() - _buffer.size());
+            _buffer.try_insert(data.first(n));
+            if (_framing == framing_t::magic)
+                _crc.add(data.first(n));
+            data = data.subspan(n);
+
+            if (_buffer.size() < header_size())
+                return data;
+
+            // parity has to be checked before, and only once the whole header is in
+            auto repaired = _framing == framing_t::magic_fec ? repair_header() : std::optional{ 0 };
+
+            auto header = repaired ? decode_header(_buffer.span()) : std::nullopt;
+            if (!header || (!Chunked && header->wire_size > _buffer.capacity()))
+            {
+                ESP_LOGE(TAG, "bad header or frame does not fit the buffer (%d), resyncing", _buffer.capacity());
+
+                // the magic may have been a false match, look for the real one in the header bytes after it
+                std::array<uint8_t, HEADER_SIZE + FEC_HEADER_PARITY - 1> rest;
+                auto size = _buffer.size() - 1;
+                std::memcpy(rest.data(), _buffer.span().data() + 1, size);
+
+                _stats.dropped_bytes++;
+                _state = state_t::magic;
+                _buffer.clear();
+                feed(std::span(rest).first(size), [](const frame_t&){});
+
+                return data;
+            }
+
+            _fec_repaired = *repaired;
+            _fec_uncorrectable = false;
+
+            _header = *header;
+            _state = state_t::body;
+
+            if (header->wire_size > _buffer.capacity())
+            {
+                ESP_LOGI(TAG, "frame of %d B does not fit the buffer (%d), delivering it in chunks", header->len, _buffer.capacity());
+
+                // the crc over magic and header is complete by now, the buffer is free for the body
+                if (_framing == framing_t::magic_fec)
+                {
+                    _crc.reset();
+                    _crc.add(_buffer.span().first(HEADER_SIZE));
+                }
+
+                _body_received = 0;
+                _buffer.clear();
+                _state = state_t::chunked_body;
+            }
+
+            return data;
+        }
+
+        template <class F>
+        std::span<const uint8_t> read_body(std::span<const uint8_t> data, F& on_frame)
+        {
+            // the checksum is updated while the bytes are still in cache instead of in a second pass at the end
+            auto crc_at = _header.frame_size - sizeof(ushort);
+            auto n = std::min(data.size(), _header.wire_size - _buffer.size());
+            if (_framing == framing_t::magic && _buffer.size() < crc_at)
+                _crc.add(data.first(std::min(n, crc_at - _buffer.size())));
+            _buffer.try_insert(data.first(n));
+            data = data.subspan(n);
+
+            if (_buffer.size() < _header.wire_size)
+                return data;
+
+            _state = state_t::magic;
+            if (_framing == framing_t::magic_fec)
+            {
+                // repaired bytes are only known after the parity, so the crc is computed afterwards
+                auto frame = repair_body();
+                if (!deliver(frame, _header, frame_crc16_t::compute(frame.first(crc_at)), on_frame))
+                    count_crc_error(_header.wire_size);
+            }
+            else if (!deliver(_buffer.span(), _header, _crc.value(), on_frame))
+            {
+                count_crc_error(1);
+                rescan_buffer(on_frame);
+                return data;
+            }
+            _buffer.clear();
+
+            return data;
+        }
+
+        // Repairs the header in the buffer and moves len, seq and type next to the magic, returns the number of
+        // repaired bytes or empty when the header is beyond repair.
+        std::optional<int> repair_header()
+        {
+            auto block = _buffer.span().subspan(MagicSize, HEADER_SIZE - MagicSize + FEC_HEADER_PARITY);
+            auto repaired = fec_header_t::decode(block);
+            if (repaired < 0)
+            {
+                _stats.fec_uncorrectable++;
+                return {};
+            }
+
+            return repaired;
+        }
+
+        // Repairs the blocks of data and crc16 in the buffer and packs them behind the header without their parity,
+        // returns the frame as it was before the parity was added.
+        std::span<const uint8_t> repair_body()
+        {
+            auto buffer = _buffer.span();
+            auto header_size = HEADER_SIZE + FEC_HEADER_PARITY;
+            auto body_size = _header.frame_size - HEADER_SIZE;
+
+            // the header parity goes first, each block then moves back by the parity in front of it
+            for (std::size_t at = 0, block = 0; at < body_size; at += FEC_BLOCK, block++)
+            {
+                auto size = std::min(FEC_BLOCK, body_size - at);
+                auto wire = buffer.subspan(header_size + at + block * FEC_PARITY, size + FEC_PARITY);
+
+                repair_block(wire);
+                std::memmove(buffer.data() + HEADER_SIZE + at, wire.data(), size);
+            }
+
+            count_fec_repairs();
+            return buffer.first(_header.frame_size);
+        }
+
+        void repair_block(std::span<uint8_t> wire)
+        {
+            auto result = fec_t::decode(wire);
+            if (result < 0)
+                _fec_uncorrectable = true;
+            else
+                _fec_repaired += result;
+        }
+
+        void count_fec_repairs()
+        {
+            if (_fec_uncorrectable)
+                _stats.fec_uncorrectable++;
+            else if (_fec_repaired > 0)
+                _stats.fec_corrected++;
+
+            if (_fec_repaired > 0)
+                ESP_LOGW(TAG, "fec repaired %d bytes seq=%d", _fec_repaired, _header.seq);
+        }
+
+        // Body of a frame larger than the buffer: payload goes out as it arrives, the crc16 bytes are kept for the end.
+        template <class C>
+        std::span<const uint8_t> read_chunked_body(std::span<const uint8_t> data, C& on_chunk)
+        {
+            auto body_size = _header.frame_size - HEADER_SIZE;
+
+            if (_framing == framing_t::magic_fec)
+            {
+                auto block_size = std::min(FEC_BLOCK, body_size - _body_received);
+                auto n = std::min(data.size(), block_size + FEC_PARITY - _buffer.size());
+                _buffer.try_insert(data.first(n));
+                data = data.subspan(n);
+
+                if (_buffer.size() < block_size + FEC_PARITY)
+                    return data;
+
+                repair_block(_buffer.span());
+                chunk_body(_buffer.span().first(block_size), on_chunk);
+                _buffer.clear();
+            }
+            else
+            {
+                auto n = std::min(data.size(), body_size - _body_received);
+                chunk_body(data.first(n), on_chunk);
+                data = data.subspan(n);
+            }
+
+            if (_body_received < body_size)
+                return data;
+
+            if (_framing == framing_t::magic_fec)
+                count_fec_repairs();
+
+            auto crc16 = static_cast<uint16_t>(_chunk_crc16[0] << 8 | _chunk_crc16[1]);
+            auto ok = _crc.value() == crc16;
+            if (!ok)
+                count_crc_error(_header.wire_size);
+
+            _state = state_t::magic;
+            on_chunk(frame_chunk_t{_header.seq, static_cast<frame_type_t>(_header.type), _header.len, _header.len, {},
+                ok ? chunk_status_t::complete : chunk_status_t::failed});
+
+            return data;
+        }
+
+        // Hands out the payload part of body bytes and keeps the crc16 part.
+        template <class C>
+        void chunk_body(std::span<const uint8_t> body, C& on_chunk)
+        {
+            if (_body_received < _header.len)
+            {
+                auto payload = body.first(std::min<std::size_t>(body.size(), _header.len - _body_received));
+                _crc.add(payload);
+                on_chunk(frame_chunk_t{_header.seq, static_cast<frame_type_t>(_header.type), _body_received, _header.len, payload, chunk_status_t::partial});
+            }
+
+            for (std::size_t i = 0; i < body.size(); i++)
+            {
+                if (_body_received + i >= _header.len)
+                    _chunk_crc16[_body_received + i - _header.len] = body[i];
+            }
+
+            _body_received += body.size();
+        }
+
+        std::size_t to_magic_bytes(std::span<uint8_t> buffer, const frame_t& frame)
+        {
+            configASSERT(calc_frame_size(frame.data.size()) <= buffer.size());
+
+            // an empty body may come without a buffer
+            if (!frame.data.empty())
+                std::memmove(buffer.data() + HEADER_SIZE, frame.data.data(), frame.data.size());
+            return write_magic_frame(buffer, frame.data.size(), frame.seq, frame.type);
+        }
+
+        // Header and crc around a body already at buffer[HEADER_SIZE].
+        std::size_t write_magic_frame(std::span<uint8_t> buffer, std::size_t data_size, uint16_t seq, frame_type_t type)
+        {
+            configASSERT(calc_frame_size(data_size) <= buffer.size());
+
+            etl::byte_stream_writer writer(buffer, etl::endian::big);
+
+            writer.write<const uint8_t>(Magic);
+            writer.write<len_t>(data_size);
+            writer.write<seq_t>(seq);
+            writer.write<type_t>(static_cast<uint8_t>(type));
+
+            auto size = HEADER_SIZE + data_size;
+            auto crc16 = frame_crc16_t::compute(buffer.first(size));
+            buffer[size] = crc16 >> 8;
+            buffer[size + 1] = crc16 & 0xff;
+
+            ESP_LOGD(TAG, "frame to bytes seq=%d type=%d size=%d", seq, static_cast<uint8_t>(type), data_size);
+
+            return size + sizeof(ushort);
+        }
+
+        std::size_t to_fec_bytes(std::span<uint8_t> buffer, const frame_t& frame)
+        {
+            configASSERT(calc_fec_frame_size(frame.data.size()) <= buffer.size());
+
+            // the plain frame is written first, then the blocks move back to make room for their parity,
+            // starting with the last one so nothing is overwritten before it moved
+            auto size = to_magic_bytes(buffer, frame);
+            auto body_size = size - HEADER_SIZE;
+            auto header_size = HEADER_SIZE + FEC_HEADER_PARITY;
+            auto blocks = (body_size + FEC_BLOCK - 1) / FEC_BLOCK;
+
+            for (auto block = blocks; block-- > 0;)
+            {
+                auto at = block * FEC_BLOCK;
+                auto block_size = std::min(FEC_BLOCK, body_size - at);
+                auto wire = buffer.subspan(header_size + at + block * FEC_PARITY, block_size + FEC_PARITY);
+
+                std::memmove(wire.data(), buffer.data() + HEADER_SIZE + at, block_size);
+                fec_t::encode(wire.first(block_size), wire.subspan(block_size).template first<FEC_PARITY>());
+            }
+
+            auto header = buffer.subspan(MagicSize, HEADER_SIZE - MagicSize + FEC_HEADER_PARITY);
+            fec_header_t::encode(header.first(HEADER_SIZE - MagicSize), header.subspan(HEADER_SIZE - MagicSize).template first<FEC_HEADER_PARITY>());
+
+            return header_size + body_size + blocks * FEC_PARITY;
+        }
+
+        // Header of the frame at the start of data, empty while it is incomplete or when len is beyond the peer's.
+        std::optional<header_t> decode_header(std::span<const uint8_t> data)
+        {
+            if (data.size() < HEADER_SIZE)
+                return {};
+
+            etl::byte_stream_reader reader(static_cast<const void*>(data.data()), HEADER_SIZE, etl::endian::big);
+            reader.skip<uint8_t>(MagicSize);
+
+            header_t header;
+            header.len = *reader.read<len_t>();
+            if (header.len > _max_len)
+                return {};
+            header.seq = *reader.read<seq_t>();
+            header.type = *reader.read<type_t>();
+            header.frame_size = HEADER_SIZE + header.len + sizeof(ushort);
+            header.wire_size = _framing == framing_t::magic_fec ? calc_fec_frame_size(header.len) : header.frame_size;
+
+            return header;
+        }
+
+        // Returns false when the crc does not match, the bytes are then the caller's to count or parse again.
         template <class F>
-        void feed(std::span<const uint8_t> data, F&& on_frame)
+        bool deliver(std::span<const uint8_t> frame, const header_t& header, uint16_t frame_crc16, F& on_frame)
         {
-            if (data.size() == 0)
+            auto crc_at = header.frame_size - sizeof(ushort);
+            if (frame_crc16 != static_cast<uint16_t>(frame[crc_at] << 8 | frame[crc_at + 1]))
+                return false;
+
+            on_frame(frame_t{header.seq, static_cast<frame_type_t>(header.type), frame.subspan(HEADER_SIZE, header.len)});
+            return true;
+        }
+
+        void count_crc_error(std::size_t dropped_bytes)
+        {
+            ESP_LOGE(TAG, "bad crc16");
+            _stats.crc_errors++;
+            _stats.dropped_bytes += dropped_bytes;
+        }
+
+        // The magic framed frame in the buffer failed its crc. A damaged len may have taken in the start of the
+        // frames behind it, so the bytes after its magic are parsed again where they are, the buffer being too large
+        // to copy to the stack. What is left over is continued with the bytes that follow the frame.
+        // A frame found there that needs chunked delivery is dropped, its start is gone by then. Magics that turn out
+        // to be false matches are dropped bytes, not crc errors.
+        template <class F>
+        void rescan_buffer(F& on_frame)
+        {
+            std::size_t at = 1;
+
+            while (_framing == framing_t::magic)
+            {
+                auto rest = _buffer.span().subspan(at);
+                auto start = find_magic<Magic>(rest);
+                if (start == -1)
+                    break;
+
+                _stats.dropped_bytes += start;
+                at += start;
+                rest = rest.subspan(start);
+
+                auto header = decode_header(rest);
+                if (rest.size() >= HEADER_SIZE && (!header || header->wire_size > _buffer.capacity()))
+                {
+                    _stats.dropped_bytes++;
+                    at++;
+                    continue;
+                }
+
+                if (header && header->frame_size <= rest.size())
+                {
+                    auto frame = rest.first(header->frame_size);
+                    if (deliver(frame, *header, frame_crc16_t::compute(frame.first(header->frame_size - sizeof(ushort))), on_frame))
+                    {
+                        at += header->frame_size;
+                    }
+                    else
+                    {
+                        _stats.dropped_bytes++;
+                        at++;
+                    }
+                    continue;
+                }
+
+                // the frame goes on in the next reads, it is taken up where read_header or read_body left off
+                _buffer.erase_front(at);
+                _crc.reset();
+                if (header)
+                {
+                    _header = *header;
+                    _crc.add(_buffer.span().first(std::min(_buffer.size(), header->frame_size - sizeof(ushort))));
+                    _state = state_t::body;
+                }
+                else
+                {
+                    _crc.add(_buffer.span());
+                    _state = state_t::header;
+                }
                 return;
+            }
+
+            // a frame delivered above may have switched the framing, the bytes behind it are then left to be resent
+            auto rest = _buffer.span().subspan(std::min(at, _buffer.size()));
+            _magic_matched = 0;
+            if (_framing == framing_t::magic)
+                for (auto b: rest.last(std::min(rest.size(), MagicSize - 1)))
+                    _magic_matched = match_magic_byte(_magic_matched, b);
+            _stats.dropped_bytes += rest.size() - _magic_matched;
+            _buffer.clear();
+        }
+
+        std::size_t to_cobs_bytes(std::span<uint8_t> buffer, const frame_t& frame)
+        {
+            auto raw_size = COBS_HEADER_SIZE + frame.data.size() + sizeof(ushort);
+            auto overhead = raw_size / 254 + 1;
 
-            if (!_buffer.try_insert(data))
+            configASSERT(calc_cobs_frame_size(frame.data.size()) <= buffer.size());
+
+            // the unstuffed frame goes behind room for the code bytes, so it can be encoded towards the front in place
+            auto raw = buffer.subspan(overhead, raw_size);
+            etl::byte_stream_writer writer(raw, etl::endian::big);
+            writer.write<seq_t>(frame.seq);
+            writer.write<type_t>(static_cast<uint8_t>(frame.type));
+            writer.write<const uint8_t>(frame.data);
+            writer.write<uint16_t>(frame_crc16_t::compute(raw.first(writer.size_bytes())));
+
+            auto out = buffer.data();
+            auto code_at = out++;
+            uint8_t code = 1;
+
+            for (auto b: raw)
             {
-                _buffer.shift_left_from(_magic);
-                _last_frame_start = -1;
-                if (!_buffer.try_insert(data))
+                if (b != 0)
                 {
-                    ESP_LOGE(TAG, "buffer to small (%d), dropping buffers", _buffer.capacity() - _buffer.size());
-                    _buffer.clear();
-                    return;
+                    *out++ = b;
+                    code++;
+                }
+
+                if (b == 0 || code == 0xFF)
+                {
+                    *code_at = code;
+                    code_at = out++;
+                    code = 1;
                 }
             }
 
-            auto span = _buffer.span();
+            *code_at = code;
+            *out++ = 0;
+
+            ESP_LOGD(TAG, "cobs frame to bytes seq=%d type=%d size=%d", frame.seq, static_cast<uint8_t>(frame.type), frame.data.size());
+
+            return out - buffer.data();
+        }
 
-            while (true)
+        // Unstuffs into the buffer until the delimiter and returns what is left after it.
+        template <class F, class C>
+        std::span<const uint8_t> read_cobs(std::span<const uint8_t> data, F& on_frame, C& on_chunk)
+        {
+            while (!data.empty())
             {
-                if (_last_frame_start == -1)
+                if (_cobs_overflow)
                 {
-                    auto start = find_sequence(span, _magic);
-                    if (start == -1)
-                        return;
+                    auto end = static_cast<const uint8_t*>(std::memchr(data.data(), 0, data.size()));
+                    auto n = end ? end - data.data() + 1 : data.size();
+                    _stats.dropped_bytes += n;
+                    data = data.subspan(n);
 
-                    _last_frame_start = start;
-                    ESP_LOGI(TAG, "frame found at %d", _last_frame_start);
+                    if (end)
+                        reset_cobs();
+                    continue;
                 }
 
-                auto reader_span = span.subspan(_last_frame_start);
+                if (_cobs_remaining == 0)
+                {
+                    auto code = data.front();
+                    data = data.subspan(1);
+                    _cobs_received++;
 
-                etl::byte_stream_reader reader(static_cast<void*>(reader_span.data()), reader_span.size(), etl::endian::big);
-                reader.skip<uint8_t>(_magic.size());
+                    if (code == 0)
+                    {
+                        end_cobs_frame(on_frame, on_chunk);
+                        return data;
+                    }
 
-                auto len = reader.read<len_t>();
-                if (!len || reader.available_bytes() < calc_frame_size<frame_field_t::magic, frame_field_t::len>(*len))
-                    return;
-                
-                auto seq = reader.read<seq_t>();
-                if (!seq)
-                    return;
-                
-                auto type = reader.read<type_t>();
-                if (!type)
-                    return;
-                
-                auto frame_data = reader.free_data().subspan(0, *len);
-                if (!reader.skip<uint8_t>(frame_data.size()))
-                    return;
+                    // a block shorter than 254 bytes stood for a zero, unless it was the last one
+                    if (_cobs_code != 0 && _cobs_code != 0xFF)
+                        append_cobs(std::array<uint8_t, 1>{ 0 }, on_chunk);
 
-                auto crc16 = reader.read<ushort>();
-                if (!crc16)
-                    return;
+                    _cobs_code = code;
+                    _cobs_remaining = code - 1;
+                    continue;
+                }
 
-                auto frame_crc16 = crc16_ccitt(reader_span.subspan(0, calc_frame_size<frame_field_t::crc16>(*len)));
+                auto n = std::min<std::size_t>(_cobs_remaining, data.size());
+                if (auto zero = static_cast<const uint8_t*>(std::memchr(data.data(), 0, n)))
+                {
+                    // delimiter inside a block, the frame was cut short
+                    auto k = zero - data.data();
+                    _stats.dropped_bytes += _cobs_received + k + 1;
+                    if (_cobs_chunked)
+                        on_chunk(frame_chunk_t{_header.seq, static_cast<frame_type_t>(_header.type), _body_received, 0, {}, chunk_status_t::failed});
+                    reset_cobs();
+                    return data.subspan(k + 1);
+                }
 
-                if (frame_crc16 == crc16)
+                _cobs_received += n;
+                _cobs_remaining -= n;
+                append_cobs(data.first(n), on_chunk);
+                data = data.subspan(n);
+            }
+
+            return data;
+        }
+
+        template <class C>
+        void append_cobs(std::span<const uint8_t> data, C& on_chunk)
+        {
+            _crc.add(data);
+
+            while (!_buffer.try_insert(data))
+            {
+                if constexpr (std::is_same_v<std::remove_cvref_t<C>, no_chunks_t>)
                 {
-                    on_frame(frame_t{*seq, static_cast<frame_type_t>(*type), {(uint8_t*)frame_data.data(), frame_data.size()}});
+                    ESP_LOGE(TAG, "frame does not fit the buffer (%d), skipping to the next delimiter", _buffer.capacity());
+                    _stats.dropped_bytes += _cobs_received;
+                    _cobs_overflow = true;
+                    return;
                 }
                 else
                 {
-                    ESP_LOGE(TAG, "bad crc16 %d != %d", frame_crc16, crc16);
+                    auto n = _buffer.capacity() - _buffer.size();
+                    _buffer.try_insert(data.first(n));
+                    data = data.subspan(n);
+                    flush_cobs_chunk(on_chunk);
                 }
+            }
+        }
 
-                _buffer.seek(_last_frame_start + reader.used_data().size());
-                _last_frame_start = -1;
-                span = _buffer.span();
+        // Hands out everything in the full buffer but the last two bytes, which may turn out to be the crc16.
+        template <class C>
+        void flush_cobs_chunk(C& on_chunk)
+        {
+            auto buffer = _buffer.span();
+            std::size_t skip = 0;
+
+            if (!_cobs_chunked)
+            {
+                ESP_LOGI(TAG, "cobs frame does not fit the buffer (%d), delivering it in chunks", _buffer.capacity());
+
+                _header.seq = static_cast<seq_t>(buffer[0] << 8 | buffer[1]);
+                _header.type = buffer[2];
+                _body_received = 0;
+                _cobs_chunked = true;
+                skip = COBS_HEADER_SIZE;
             }
+
+            auto payload = buffer.subspan(skip, buffer.size() - skip - sizeof(ushort));
+            on_chunk(frame_chunk_t{_header.seq, static_cast<frame_type_t>(_header.type), _body_received, 0, payload, chunk_status_t::partial});
+            _body_received += payload.size();
+
+            std::array<uint8_t, sizeof(ushort)> tail;
+            std::memcpy(tail.data(), buffer.last(sizeof(ushort)).data(), tail.size());
+            _buffer.clear();
+            _buffer.try_insert(tail);
         }
 
-    private:
-        static uint16_t crc16_ccitt(auto span)
+        template <class F, class C>
+        void end_cobs_frame(F& on_frame, C& on_chunk)
+        {
+            auto frame = _buffer.span();
+
+            if (_cobs_chunked)
+            {
+                // the buffer holds at least the two bytes kept back by the last flush
+                auto ok = _crc.value() == 0;
+                auto payload = frame.first(frame.size() - sizeof(ushort));
+                if (!payload.empty())
+                    on_chunk(frame_chunk_t{_header.seq, static_cast<frame_type_t>(_header.type), _body_received, 0, payload, chunk_status_t::partial});
+
+                if (!ok)
+                {
+                    ESP_LOGE(TAG, "bad cobs frame crc=%d", _crc.value());
+                    _stats.crc_errors++;
+                    _stats.dropped_bytes += _cobs_received;
+                }
+
+                on_chunk(frame_chunk_t{_header.seq, static_cast<frame_type_t>(_header.type), _body_received + payload.size(), 0, {},
+                    ok ? chunk_status_t::complete : chunk_status_t::failed});
+            }
+            else if (frame.empty())
+            {
+                // back to back delimiters are allowed as idle fill
+            }
+            else if (frame.size() < COBS_HEADER_SIZE + sizeof(ushort) || _crc.value() != 0)
+            {
+                // the crc over a frame including its big endian crc16 is zero
+                ESP_LOGE(TAG, "bad cobs frame size=%d crc=%d", frame.size(), _crc.value());
+                _stats.crc_errors++;
+                _stats.dropped_bytes += _cobs_received;
+            }
+            else
+            {
+                auto seq = static_cast<seq_t>(frame[0] << 8 | frame[1]);
+                auto type = frame[2];
+                on_frame(frame_t{seq, static_cast<frame_type_t>(type), frame.subspan(COBS_HEADER_SIZE, frame.size() - COBS_HEADER_SIZE - sizeof(ushort))});
+            }
+
+            reset_cobs();
+        }
+
+        void reset_cobs()
         {
-            etl::crc16_ccitt_t<4> crc(span.begin(), span.end());
-            return crc.value();
+            _buffer.clear();
+            _crc.reset();
+            _cobs_code = 0;
+            _cobs_remaining = 0;
+            _cobs_received = 0;
+            _cobs_overflow = false;
+            _cobs_chunked = false;
         }
 
     private:
-        const std::span<const uint8_t, MagicSize> _magic;
         frame_buffer_t<BufferSize> _buffer;
-        int32_t _last_frame_start = -1;
+
+        state_t _state = state_t::magic;
+        std::size_t _magic_matched = 0;
+        header_t _header{};
+        int _fec_repaired = 0;
+        bool _fec_uncorrectable = false;
+        std::size_t _body_received = 0;
+        std::array<uint8_t, sizeof(ushort)> _chunk_crc16{};
+        frame_crc16_t _crc;
+
+        framing_t _framing = framing_t::magic;
+        std::size_t _max_len = std::numeric_limits<len_t>::max();
+        uint8_t _cobs_code = 0;
+        std::size_t _cobs_remaining = 0;
+        std::size_t _cobs_received = 0;
+        bool _cobs_overflow = false;
+        bool _cobs_chunked = false;
+
+        framer_stats_t _stats{};
 
         static constexpr std::array<std::tuple<frame_field_t, uint16_t>, 5> _field_sizes {{
             { frame_field_t::magic, MagicSize },
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <cstring>
+#include <optional>
+#include <span>
+
+// Layout of link capture files (transport::link_capture_t), shared with the host replay tool.
+//
+//   header: "CPLC" u8 version, u8[3] reserved
+//   record: u8 tag, LEB128 microseconds since the previous record (or since capture start), LEB128 length, data
+//
+// A 0x00 or 0xFF (erased flash) tag ends the capture.
+namespace link_capture
+{
+    inline constexpr std::array<uint8_t, 4> MAGIC{'C', 'P', 'L', 'C'};
+    inline constexpr uint8_t VERSION = 1;
+    inline constexpr std::size_t HEADER_SIZE = 8;
+    inline constexpr std::size_t MAX_RECORD_HEADER_SIZE = 1 + 10 + 10;
+
+    enum class record_tag_t : uint8_t
+    {
+        end = 0x00,
+        rx_chunk = 0x01,
+        erased = 0xFF
+    };
+
+    struct record_t
+    {
+        record_tag_t tag;
+        uint64_t timestamp_us;
+        std::span<const uint8_t> data;
+    };
+
+    inline std::size_t write_varint(std::span<uint8_t> out, uint64_t value)
+    {
+        std::size_t n = 0;
+        do
+        {
+            auto b = static_cast<uint8_t>(value & 0x7F);
+            value >>= 7;
+            out[n++] = value ? (b | 0x80) : b;
+        } while (value);
+
+        return n;
+    }
+
+    inline std::optional<uint64_t> read_varint(std::span<const uint8_t> in, std::size_t& offset)
+    {
+        uint64_t value = 0;
+        for (auto shift = 0; shift < 64 && offset < in.size(); shift += 7)
+        {
+            auto b = in[offset++];
+            value |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80))
+                return value;
+        }
+
+        return {};
+    }
+
+    inline std::size_t write_header(std::span<uint8_t, HEADER_SIZE> out)
+    {
+        std::memcpy(out.data(), MAGIC.data(), MAGIC.size());
+        out[4] = VERSION;
+        out[5] = out[6] = out[7] = 0;
+        return HEADER_SIZE;
+    }
+
+    inline std::size_t write_record_header(std::span<uint8_t, MAX_RECORD_HEADER_SIZE> out, record_tag_t tag, uint64_t delta_us, std::size_t size)
+    {
+        out[0] = static_cast<uint8_t>(tag);
+        auto n = 1 + write_varint(out.subspan(1), delta_us);
+        return n + write_varint(out.subspan(n), size);
+    }
+
+    class reader_t
+    {
+    public:
+        explicit reader_t(std::span<const uint8_t> capture)
+            : _capture(capture)
+        {
+            _valid = capture.size() >= HEADER_SIZE
+                && std::memcmp(capture.data(), MAGIC.data(), MAGIC.size()) == 0
+                && capture[4] == VERSION;
+            _offset = HEADER_SIZE;
+        }
+
+        bool valid() const
+        {
+            return _valid;
+        }
+
+        // Returns the next record, or nothing at the end of the capture or on a truncated record.
+        std::optional<record_t> next()
+        {
+            if (!_valid || _offset >= _capture.size())
+                return {};
+
+            auto tag = static_cast<record_tag_t>(_capture[_offset++]);
+            if (tag != record_tag_t::rx_chunk)
+                return {};
+
+            auto delta_us = read_varint(_capture, _offset);
+            auto size = read_varint(_capture, _offset);
+            if (!delta_us || !size || *size > _capture.size() - _offset)
+                return {};
+
+            _timestamp_us += *delta_us;
+
+            record_t record{ tag, _timestamp_us, _capture.subspan(_offset, *size) };
+            _offset += *size;
+
+            return record;
+        }
+
+    private:
+        std::span<const uint8_t> _capture;
+        std::size_t _offset = 0;
+        uint64_t _timestamp_us = 0;
+        bool _valid = false;
+    };
+}
@@ -158,4 +158,32 @@ std::span<uint8_t> serialize_bridge_message(const T& message)
     ESP_LOGD(protocol::SERIALIZE_TAG, "serialized to sz=%d", sz);
 
     return {writer.data(), sz};
+}
+
+// Serializes into out, usually a frame_host_connection_t tx slot (send_with). Returns the size, 0 when serialization
+// failed. When the message does not fit, out is left alone and the size it needs is returned.
+template<typename T>
+std::size_t serialize_bridge_message(const T& message, std::span<uint8_t> out)
+{
+    JsonDocument doc;
+    doc.set(message);
+
+    auto sz = measureMsgPack(doc);
+    if (!sz)
+    {
+        ESP_LOGE(protocol::SERIALIZE_TAG, "%s", "serialization failed");
+        return 0;
+    }
+
+    if (sz > out.size())
+    {
+        ESP_LOGD(protocol::SERIALIZE_TAG, "needs sz=%d max=%d", sz, out.size());
+        return sz;
+    }
+
+    sz = serializeMsgPack(doc, out.data(), out.size());
+
+    ESP_LOGD(protocol::SERIALIZE_TAG, "serialized to sz=%d", sz);
+
+    return sz;
 }
\ No newline at end of file
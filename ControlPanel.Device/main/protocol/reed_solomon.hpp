@@ -0,0 +1,214 @@
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <array>
+#include <span>
+
+#include "esp_attr.h"
+
+namespace transport
+{
+    namespace details
+    {
+        // GF(2^8) with the polynomial x^8 + x^4 + x^3 + x^2 + 1 (0x11d) and generator 2
+        struct gf256_tables_t
+        {
+            std::array<uint8_t, 512> exp;   // doubled so exp[log a + log b] needs no modulo
+            std::array<uint8_t, 256> log;
+        };
+
+        constexpr gf256_tables_t make_gf256_tables()
+        {
+            gf256_tables_t ret{};
+
+            uint32_t x = 1;
+            for (auto i = 0; i < 255; i++)
+            {
+                ret.exp[i] = x;
+                ret.log[x] = i;
+                x <<= 1;
+                if (x & 0x100)
+                    x ^= 0x11d;
+            }
+
+            for (auto i = 255; i < 512; i++)
+                ret.exp[i] = ret.exp[i - 255];
+
+            return ret;
+        }
+
+        DRAM_ATTR inline constexpr gf256_tables_t gf256 = make_gf256_tables();
+
+        constexpr uint8_t gf_mul(uint8_t a, uint8_t b)
+        {
+            return a == 0 || b == 0 ? 0 : gf256.exp[gf256.log[a] + gf256.log[b]];
+        }
+
+        constexpr uint8_t gf_div(uint8_t a, uint8_t b)
+        {
+            return a == 0 ? 0 : gf256.exp[gf256.log[a] + 255 - gf256.log[b]];
+        }
+
+        constexpr uint8_t gf_pow2(std::size_t e)
+        {
+            return gf256.exp[e % 255];
+        }
+    }
+
+    // Systematic Reed-Solomon code over GF(2^8) with Parity check bytes, shortened to any block of up to
+    // 255 bytes: the data is sent as is and followed by the parity, which repairs up to Parity / 2 corrupted
+    // bytes anywhere in the block.
+    template<std::size_t Parity>
+    class reed_solomon_t
+    {
+        static_assert(Parity >= 2 && Parity % 2 == 0 && Parity < 255);
+
+    public:
+        static constexpr std::size_t PARITY = Parity;
+        static constexpr std::size_t MAX_DATA = 255 - Parity;
+        static constexpr std::size_t MAX_ERRORS = Parity / 2;
+
+        // Parity of data, the remainder of data * x^Parity divided by the generator polynomial.
+        static IRAM_ATTR void encode(std::span<const uint8_t> data, std::span<uint8_t, Parity> parity)
+        {
+            std::ranges::fill(parity, 0);
+
+            for (auto b: data)
+            {
+                auto feedback = static_cast<uint8_t>(b ^ parity[0]);
+                for (std::size_t i = 0; i < Parity - 1; i++)
+                    parity[i] = parity[i + 1] ^ details::gf_mul(feedback, GENERATOR[i + 1]);
+                parity[Parity - 1] = details::gf_mul(feedback, GENERATOR[Parity]);
+            }
+        }
+
+        // Repairs block (data followed by its parity) in place. Returns the number of corrected bytes,
+        // or -1 when more bytes are corrupted than the code can locate.
+        static IRAM_ATTR int decode(std::span<uint8_t> block)
+        {
+            const auto n = block.size();
+
+            // almost every block arrives intact, and encoding is several times cheaper than the syndromes
+            std::array<uint8_t, Parity> parity;
+            encode(block.first(n - Parity), parity);
+            if (std::ranges::equal(parity, block.last(Parity)))
+                return 0;
+
+            // syndromes, the block polynomial evaluated at the generator roots 2^0 .. 2^(Parity-1)
+            std::array<uint8_t, Parity> syndromes{};
+            for (std::size_t i = 0; i < Parity; i++)
+            {
+                auto root = details::gf_pow2(i);
+                uint8_t s = 0;
+                for (auto b: block)
+                    s = details::gf_mul(s, root) ^ b;
+                syndromes[i] = s;
+            }
+
+            // Berlekamp-Massey, the error locator whose roots are the inverses of the error positions
+            std::array<uint8_t, Parity + 1> locator{ 1 };
+            std::array<uint8_t, Parity + 1> previous{ 1 };
+            std::size_t errors = 0;
+            std::size_t shift = 1;
+            uint8_t previous_discrepancy = 1;
+
+            for (std::size_t k = 0; k < Parity; k++)
+            {
+                uint8_t discrepancy = syndromes[k];
+                for (std::size_t i = 1; i <= errors; i++)
+                    discrepancy ^= details::gf_mul(locator[i], syndromes[k - i]);
+
+                if (discrepancy == 0)
+                {
+                    shift++;
+                    continue;
+                }
+
+                auto scale = details::gf_div(discrepancy, previous_discrepancy);
+                auto updated = locator;
+                for (std::size_t i = 0; i + shift <= Parity; i++)
+                    updated[i + shift] ^= details::gf_mul(scale, previous[i]);
+
+                if (2 * errors <= k)
+                {
+                    previous = locator;
+                    previous_discrepancy = discrepancy;
+                    errors = k + 1 - errors;
+                    shift = 1;
+                }
+                else
+                {
+                    shift++;
+                }
+
+                locator = updated;
+            }
+
+            if (errors > MAX_ERRORS)
+                return -1;
+
+            // error evaluator, syndromes * locator mod x^Parity
+            std::array<uint8_t, Parity> evaluator{};
+            for (std::size_t i = 0; i < Parity; i++)
+            {
+                for (std::size_t j = 0; j <= std::min(i, errors); j++)
+                    evaluator[i] ^= details::gf_mul(locator[j], syndromes[i - j]);
+            }
+
+            // Chien search over the positions of the shortened block, Forney for the error values
+            std::size_t found = 0;
+            for (std::size_t pos = 0; pos < n; pos++)
+            {
+                auto power = n - 1 - pos;
+                auto x_inv = details::gf_pow2(255 - power % 255);
+
+                uint8_t value = 0;
+                uint8_t derivative = 0;
+                uint8_t x_pow = 1;
+                for (std::size_t i = 0; i <= errors; i++)
+                {
+                    auto term = details::gf_mul(locator[i], x_pow);
+                    value ^= term;
+                    if (i & 1)
+                        derivative ^= details::gf_mul(locator[i], details::gf_div(x_pow, x_inv));
+                    x_pow = details::gf_mul(x_pow, x_inv);
+                }
+
+                if (value != 0)
+                    continue;
+
+                uint8_t omega = 0;
+                x_pow = 1;
+                for (std::size_t i = 0; i < Parity; i++)
+                {
+                    omega ^= details::gf_mul(evaluator[i], x_pow);
+                    x_pow = details::gf_mul(x_pow, x_inv);
+                }
+
+                if (derivative == 0)
+                    return -1;
+
+                block[pos] ^= details::gf_mul(details::gf_pow2(power), details::gf_div(omega, derivative));
+                found++;
+            }
+
+            // fewer roots inside the block than the locator's degree: the errors can not be located
+            return found == errors ? static_cast<int>(found) : -1;
+        }
+
+    private:
+        // generator polynomial (x - 2^0)(x - 2^1)...(x - 2^(Parity-1)), highest coefficient first
+        static constexpr std::array<uint8_t, Parity + 1> GENERATOR = []
+        {
+            std::array<uint8_t, Parity + 1> g{ 1 };
+            for (std::size_t i = 0; i < Parity; i++)
+            {
+                auto root = details::gf_pow2(i);
+                for (std::size_t j = i + 1; j > 0; j--)
+                    g[j] ^= details::gf_mul(g[j - 1], root);
+            }
+            return g;
+        }();
+    };
+}
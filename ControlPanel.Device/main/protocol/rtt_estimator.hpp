@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstdlib>
+
+#include "freertos/FreeRTOS.h"
+
+namespace transport
+{
+    // Retransmission timeout from the round trips measured on the link (RFC 6298): the smoothed round trip time
+    // plus four times its variation. Acks for retransmitted frames are ambiguous and not measured (Karn's rule).
+    // Every timeout doubles it, until an ack moves the window again: under heavy loss nearly every frame in flight
+    // is resent and new samples are rare, waiting for one would leave the link at the longest timeout.
+    class rtt_estimator_t
+    {
+    public:
+        static constexpr int64_t INITIAL_RTO_US = 1'000'000;
+        // a few ms over UART, where the round trip is well below a tick
+        static constexpr int64_t MIN_RTO_US = 10'000;
+        static constexpr int64_t MAX_RTO_US = 2'000'000;
+        // a retransmission cannot go out before the next tick, so less variation than that does not matter
+        static constexpr int64_t GRANULARITY_US = 1'000'000 / configTICK_RATE_HZ;
+
+        void add_sample(int64_t rtt_us)
+        {
+            if (_samples == 0)
+            {
+                _srtt_us = rtt_us;
+                _rttvar_us = rtt_us / 2;
+            }
+            else
+            {
+                _rttvar_us = (3 * _rttvar_us + std::abs(_srtt_us - rtt_us)) / 4;
+                _srtt_us = (7 * _srtt_us + rtt_us) / 8;
+            }
+
+            _samples++;
+            _backoff = 0;
+        }
+
+        void back_off()
+        {
+            if (rto_us() < MAX_RTO_US)
+                _backoff++;
+        }
+
+        void reset_backoff()
+        {
+            _backoff = 0;
+        }
+
+        int64_t rto_us() const
+        {
+            auto rto = _samples ? std::max(MIN_RTO_US, _srtt_us + std::max(GRANULARITY_US, 4 * _rttvar_us)) : INITIAL_RTO_US;
+            return std::min(rto << _backoff, MAX_RTO_US);
+        }
+
+        int64_t srtt_us() const
+        {
+            return _srtt_us;
+        }
+
+        int64_t rttvar_us() const
+        {
+            return _rttvar_us;
+        }
+
+        uint32_t samples() const
+        {
+            return _samples;
+        }
+
+    private:
+        int64_t _srtt_us = 0;
+        int64_t _rttvar_us = 0;
+        uint32_t _samples = 0;
+        uint32_t _backoff = 0;
+    };
+}
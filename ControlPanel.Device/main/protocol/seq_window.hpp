@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace transport
+{
+    // Data frame seqs received from a peer that acks frame by frame, so a retransmission whose first ack was lost
+    // is acked again but not delivered twice. Bit i of the bitmap stands for the newest seq minus i.
+    class seq_window_t
+    {
+    public:
+        static constexpr int16_t SIZE = 64;
+
+        // Marks seq as received, returns false when it already was.
+        bool mark(uint16_t seq)
+        {
+            auto distance = static_cast<int16_t>(seq - _newest);
+
+            // far behind the window or a first frame behind the newest one: the peer started over
+            if (!_any || distance <= -SIZE || (seq == 1 && distance < 0))
+            {
+                _any = true;
+                _newest = seq;
+                _seen = 1;
+                return true;
+            }
+
+            if (distance > 0)
+            {
+                _seen = distance >= SIZE ? 0 : _seen << distance;
+                _seen |= 1;
+                _newest = seq;
+                return true;
+            }
+
+            auto bit = uint64_t{ 1 } << -distance;
+            if (_seen & bit)
+                return false;
+
+            _seen |= bit;
+            return true;
+        }
+
+        void reset()
+        {
+            _any = false;
+        }
+
+    private:
+        uint16_t _newest = 0;
+        uint64_t _seen = 0;
+        bool _any = false;
+    };
+}
@@ -10,6 +10,8 @@
 #include "esp_bt_device.h"
 #include "esp_spp_api.h"
 
+#include "link_capture.hpp"
+
 namespace transport
 {
     struct bt_uart_transport_t
@@ -95,6 +97,7 @@ namespace transport
                     esp_bt_gap_set_scan_mode(ESP_BT_CONNECTABLE, ESP_BT_GENERAL_DISCOVERABLE);
                     break;
                 case ESP_SPP_DATA_IND_EVT:
+                    link_capture_t::record(std::span(param->data_ind.data, param->data_ind.len));
                     if (_on_receive) _on_receive(std::span(param->data_ind.data, param->data_ind.len));
                     break;
                 case ESP_SPP_WRITE_EVT:
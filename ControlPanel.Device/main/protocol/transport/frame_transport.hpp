@@ -12,4 +12,13 @@ namespace transport
         { t.write(std::span<uint8_t>()) } -> std::same_as<void>;
         { t.on_receive(std::function<void(std::span<uint8_t>)>()) } -> std::same_as<void>;
     };
-}
\ No newline at end of file
+
+    // Transports that buffer received bytes in a buffer of fixed size, with nothing telling the sender to slow down
+    // when the reader falls behind. A full buffer loses what it holds, the connection hands out credit to avoid it.
+    template<typename T>
+    concept rx_buffered_transport_t = requires(const T t)
+    {
+        { t.rx_buffer_size() } -> std::convertible_to<std::size_t>;  // 0 when it is not bounded after all
+        { t.rx_overflows() } -> std::convertible_to<uint32_t>;
+    };
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <span>
+
+#include "sdkconfig.h"
+
+#ifdef CONFIG_CP_LINK_CAPTURE
+
+#include <array>
+#include <cstring>
+#include <inttypes.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/ringbuf.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+
+#include "protocol/link_capture_format.hpp"
+
+namespace transport
+{
+    // Records every chunk the transports receive, with timestamps, into a data partition so the traffic
+    // can be replayed on the host (see host/tools/link_replay.cpp). The receive context only copies the
+    // chunk into a ring buffer, a low priority task does the flash writes. Capturing stops once the
+    // partition is full.
+    class link_capture_t
+    {
+        static constexpr char TAG[] = "CAPTURE";
+
+    public:
+        static void init()
+        {
+            _partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, CONFIG_CP_LINK_CAPTURE_PARTITION);
+            if (!_partition)
+            {
+                ESP_LOGE(TAG, "partition '%s' not found", CONFIG_CP_LINK_CAPTURE_PARTITION);
+                return;
+            }
+
+            ESP_ERROR_CHECK(esp_partition_erase_range(_partition, 0, _partition->size));
+
+            std::array<uint8_t, link_capture::HEADER_SIZE> header;
+            _offset = link_capture::write_header(header);
+            ESP_ERROR_CHECK(esp_partition_write(_partition, 0, header.data(), header.size()));
+
+            _last_us = esp_timer_get_time();
+            _ring = xRingbufferCreate(CONFIG_CP_LINK_CAPTURE_RING_SIZE, RINGBUF_TYPE_NOSPLIT);
+            configASSERT(_ring);
+
+            xTaskCreate(writer_task, "link_capture", 3072, nullptr, tskIDLE_PRIORITY + 1, nullptr);
+
+            ESP_LOGI(TAG, "capturing to '%s' sz=%" PRIu32, CONFIG_CP_LINK_CAPTURE_PARTITION, _partition->size);
+        }
+
+        static void record(std::span<const uint8_t> chunk)
+        {
+            if (!_ring || chunk.empty())
+                return;
+
+            int64_t timestamp_us = esp_timer_get_time();
+
+            void* item = nullptr;
+            if (xRingbufferSendAcquire(_ring, &item, sizeof(timestamp_us) + chunk.size(), 0) != pdTRUE)
+            {
+                _dropped++;
+                return;
+            }
+
+            std::memcpy(item, &timestamp_us, sizeof(timestamp_us));
+            std::memcpy(static_cast<uint8_t*>(item) + sizeof(timestamp_us), chunk.data(), chunk.size());
+            xRingbufferSendComplete(_ring, item);
+        }
+
+        static uint32_t dropped()
+        {
+            return _dropped;
+        }
+
+    private:
+        static void writer_task(void*)
+        {
+            std::array<uint8_t, link_capture::MAX_RECORD_HEADER_SIZE> record_header;
+
+            while (true)
+            {
+                size_t size = 0;
+                auto item = static_cast<uint8_t*>(xRingbufferReceive(_ring, &size, portMAX_DELAY));
+                if (!item)
+                    continue;
+
+                int64_t timestamp_us;
+                std::memcpy(&timestamp_us, item, sizeof(timestamp_us));
+                std::span<const uint8_t> data{item + sizeof(timestamp_us), size - sizeof(timestamp_us)};
+
+                auto n = link_capture::write_record_header(record_header, link_capture::record_tag_t::rx_chunk, timestamp_us - _last_us, data.size());
+
+                // the last byte stays erased and terminates the capture
+                if (_offset + n + data.size() < _partition->size)
+                {
+                    esp_partition_write(_partition, _offset, record_header.data(), n);
+                    esp_partition_write(_partition, _offset + n, data.data(), data.size());
+                    _offset += n + data.size();
+                    _last_us = timestamp_us;
+                }
+                else if (!_full)
+                {
+                    _full = true;
+                    ESP_LOGW(TAG, "partition full, capture stopped at %" PRIu32 " bytes, dropped=%" PRIu32, _offset, _dropped);
+                }
+
+                vRingbufferReturnItem(_ring, item);
+            }
+        }
+
+    private:
+        inline static const esp_partition_t* _partition = nullptr;
+        inline static RingbufHandle_t _ring = nullptr;
+        inline static uint32_t _offset = 0;
+        inline static int64_t _last_us = 0;
+        inline static uint32_t _dropped = 0;
+        inline static bool _full = false;
+    };
+}
+
+#else
+
+namespace transport
+{
+    struct link_capture_t
+    {
+        static void init() {}
+        static void record(std::span<const uint8_t>) {}
+        static uint32_t dropped() { return 0; }
+    };
+}
+
+#endif
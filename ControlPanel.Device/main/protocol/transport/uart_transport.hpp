@@ -1,8 +1,11 @@
 #pragma once
 
+#include <inttypes.h>
+
 #include "driver/uart.h"
 
 #include "utils/esp_utility.hpp"
+#include "link_capture.hpp"
 
 namespace transport
 {
@@ -11,7 +14,7 @@ namespace transport
         static constexpr char TAG[] = "UART";
 
         uart_transport_t(uart_port_t port, gpio_num_t tx, gpio_num_t rx, int buffer_size, int baud_rate)
-            : _port(port)
+            : _port(port), _rx_buffer_size(buffer_size / 2)
         {
             const uart_config_t cfg = {
                 .baud_rate  = baud_rate,
@@ -24,7 +27,7 @@ namespace transport
 
             uart_param_config(_port, &cfg);
             uart_set_pin(_port, tx, rx, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
-            uart_driver_install(_port, buffer_size / 2, buffer_size / 2, 20, &_uart_rx_queue, ESP_INTR_FLAG_IRAM);
+            uart_driver_install(_port, _rx_buffer_size, buffer_size / 2, 20, &_uart_rx_queue, ESP_INTR_FLAG_IRAM);
         }
 
         void init()
@@ -43,6 +46,18 @@ namespace transport
             _on_receive = std::forward<F>(f);
         }
 
+        // Without hardware flow control the driver's ring buffer is all the slack a slow reader has.
+        std::size_t rx_buffer_size() const
+        {
+            return _rx_buffer_size;
+        }
+
+        // Times the fifo or the ring buffer overflowed and the input was flushed.
+        uint32_t rx_overflows() const
+        {
+            return _rx_overflows;
+        }
+
     private:
         void uart_event_task()
         {
@@ -63,6 +78,7 @@ namespace transport
                         if (read <= 0)
                             break;
 
+                        link_capture_t::record(std::span(buffer.data(), read));
                         if (_on_receive) _on_receive(std::span(buffer.data(), read));
                     }
                     break;
@@ -70,7 +86,9 @@ namespace transport
 
                 case UART_FIFO_OVF:
                 case UART_BUFFER_FULL:
-                    ESP_LOGW(TAG, "%s", "overflow");
+                    // partial frames are lost with the rest of the input, the sender retransmits them
+                    _rx_overflows++;
+                    ESP_LOGW(TAG, "%s count=%" PRIu32, event.type == UART_FIFO_OVF ? "fifo overflow" : "buffer full", _rx_overflows);
                     uart_flush_input(_port);
                     xQueueReset(_uart_rx_queue);
                     break;
@@ -88,6 +106,8 @@ namespace transport
 
     private:
         uart_port_t _port;
+        std::size_t _rx_buffer_size;
+        uint32_t _rx_overflows = 0;
         QueueHandle_t _uart_rx_queue;
         std::function<void(std::span<uint8_t>)> _on_receive{};
     };
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <stdint.h>
+#include <array>
+#include <bit>
 #include <cstring>
 #include <span>
+#include <utility>
 
 namespace transport
 {
@@ -11,7 +14,7 @@ namespace transport
         if (span.size() < seq.size())
             return -1;
 
-        for (auto i = 0; i <= span.size() - seq.size(); i++)
+        for (std::size_t i = 0; i <= span.size() - seq.size(); i++)
         {
             if (span[i] != seq[0])
                 continue;
@@ -22,4 +25,62 @@ namespace transport
 
         return -1;
     }
-}
\ No newline at end of file
+
+    // find_sequence for a sequence known at compile time. Compares a machine word of candidate positions at once:
+    // every byte of Magic is xor'ed against the input shifted by its offset, and a lane that is zero in all of them
+    // is a match. Each input word is loaded once, so the scan is linear whatever the input looks like.
+    template<std::array Magic>
+    std::ptrdiff_t find_magic(std::span<const uint8_t> span)
+    {
+        using word_t = std::size_t;
+
+        constexpr std::size_t W = sizeof(word_t);
+        constexpr std::size_t M = Magic.size();
+        constexpr word_t ONES = ~word_t{0} / 0xFF;
+        constexpr word_t HIGHS = ONES << 7;
+
+        static_assert(M > 0 && M <= W);
+
+        const auto data = span.data();
+        const auto size = span.size();
+        std::size_t i = 0;
+
+        if constexpr (std::endian::native == std::endian::little)
+        {
+            auto load = [&](std::size_t at)
+            {
+                word_t w;
+                std::memcpy(&w, data + at, W);
+                return w;
+            };
+
+            if (size >= 2 * W)
+            {
+                auto next = load(0);
+                for (; i + 2 * W <= size; i += W)
+                {
+                    auto w = next;
+                    next = load(i + W);
+
+                    word_t diff = w ^ (ONES * Magic[0]);
+                    [&]<std::size_t... K>(std::index_sequence<K...>)
+                    {
+                        ((diff |= ((w >> (8 * (K + 1))) | (next << (8 * (W - K - 1)))) ^ (ONES * Magic[K + 1])), ...);
+                    }(std::make_index_sequence<M - 1>{});
+
+                    // lanes above a zero lane can be false positives, the lowest one is exact
+                    if (auto zero = (diff - ONES) & ~diff & HIGHS)
+                        return i + std::countr_zero(zero) / 8;
+                }
+            }
+        }
+
+        for (; i + M <= size; i++)
+        {
+            if (data[i] == Magic[0] && std::memcmp(data + i, Magic.data(), M) == 0)
+                return i;
+        }
+
+        return -1;
+    }
+}
@@ -28,7 +28,10 @@ class uart_log_proto_forwarder
 public:
     static void init(auto& fp)
     {
-        _send = [&](auto d) { fp.send(d, 100, 1); };
+        _send = [&](const log_message_t& msg)
+        {
+            fp.send_with([&](std::span<uint8_t> out) { return serialize_bridge_message(msg, out); }, 100, 1, transport::channel_t::diagnostics);
+        };
         _queue = xQueueCreateStatic(LOG_QUEUE_LEN, sizeof(log_line_t), _storage, &_static_queue);
 
         xTaskCreate(log_forward_task, "log_fwd", 4096, nullptr, tskIDLE_PRIORITY + 1, &_log_task);
@@ -115,8 +118,7 @@ private:
                 //auto send_ll = scoped_log_disable(uart_t::SEND_TAG);
                 //auto sz_ll = scoped_log_disable(uart_t::SEND_TAG);
 
-                auto bytes = serialize_bridge_message(msg);
-                _send(bytes);
+                _send(msg);
             }
         }
     }
@@ -127,5 +129,5 @@ private:
     inline static QueueHandle_t _queue = nullptr;
     inline static volatile bool _in_hook = 0;
     inline static TaskHandle_t _log_task = nullptr;
-    inline static std::function<void(std::span<uint8_t>)> _send;
+    inline static std::function<void(const log_message_t&)> _send;
 };
\ No newline at end of file
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <mutex>
 #include <set>
 
 #include "lvgl.h"
+#include "utils/lv_sync.hpp"
 
 class flex_list_t
 {
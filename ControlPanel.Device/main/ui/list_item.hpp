@@ -1,9 +1,15 @@
 #pragma once
 
+#include <cstring>
 #include <string>
 #include <functional>
+#include <mutex>
+#include <span>
+
+#include "freertos/FreeRTOS.h"
 
 #include "ui/style.hpp"
+#include "utils/lv_sync.hpp"
 
 #include "lvgl.h"
 
@@ -86,6 +92,7 @@ public:
         if (_slider_editing)
             return;
 
+        _reported_volume = value;
         lv_slider_set_value(_slider, value, LV_ANIM_OFF);
         lv_label_set_text(_slider_label, std::to_string(value).c_str());
     }
@@ -155,9 +162,15 @@ private:
         switch (code)
         {
             case LV_EVENT_PRESSED:
+            {
+                that->_slider_editing = true;
+                break;
+            }
             case LV_EVENT_PRESSING:
             {
+                // streamed while dragging, the receiver of the callback keeps only the latest value it could not send yet
                 that->_slider_editing = true;
+                that->report_volume(lv_slider_get_value(slider));
                 break;
             }
             case LV_EVENT_RELEASED:
@@ -168,9 +181,7 @@ private:
                 if (that->_mute && that->_on_mute_changed)
                     that->_on_mute_changed(false);
 
-                if (that->_on_volume_changed)
-                    that->_on_volume_changed(static_cast<uint8_t>(value));
-                    
+                that->report_volume(value);
                 break;
             }
             default:
@@ -178,6 +189,16 @@ private:
         }
     }
 
+    void report_volume(int32_t value)
+    {
+        if (value == _reported_volume)
+            return;
+
+        _reported_volume = value;
+        if (_on_volume_changed)
+            _on_volume_changed(static_cast<uint8_t>(value));
+    }
+
     static lv_obj_t* create_title_viewport(lv_obj_t* parent)
     {
         auto viewport = lv_obj_create(parent);
@@ -216,7 +237,7 @@ private:
                     .w = w,
                     .h = h
                 },
-                .data_size = img_data.size(),
+                .data_size = static_cast<uint32_t>(img_data.size()),
                 .data = data
             };
 
@@ -255,6 +276,7 @@ private:
 
     bool _mute;
     bool _slider_editing;
+    int32_t _reported_volume = -1;  // last sent or set from the PC, a press that does not move the knob sends nothing
     std::function<void(uint8_t)> _on_volume_changed;
     std::function<void(bool)> _on_mute_changed;
 };
\ No newline at end of file
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <mutex>
+
 #include "lvgl.h"
+#include "utils/lv_sync.hpp"
 
 consteval lv_color_t color_hex(uint32_t c)
 {
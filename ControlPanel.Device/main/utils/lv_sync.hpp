@@ -3,6 +3,8 @@
 
 #include <mutex>
 
+#include "lvgl.h"
+
 struct lv_lock_t {
 #if LV_USE_OS != LV_OS_NONE
     void lock() { lv_lock(); }